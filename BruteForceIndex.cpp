@@ -0,0 +1,106 @@
+#include "BruteForceIndex.h"
+#include "EuclideanVectorKernels.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace evec;
+
+namespace {
+    // Number of queries that go through a tile of indexed vectors together
+    const std::size_t queryTile = 8u;
+
+    // Bytes of indexed vectors per tile, about the size of a per-core L2 cache
+    const std::size_t tileBytes = 256u * 1024u;
+
+    // Fewest indexed vectors a thread scans when a single query is split across threads
+    const std::size_t scanGrain = 4096u;
+}
+
+/***************************************  Constructors and destructors  ***********************************************/
+
+// Constructor that copies the vectors to search
+BruteForceIndex::BruteForceIndex(const EuclideanVectorBatch& v):
+        vectors{v.getLayout() == EuclideanVectorBatch::Layout::RowMajor ? v : v.toLayout(EuclideanVectorBatch::Layout::RowMajor)},
+        squaredNorms(v.size()) {
+    for (std::size_t i = 0u; i < size(); ++i)
+        squaredNorms[i] = kernels::sumOfSquares(vectors.data() + i * getNumDimensions(), getNumDimensions());
+}
+
+/***********************************************  Member Functions  ***************************************************/
+
+// Return the k indexed vectors nearest to the query
+std::vector<Neighbor> BruteForceIndex::search(ConstEuclideanVectorView query, std::size_t k) const {
+    assert(query.getNumDimensions() == getNumDimensions());
+    return std::move(searchRows(query.data(), 1u, k).front());
+}
+
+// Return the k nearest neighbours of every query
+std::vector<std::vector<Neighbor>> BruteForceIndex::search(const EuclideanVectorBatch& queries, std::size_t k) const {
+    assert(queries.getNumDimensions() == getNumDimensions());
+    if (queries.getLayout() == EuclideanVectorBatch::Layout::RowMajor)
+        return searchRows(queries.data(), queries.size(), k);
+    EuclideanVectorBatch rows = queries.toLayout(EuclideanVectorBatch::Layout::RowMajor);
+    return searchRows(rows.data(), rows.size(), k);
+}
+
+// Return the k nearest neighbours of count row-major queries
+std::vector<std::vector<Neighbor>> BruteForceIndex::searchRows(const double* queries, std::size_t count, std::size_t k) const {
+    const unsigned dimension = getNumDimensions();
+    std::vector<double> queryNorms(count);
+    for (std::size_t q = 0u; q < count; ++q)
+        queryNorms[q] = kernels::sumOfSquares(queries + q * dimension, dimension);
+
+    std::vector<TopK> heaps(count, TopK{k});
+    ThreadPool& pool = ThreadPool::instance();
+    if (pool.chunkCount(count, queryTile) > 1u || pool.chunkCount(size(), scanGrain) <= 1u) {
+        // Enough queries to keep every thread busy: each thread takes whole queries
+        pool.parallelFor(count, queryTile, [&] (std::size_t, std::size_t begin, std::size_t end) {
+            for (std::size_t q = begin; q < end; q += queryTile) {
+                std::size_t n = std::min(queryTile, end - q);
+                scan(queries + q * dimension, queryNorms.data() + q, n, 0u, size(), heaps.data() + q);
+            }
+        });
+    } else {
+        // Few queries: each thread scans a slice of the indexed vectors, then the slices are merged
+        std::vector<std::vector<TopK>> partial(pool.chunkCount(size(), scanGrain), heaps);
+        pool.parallelFor(size(), scanGrain, [&] (std::size_t chunk, std::size_t begin, std::size_t end) {
+            for (std::size_t q = 0u; q < count; q += queryTile) {
+                std::size_t n = std::min(queryTile, count - q);
+                scan(queries + q * dimension, queryNorms.data() + q, n, begin, end, partial[chunk].data() + q);
+            }
+        });
+        for (const std::vector<TopK>& p : partial) {
+            for (std::size_t q = 0u; q < count; ++q)
+                heaps[q].merge(p[q]);
+        }
+    }
+
+    std::vector<std::vector<Neighbor>> results(count);
+    for (std::size_t q = 0u; q < count; ++q) {
+        results[q] = heaps[q].sorted();
+        for (Neighbor& n : results[q])
+            n.distance = std::sqrt(n.distance);
+    }
+    return results;
+}
+
+// Push the squared distances between count queries and the vectors in [begin, end) into one heap per query
+void BruteForceIndex::scan(const double* queries, const double* queryNorms, std::size_t count,
+                           std::size_t begin, std::size_t end, TopK* heaps) const {
+    const unsigned dimension = getNumDimensions();
+    const std::size_t tile = std::max<std::size_t>(1u, tileBytes / (std::max(dimension, 1u) * sizeof(double)));
+    for (std::size_t first = begin; first < end; first += tile) {
+        std::size_t last = std::min(first + tile, end);
+        for (std::size_t q = 0u; q < count; ++q) {
+            const double* query = queries + q * dimension;
+            for (std::size_t i = first; i < last; ++i) {
+                // Rounding can make the expansion slightly negative for (near) duplicates
+                double d = queryNorms[q] + squaredNorms[i] - 2.0 * kernels::dot(query, vectors.data() + i * dimension, dimension);
+                heaps[q].push(i, std::max(d, 0.0));
+            }
+        }
+    }
+}
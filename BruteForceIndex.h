@@ -0,0 +1,51 @@
+#ifndef A2_BRUTEFORCEINDEX_H
+#define A2_BRUTEFORCEINDEX_H
+
+#include <cstddef>
+#include <vector>
+
+#include "EuclideanVectorBatch.h"
+#include "EuclideanVectorView.h"
+#include "Neighbor.h"
+
+namespace evec {
+    // Exact k-nearest-neighbour search by comparing the queries with every indexed vector. The
+    // squared distance is computed as ||q||^2 + ||x||^2 - 2 q.x with the squared norms of the
+    // indexed vectors computed once, so each comparison is a single dot product and nothing is
+    // allocated per candidate. Queries and vectors are compared in tiles that keep a block of
+    // vectors in cache while several queries go through it, and the tiles are spread over the
+    // thread pool. This is the baseline the approximate indexes are measured against.
+    class BruteForceIndex {
+    public:
+        // Constructor that copies the vectors to search
+        explicit BruteForceIndex(const EuclideanVectorBatch& vectors);
+
+        // Return the number of indexed vectors
+        std::size_t size() const { return vectors.size(); }
+
+        // Return the number of dimensions of the indexed vectors
+        unsigned getNumDimensions() const { return vectors.getNumDimensions(); }
+
+        // Return the indexed vector with the given id
+        EuclideanVectorBatch::ConstRow operator[](std::size_t id) const { return vectors[id]; }
+
+        // Return the k indexed vectors nearest to the query (fewer if the index is smaller), nearest
+        // first, with their euclidean distances from the query
+        std::vector<Neighbor> search(ConstEuclideanVectorView query, std::size_t k) const;
+
+        // Return the k nearest neighbours of every query
+        std::vector<std::vector<Neighbor>> search(const EuclideanVectorBatch& queries, std::size_t k) const;
+
+    private:
+        EuclideanVectorBatch vectors; // Indexed vectors, row-major
+        std::vector<double> squaredNorms; // Squared norm of every indexed vector
+
+        // Return the k nearest neighbours of count row-major queries
+        std::vector<std::vector<Neighbor>> searchRows(const double* queries, std::size_t count, std::size_t k) const;
+
+        // Push the squared distances between count queries and the vectors in [begin, end) into one heap per query
+        void scan(const double* queries, const double* queryNorms, std::size_t count,
+                  std::size_t begin, std::size_t end, TopK* heaps) const;
+    };
+}
+#endif
@@ -0,0 +1,251 @@
+#include "DatasetReader.h"
+#include "EuclideanVectorFormat.h"
+#include "EuclideanVectorKernels.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+using namespace evec;
+
+constexpr std::size_t DatasetReader::chunkSize;
+constexpr std::size_t DatasetReader::readAheadChunks;
+constexpr std::size_t DatasetReader::maxDimension;
+
+/***************************************  Constructors and destructors  ***********************************************/
+
+// Constructor that takes the path of the file, whose format is given by its extension
+DatasetReader::DatasetReader(const std::string& p, std::size_t n):
+        DatasetReader(p, formatOf(p), n, p.size() >= 4u && p.compare(p.size() - 4u, 4u, ".tsv") == 0 ? '\t' : ',') {}
+
+// Constructor that takes the format explicitly and the delimiter of a text file
+DatasetReader::DatasetReader(const std::string& p, Format f, std::size_t n, char d):
+        path{p}, format{f}, blockSize{std::max<std::size_t>(n, 1u)}, delimiter{d}, file{std::fopen(p.c_str(), "rb")} {
+    if (file == nullptr)
+        throw std::runtime_error{"cannot open " + path + ": " + std::strerror(errno)};
+    reader = std::thread{[this] { readAhead(); }};
+}
+
+// Destructor (stops the background thread)
+DatasetReader::~DatasetReader() noexcept {
+    {
+        std::lock_guard<std::mutex> lock {mutex};
+        stopping = true;
+    }
+    space.notify_one();
+    reader.join();
+    std::fclose(file);
+}
+
+/***********************************************  Member Functions  ***************************************************/
+
+// Return the format given by the extension of path
+DatasetReader::Format DatasetReader::formatOf(const std::string& path) {
+    std::string extension = path.substr(std::min(path.rfind('.'), path.size()));
+    if (extension == ".fvecs")
+        return Format::Fvecs;
+    if (extension == ".bvecs")
+        return Format::Bvecs;
+    if (extension == ".ivecs")
+        return Format::Ivecs;
+    if (extension == ".csv" || extension == ".tsv")
+        return Format::Csv;
+    throw std::runtime_error{"unknown dataset format " + path};
+}
+
+// Replace block with the next vectors of the file
+bool DatasetReader::next(EuclideanVectorBatch& block) {
+    magnitudes.clear();
+    std::size_t rows = 0u;
+    while (rows < blockSize) {
+        if (parseRecord()) {
+            ++rows;
+        } else if (exhausted) {
+            break;
+        } else {
+            exhausted = !fill();
+        }
+    }
+    if (rows == 0u)
+        return false;
+
+    block = EuclideanVectorBatch{rows, dimension};
+    std::copy(magnitudes.cbegin(), magnitudes.cend(), block.data());
+    count += rows;
+    return true;
+}
+
+// Replace v with the next vector of the file
+bool DatasetReader::next(EuclideanVector& v) {
+    if (currentRow == current.size()) {
+        if (!next(current))
+            return false;
+        currentRow = 0u;
+    }
+    v = current[currentRow++];
+    return true;
+}
+
+// Loop run by the background thread
+void DatasetReader::readAhead() {
+    while (true) {
+        Chunk chunk;
+        {
+            std::unique_lock<std::mutex> lock {mutex};
+            space.wait(lock, [this] { return stopping || chunks.size() < readAheadChunks; });
+            if (stopping)
+                return;
+            if (!spare.empty()) {
+                chunk = std::move(spare.back());
+                spare.pop_back();
+            }
+        }
+
+        // Read without holding the lock so the parser keeps going meanwhile
+        if (chunk.bytes == nullptr)
+            chunk.bytes.reset(new char[chunkSize]);
+        chunk.size = std::fread(chunk.bytes.get(), 1u, chunkSize, file);
+        bool atEnd = chunk.size < chunkSize;
+        bool failed = atEnd && std::ferror(file);
+        int readError = errno;
+
+        {
+            std::lock_guard<std::mutex> lock {mutex};
+            if (chunk.size != 0u)
+                chunks.push_back(std::move(chunk));
+            if (failed)
+                error = "cannot read " + path + ": " + std::strerror(readError);
+            finished = atEnd;
+        }
+        ready.notify_one();
+        if (atEnd)
+            return;
+    }
+}
+
+// Move the next chunk into pending
+bool DatasetReader::fill() {
+    Chunk chunk;
+    {
+        std::unique_lock<std::mutex> lock {mutex};
+        ready.wait(lock, [this] { return !chunks.empty() || finished; });
+        if (chunks.empty()) {
+            if (!error.empty())
+                throw std::runtime_error{error};
+            return false;
+        }
+        chunk = std::move(chunks.front());
+        chunks.pop_front();
+    }
+    space.notify_one();
+
+    // Drop the parsed bytes, then append the chunk after the unparsed ones
+    pending.erase(pending.begin(), pending.begin() + consumed);
+    consumed = 0u;
+    pending.insert(pending.end(), chunk.bytes.get(), chunk.bytes.get() + chunk.size);
+
+    {
+        std::lock_guard<std::mutex> lock {mutex};
+        spare.push_back(std::move(chunk));
+    }
+    return true;
+}
+
+// Parse the next vector in pending into magnitudes
+bool DatasetReader::parseRecord() {
+    switch (format) {
+        case Format::Fvecs:
+            return parseBinaryRecord(sizeof(float));
+        case Format::Bvecs:
+            return parseBinaryRecord(sizeof(std::uint8_t));
+        case Format::Ivecs:
+            return parseBinaryRecord(sizeof(std::int32_t));
+        case Format::Csv:
+            return parseTextRecord();
+    }
+    return false;
+}
+
+// Parse the next binary vector whose magnitudes are elementSize bytes each
+bool DatasetReader::parseBinaryRecord(std::size_t elementSize) {
+    const char* first = pending.data() + consumed;
+    std::size_t available = pending.size() - consumed;
+    auto truncated = [this] {
+        return std::runtime_error{path + " is truncated after " + std::to_string(recordsParsed()) + " vectors"};
+    };
+    std::int32_t n = 0;
+    if (available < sizeof n) {
+        if (exhausted && available != 0u)
+            throw truncated();
+        return false;
+    }
+
+    // Check the dimension before waiting for the magnitudes, so a corrupt header is reported
+    // at once instead of making pending buffer the rest of the file. Later vectors must match
+    // the first one, which must not exceed maxDimension.
+    std::memcpy(&n, first, sizeof n);
+    if (n <= 0 || (dimension == 0u && static_cast<std::size_t>(n) > maxDimension))
+        throw std::runtime_error{path + ": vector " + std::to_string(recordsParsed()) + " has dimension " + std::to_string(n)};
+    checkDimension(static_cast<std::size_t>(n));
+    if (available < sizeof n + dimension * elementSize) {
+        if (exhausted)
+            throw truncated();
+        return false;
+    }
+
+    const char* source = first + sizeof n;
+    std::size_t offset = magnitudes.size();
+    magnitudes.resize(offset + dimension);
+    double* destination = magnitudes.data() + offset;
+    if (format == Format::Fvecs) {
+        floats.resize(dimension);
+        std::memcpy(floats.data(), source, dimension * sizeof(float));
+        kernels::widen(floats.data(), destination, dimension);
+    } else if (format == Format::Ivecs) {
+        ints.resize(dimension);
+        std::memcpy(ints.data(), source, dimension * sizeof(int));
+        kernels::widen(ints.data(), destination, dimension);
+    } else {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(source);
+        std::copy(bytes, bytes + dimension, destination);
+    }
+    consumed += sizeof n + dimension * elementSize;
+    return true;
+}
+
+// Parse the next non-blank line
+bool DatasetReader::parseTextRecord() {
+    while (consumed != pending.size()) {
+        const char* first = pending.data() + consumed;
+        const char* last = pending.data() + pending.size();
+        const char* newline = std::find(first, last, '\n');
+        if (newline == last && !exhausted)
+            return false;
+
+        ++lineNumber;
+        consumed = static_cast<std::size_t>(newline - pending.data()) + (newline == last ? 0u : 1u);
+        std::size_t fields = parseDelimitedLine(first, newline, delimiter, lineNumber, magnitudes);
+        if (fields != 0u) {
+            checkDimension(fields);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Check the dimension of the vector just parsed against the first one
+void DatasetReader::checkDimension(std::size_t n) {
+    if (dimension == 0u) {
+        dimension = static_cast<unsigned>(n);
+    } else if (n != dimension) {
+        std::string where = format == Format::Csv ? "line " + std::to_string(lineNumber) : "vector " + std::to_string(recordsParsed());
+        throw std::runtime_error{path + ": " + where + " has dimension " + std::to_string(n) + ", expected " + std::to_string(dimension)};
+    }
+}
+
+// Return the number of vectors parsed so far, including those of the block being parsed
+std::size_t DatasetReader::recordsParsed() const {
+    return count + (dimension == 0u ? 0u : magnitudes.size() / dimension);
+}
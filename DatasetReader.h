@@ -0,0 +1,133 @@
+#ifndef A2_DATASETREADER_H
+#define A2_DATASETREADER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EuclideanVector.h"
+#include "EuclideanVectorBatch.h"
+
+namespace evec {
+    // Streams the vectors of a dataset file in blocks, using bounded memory whatever the size of
+    // the file. A background thread reads the file ahead in chunks while the calling thread parses
+    // the chunks it has already received, so parsing overlaps with I/O.
+    //
+    // Supported formats are the TEXMEX formats used by the standard ANN benchmarks, where every
+    // vector is a little-endian 32-bit dimension followed by that many floats (.fvecs), unsigned
+    // bytes (.bvecs) or 32-bit ints (.ivecs), and delimited text with one vector per line (.csv, .tsv).
+    // All vectors of a file must have the same dimension.
+    class DatasetReader {
+    public:
+        enum class Format { Fvecs, Bvecs, Ivecs, Csv };
+
+        // Size of the chunks the background thread reads
+        static constexpr std::size_t chunkSize = 1u << 20;
+
+        // Number of chunks the background thread reads ahead of the parser
+        static constexpr std::size_t readAheadChunks = 4u;
+
+        // Largest dimension accepted in a binary file. Dimensions are checked as soon as a vector's
+        // header arrives, so a corrupt header never makes the reader buffer more than one vector
+        // of this size (4 MiB of .fvecs or .ivecs magnitudes) waiting for its magnitudes.
+        static constexpr std::size_t maxDimension = 1u << 20;
+
+        // Constructor that takes the path of the file, whose format is given by its extension, and
+        // the most vectors returned per block. Throws std::runtime_error if the file cannot be opened
+        // or the extension is unknown.
+        explicit DatasetReader(const std::string& path, std::size_t blockSize = 4096u);
+
+        // Constructor that takes the format explicitly and the delimiter of a text file
+        DatasetReader(const std::string& path, Format, std::size_t blockSize = 4096u, char delimiter = ',');
+
+        DatasetReader(const DatasetReader&) = delete;
+        DatasetReader& operator=(const DatasetReader&) = delete;
+
+        // Destructor (stops the background thread)
+        ~DatasetReader() noexcept;
+
+        // Replace block with the next vectors of the file, at most blockSize of them, in a row-major
+        // batch. Return false once the whole file has been read. Throws std::runtime_error if the
+        // file is malformed (including a binary vector of more than maxDimension dimensions),
+        // truncated or cannot be read.
+        bool next(EuclideanVectorBatch& block);
+
+        // Replace v with the next vector of the file and return false once the whole file has been read.
+        // Vectors are still parsed a block at a time, so do not mix the two overloads of next on one reader.
+        bool next(EuclideanVector& v);
+
+        // Return the number of dimensions of the vectors, zero until the first vector has been read
+        unsigned getNumDimensions() const { return dimension; }
+
+        // Return the number of vectors returned so far
+        std::size_t vectorsRead() const { return count; }
+
+        // Return the format given by the extension of path. Throws std::runtime_error if it is unknown.
+        static Format formatOf(const std::string& path);
+
+    private:
+        // Bytes read by the background thread
+        struct Chunk {
+            std::unique_ptr<char[]> bytes;
+            std::size_t size;
+        };
+
+        std::string path;
+        Format format;
+        std::size_t blockSize; // Most vectors returned per block
+        char delimiter; // Field separator of text files
+        std::FILE* file;
+
+        // State shared with the background thread
+        std::mutex mutex; // Guards everything down to error
+        std::condition_variable ready; // Signalled when a chunk is queued or the end of the file is reached
+        std::condition_variable space; // Signalled when a chunk is taken or the reader stops
+        std::deque<Chunk> chunks; // Chunks read but not parsed yet, in file order
+        std::vector<Chunk> spare; // Parsed chunks whose storage the background thread reuses
+        bool finished = false; // The background thread reached the end of the file
+        bool stopping = false; // The destructor asked the background thread to stop
+        std::string error; // Description of a read error, reported once the chunks before it are parsed
+        std::thread reader;
+
+        // State of the parser, used only by the calling thread
+        std::vector<char> pending; // Bytes received but not parsed yet
+        std::size_t consumed = 0u; // Bytes at the start of pending that were parsed already
+        bool exhausted = false; // pending holds the last bytes of the file
+        std::size_t lineNumber = 0u; // Lines parsed so far (text files)
+        unsigned dimension = 0u; // Dimension of every vector, zero until the first one is parsed
+        std::size_t count = 0u; // Vectors returned so far
+        std::vector<double> magnitudes; // Magnitudes of the block being parsed
+        std::vector<float> floats; // Aligned copy of the magnitudes of one .fvecs record
+        std::vector<int> ints; // Aligned copy of the magnitudes of one .ivecs record
+        EuclideanVectorBatch current {0u, 0u}; // Block the vectors returned one at a time come from
+        std::size_t currentRow = 0u; // Next row of current to return
+
+        // Loop run by the background thread
+        void readAhead();
+
+        // Move the next chunk into pending, return false if the whole file is in pending already
+        bool fill();
+
+        // Parse the next vector in pending into magnitudes, return false if pending ends before it does
+        bool parseRecord();
+
+        // Parse the next binary vector whose magnitudes are elementSize bytes each
+        bool parseBinaryRecord(std::size_t elementSize);
+
+        // Parse the next non-blank line
+        bool parseTextRecord();
+
+        // Check the dimension of the vector just parsed against the first one
+        void checkDimension(std::size_t);
+
+        // Return the number of vectors parsed so far, including those of the block being parsed
+        std::size_t recordsParsed() const;
+    };
+}
+#endif
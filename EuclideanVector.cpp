@@ -1,174 +1,395 @@
 #include "EuclideanVector.h"
+#include "EuclideanVectorKernels.h"
+
+#include <cctype>
+#include <new>
+#include <string>
 
 using namespace evec;
 
-/***************************************  Constructors and destructors  ***********************************************/
+namespace {
+    // Element-wise kernels for each storage type. Doubles and floats go straight to the SIMD
+    // kernels, 16-bit magnitudes are converted to float a block at a time and accumulate in float.
+    const std::size_t conversionBlock = 256u;
+
+    // dst[i] = op(dst[i], src[i]) on 16-bit magnitudes, op working on float blocks
+    template <typename H, typename Op>
+    void combineConverted(H* dst, const H* src, std::size_t n, Op op) {
+        float x[conversionBlock], y[conversionBlock];
+        for (std::size_t i = 0u; i < n; i += conversionBlock) {
+            std::size_t m = std::min(conversionBlock, n - i);
+            kernels::convert(dst + i, x, m);
+            kernels::convert(src + i, y, m);
+            op(x, y, m);
+            kernels::convert(x, dst + i, m);
+        }
+    }
 
-// Default constructor
-EuclideanVector::EuclideanVector(): EuclideanVector(1u) {}
+    void addMagnitudes(double* dst, const double* src, std::size_t n) { kernels::add(dst, src, n); }
+    void addMagnitudes(float* dst, const float* src, std::size_t n) { kernels::add(dst, src, n); }
 
-// Constructor that takes the number of dimensions but no magnitudes
-EuclideanVector::EuclideanVector(unsigned n): EuclideanVector(n, 0.0) {}
+    template <typename H>
+    void addMagnitudes(H* dst, const H* src, std::size_t n) {
+        combineConverted(dst, src, n, [] (float* x, const float* y, std::size_t m) { kernels::add(x, y, m); });
+    }
 
-// Constructor that takes the number of dimensions and initialises the magnitude in each dimension as the second argument
-EuclideanVector::EuclideanVector(unsigned n, double m):
-        numberOfDimension{n}, magnitudes{new double[n]} { std::fill(begin(), end(), m); }
+    void subtractMagnitudes(double* dst, const double* src, std::size_t n) { kernels::subtract(dst, src, n); }
+    void subtractMagnitudes(float* dst, const float* src, std::size_t n) { kernels::subtract(dst, src, n); }
 
-// Constructor that takes iterators from a vector
-EuclideanVector::EuclideanVector(std::vector<double>::iterator beg, std::vector<double>::iterator end): 
-numberOfDimension{static_cast<unsigned>(std::distance(beg, end))}, magnitudes{new double[numberOfDimension]} {
-    std::copy(beg, end, begin());
-}
+    template <typename H>
+    void subtractMagnitudes(H* dst, const H* src, std::size_t n) {
+        combineConverted(dst, src, n, [] (float* x, const float* y, std::size_t m) { kernels::subtract(x, y, m); });
+    }
+
+    void scaleMagnitudes(double* dst, double k, std::size_t n) { kernels::scale(dst, k, n); }
+    void scaleMagnitudes(float* dst, double k, std::size_t n) { kernels::scale(dst, static_cast<float>(k), n); }
+
+    template <typename H>
+    void scaleMagnitudes(H* dst, double k, std::size_t n) {
+        float x[conversionBlock];
+        for (std::size_t i = 0u; i < n; i += conversionBlock) {
+            std::size_t m = std::min(conversionBlock, n - i);
+            kernels::convert(dst + i, x, m);
+            kernels::scale(x, static_cast<float>(k), m);
+            kernels::convert(x, dst + i, m);
+        }
+    }
+
+    // Reductions over doubles are split across the thread pool when long, the other types accumulate in float
+    double sumOfSquaresOf(const double* a, std::size_t n) { return kernels::parallelSumOfSquares(a, n); }
+
+    template <typename T>
+    double sumOfSquaresOf(const T* a, std::size_t n) { return kernels::sumOfSquares(a, n); }
+
+    double dotOf(const double* a, const double* b, std::size_t n) { return kernels::parallelDot(a, b, n); }
+
+    template <typename T>
+    double dotOf(const T* a, const T* b, std::size_t n) { return kernels::dot(a, b, n); }
+
+    kernels::DotAndNorms dotAndNormsOf(const double* a, const double* b, std::size_t n) {
+        return kernels::parallelDotAndNorms(a, b, n);
+    }
 
-// Constructor that takes iterators from a list
-EuclideanVector::EuclideanVector(std::list<double>::iterator beg, std::list<double>::iterator end): 
-numberOfDimension{static_cast<unsigned>(std::distance(beg, end))}, magnitudes{new double[numberOfDimension]} {
-    std::copy(beg, end, begin());
+    template <typename T>
+    kernels::DotAndNorms dotAndNormsOf(const T* a, const T* b, std::size_t n) {
+        return kernels::DotAndNorms {dotOf(a, b, n), sumOfSquaresOf(a, n), sumOfSquaresOf(b, n)};
+    }
 }
 
+/***************************************  Constructors and destructors  ***********************************************/
+
+// Default constructor
+template <typename T>
+BasicEuclideanVector<T>::BasicEuclideanVector(): BasicEuclideanVector(1u) {}
+
+// Constructor that takes the number of dimensions but no magnitudes
+template <typename T>
+BasicEuclideanVector<T>::BasicEuclideanVector(unsigned n): BasicEuclideanVector(n, 0.0) {}
+
+// Constructor that takes the number of dimensions and initialises the magnitude in each dimension as the second argument
+template <typename T>
+BasicEuclideanVector<T>::BasicEuclideanVector(unsigned n, double m, MemoryResource* r):
+        numberOfDimension{n}, resource{r}, magnitudes{allocate(n)} { std::fill(begin(), end(), static_cast<T>(m)); }
 
 // Constructor that takes a initialiser list of doubles
-EuclideanVector::EuclideanVector(std::initializer_list<double> list): 
-numberOfDimension{static_cast<unsigned>(std::distance(list.begin(), list.end()))}, magnitudes{new double[numberOfDimension]}{
-    std::copy(list.begin(), list.end(), begin());
+template <typename T>
+BasicEuclideanVector<T>::BasicEuclideanVector(std::initializer_list<double> list, MemoryResource* r): 
+numberOfDimension{static_cast<unsigned>(std::distance(list.begin(), list.end()))}, resource{r}, magnitudes{allocate(numberOfDimension)}{
+    detail::convertMagnitudes(list.begin(), magnitudes, numberOfDimension);
 }
 
 // Copy Constructor
-EuclideanVector::EuclideanVector(const EuclideanVector& other): numberOfDimension{other.getNumDimensions()}, magnitudes{new double[other.getNumDimensions()]} { 
-            std::copy(other.cbegin(), other.cend(), begin()); 
-        }
+template <typename T>
+BasicEuclideanVector<T>::BasicEuclideanVector(const BasicEuclideanVector<T>& other): BasicEuclideanVector(other, getDefaultResource()) {}
+
+// Copy Constructor that takes the resource the copy allocates from
+template <typename T>
+BasicEuclideanVector<T>::BasicEuclideanVector(const BasicEuclideanVector<T>& other, MemoryResource* r): numberOfDimension{other.getNumDimensions()}, resource{r}, 
+        copyOnWrite{other.copyOnWrite}, euclideanNorm{other.euclideanNorm}, squaredNorm{other.squaredNorm} { 
+    if (other.sharedCount != nullptr && other.resource == resource) {
+        // Copy-on-write: share the magnitudes until one side writes
+        share(other);
+    } else {
+        magnitudes = allocate(numberOfDimension);
+        std::copy(other.cbegin(), other.cend(), begin()); 
+    }
+}
 
 // Move Constructor
-EuclideanVector::EuclideanVector(EuclideanVector&& other): numberOfDimension{other.getNumDimensions()}, magnitudes{other.begin()} {
+template <typename T>
+BasicEuclideanVector<T>::BasicEuclideanVector(BasicEuclideanVector<T>&& other): numberOfDimension{other.getNumDimensions()}, resource{other.resource}, 
+        copyOnWrite{other.copyOnWrite}, euclideanNorm{other.euclideanNorm}, squaredNorm{other.squaredNorm} {
+    if (other.isInline()) {
+        // Inline magnitudes cannot be stolen, so copy them into our own buffer
+        magnitudes = smallBuffer;
+        std::copy(other.cbegin(), other.cend(), begin());
+    } else {
+        magnitudes = other.magnitudes;
+        sharedCount = other.sharedCount;
+    }
     other.numberOfDimension = 0u;
-    other.magnitudes = nullptr;
+    other.sharedCount = nullptr;
+    other.magnitudes = other.smallBuffer;
 }
 
 // Destructor
-EuclideanVector::~EuclideanVector() noexcept { delete[] magnitudes; }
+template <typename T>
+BasicEuclideanVector<T>::~BasicEuclideanVector() noexcept { deallocate(); }
 
 /*******************************************  Overloading operators  **************************************************/
 
 // Copy Assignment
-EuclideanVector& EuclideanVector::operator=(const EuclideanVector& other) {
+template <typename T>
+BasicEuclideanVector<T>& BasicEuclideanVector<T>::operator=(const BasicEuclideanVector<T>& other) {
     if (this != &other) {
-        numberOfDimension = other.getNumDimensions();
-
-        // Deallocate memory before creating a new potentially different size array
-        delete[] magnitudes;
-        magnitudes = new double[other.getNumDimensions()];
-        std::copy(other.cbegin(), other.cend(), begin());
+        if (copyOnWrite && other.sharedCount != nullptr && other.resource == resource) {
+            // Copy-on-write: share the magnitudes until one side writes
+            if (magnitudes != other.magnitudes) {
+                deallocate();
+                numberOfDimension = other.getNumDimensions();
+                share(other);
+            }
+        } else {
+            // Reuse the current storage when the number of dimensions is unchanged and nobody shares it
+            if (numberOfDimension != other.getNumDimensions() || isShared()) {
+                deallocate();
+                magnitudes = allocate(other.getNumDimensions());
+                numberOfDimension = other.getNumDimensions();
+            }
+            std::copy(other.cbegin(), other.cend(), begin());
+        }
+        euclideanNorm = other.euclideanNorm;
+        squaredNorm = other.squaredNorm;
     }
     return *this;
 }
 
 // Move Assignment
-EuclideanVector& EuclideanVector::operator=(EuclideanVector&& other) {
+template <typename T>
+BasicEuclideanVector<T>& BasicEuclideanVector<T>::operator=(BasicEuclideanVector<T>&& other) {
     if (this != &other) {
-        numberOfDimension = other.numberOfDimension;
-        other.numberOfDimension = 0u;
+        // Storage from another resource cannot be stolen, so copy it into our own
+        if (!other.isInline() && other.resource != resource)
+            return *this = static_cast<const BasicEuclideanVector&>(other);
 
         // Deallocate memory
-        delete[] magnitudes;
-        // Make the pointer point to the move_from object (MagnitudesOfEachDimensions)
-        magnitudes = other.magnitudes;
-        // Make the pointer in move_from object point to nullptr which
+        deallocate();
+        numberOfDimension = other.numberOfDimension;
+        euclideanNorm = other.euclideanNorm;
+        squaredNorm = other.squaredNorm;
+
+        if (other.isInline()) {
+            // Inline magnitudes cannot be stolen, so copy them into our own buffer
+            std::copy(other.cbegin(), other.cend(), begin());
+        } else {
+            // Make the pointer point to the move_from object (MagnitudesOfEachDimensions)
+            magnitudes = other.magnitudes;
+            sharedCount = other.sharedCount;
+        }
+
+        // Make the move_from object use its empty inline buffer which
         // ensure the move from object is now in a valid state
-        other.magnitudes = nullptr;
+        other.numberOfDimension = 0u;
+        other.sharedCount = nullptr;
+        other.magnitudes = other.smallBuffer;
+
+        // We keep our own copy-on-write mode, which may differ from the moved-from vector's
+        syncSharedCount();
     }
     return *this;
 }
 
 // Subscript Operator (set)
-double& EuclideanVector::operator[](int index) {
-    // Euclidean norm might be changed
-    euclideanNorm = -1.0;
-    return magnitudes[index];
+template <typename T>
+typename BasicEuclideanVector<T>::MagnitudeReference BasicEuclideanVector<T>::operator[](int index) {
+    // Writes through the proxy keep the cached sum of squares up to date
+    return MagnitudeReference{*this, static_cast<unsigned>(index)};
 }
 
 // Subscript Operator (get)
-double EuclideanVector::operator[](int index) const {
-    return magnitudes[index];
+template <typename T>
+double BasicEuclideanVector<T>::operator[](int index) const {
+    return static_cast<double>(magnitudes[index]);
 }
 
 // Compound Assignment Operator (+=)
-EuclideanVector& EuclideanVector::operator+=(const EuclideanVector& other) {
-    for (unsigned i = 0u; i < getNumDimensions(); ++i)
-        magnitudes[i] += other[i];
+template <typename T>
+BasicEuclideanVector<T>& BasicEuclideanVector<T>::operator+=(const BasicEuclideanVector<T>& other) {
+    addMagnitudes(begin(), other.cbegin(), getNumDimensions());
 
     // Euclidean norm might be changed
-    euclideanNorm = -1.0;
+    invalidateNorm();
     return *this;
 }
 
 // Compound Assignment Operator (-=)
-EuclideanVector& EuclideanVector::operator-=(const EuclideanVector& other) {
-    for (unsigned i = 0u; i < getNumDimensions(); ++i)
-        magnitudes[i] -= other[i];
+template <typename T>
+BasicEuclideanVector<T>& BasicEuclideanVector<T>::operator-=(const BasicEuclideanVector<T>& other) {
+    subtractMagnitudes(begin(), other.cbegin(), getNumDimensions());
     // Euclidean norm might be changed
-    euclideanNorm = -1.0;
+    invalidateNorm();
     return *this;
 }
 
 // Compound Assignment Operator (*=)
-EuclideanVector& EuclideanVector::operator*=(double i) {
-    std::for_each(begin(), end(), [&i] (auto& d) { d *= i;});
-    // Euclidean norm might be changed
-    euclideanNorm = -1.0;
+template <typename T>
+BasicEuclideanVector<T>& BasicEuclideanVector<T>::operator*=(double i) {
+    scaleMagnitudes(begin(), i, getNumDimensions());
+    // Scaling doubles by i scales the norm by |i|, so the cache stays valid. Narrower magnitudes are
+    // rounded once scaled, and may overflow or flush to zero, so their norm is computed again.
+    if (!std::is_same<T, double>::value) {
+        invalidateNorm();
+        return *this;
+    }
+    if (euclideanNorm >= 0.0)
+        euclideanNorm *= std::abs(i);
+    if (squaredNorm >= 0.0)
+        squaredNorm *= i * i;
     return *this;
 }
 
 // Compound Assignment Operator (/=)
-EuclideanVector& EuclideanVector::operator/=(double i) {
+template <typename T>
+BasicEuclideanVector<T>& BasicEuclideanVector<T>::operator/=(double i) {
     return *this *= (1 / i);
 }
 
 // Type Conversion Operator (std::vector)
-EuclideanVector::operator std::vector<double>() const {
+template <typename T>
+BasicEuclideanVector<T>::operator std::vector<double>() const {
     std::vector<double> tmp {cbegin(), cend()};
     return tmp;
 }
 
 // Type Conversion Operator (std::list)
-EuclideanVector::operator std::list<double>() const {
+template <typename T>
+BasicEuclideanVector<T>::operator std::list<double>() const {
     std::list<double> tmp {cbegin(), cend()};
     return tmp;
 }
 
 /***********************************************  Member Functions  ***************************************************/
 
+// Turn copy-on-write on or off
+template <typename T>
+void BasicEuclideanVector<T>::setCopyOnWrite(bool on) {
+    copyOnWrite = on;
+    syncSharedCount();
+}
+
 // Return the number of dimensions
-unsigned EuclideanVector::getNumDimensions() const {
+template <typename T>
+unsigned BasicEuclideanVector<T>::getNumDimensions() const {
     return numberOfDimension;
 }
 
 // Return the value of magnitude in the dimension given as the function parameter
-double EuclideanVector::get(unsigned i) const { 
-    return magnitudes[i]; 
+template <typename T>
+double BasicEuclideanVector<T>::get(unsigned i) const { 
+    return static_cast<double>(magnitudes[i]); 
 }
 
 // Return the euclidean norm
-double EuclideanVector::getEuclideanNorm() const {
+template <typename T>
+double BasicEuclideanVector<T>::getEuclideanNorm() const {
     if (euclideanNorm != -1.0) {
         // If there is cached value
         return euclideanNorm;
+    } else if (squaredNorm >= 0.0) {
+        // If single-element writes kept the sum of squares up to date
+        euclideanNorm = sqrt(squaredNorm);
+        return euclideanNorm;
     } else {
         // Otherwise, calculate the value
-        euclideanNorm = sqrt(std::accumulate(cbegin(), cend(), 0.0, [] (const double& a, const double& b) {return a + b * b;}));
+        squaredNorm = sumOfSquaresOf(cbegin(), getNumDimensions());
+        euclideanNorm = sqrt(squaredNorm);
         return euclideanNorm;
     }
 }
 
 // Return a new unit vector
-EuclideanVector EuclideanVector::createUnitVector() const {
-    EuclideanVector unitVector {*this};
+template <typename T>
+BasicEuclideanVector<T> BasicEuclideanVector<T>::createUnitVector() const {
+    BasicEuclideanVector<T> unitVector {*this};
     double norm = getEuclideanNorm();
-    std::transform(cbegin(), cend(), unitVector.begin(), [&norm] (const auto& x) {return x / norm;});
+    std::transform(cbegin(), cend(), unitVector.begin(), [&norm] (const T& x) {return static_cast<T>(static_cast<double>(x) / norm);});
+    // The copy carried over the cached norm of *this
+    unitVector.invalidateNorm();
     return unitVector;
 }
 
+/*************************************************  Storage Helpers  **************************************************/
+
+// Release the storage of the magnitudes array if it was allocated from the resource
+template <typename T>
+void BasicEuclideanVector<T>::deallocate() {
+    if (!isInline()) {
+        if (sharedCount != nullptr)
+            releaseShared(magnitudes, sharedCount);
+        else
+            resource->deallocate(magnitudes, numberOfDimension * sizeof(T), alignof(T));
+    }
+    sharedCount = nullptr;
+    magnitudes = smallBuffer;
+}
+
+// Return a reference count of one for newly allocated copy-on-write magnitudes
+template <typename T>
+std::atomic<unsigned>* BasicEuclideanVector<T>::newSharedCount() {
+    void* p = resource->allocate(sizeof(std::atomic<unsigned>), alignof(std::atomic<unsigned>));
+    return new (p) std::atomic<unsigned> {1u};
+}
+
+// Drop a reference to shared magnitudes, releasing them if it was the last one
+template <typename T>
+void BasicEuclideanVector<T>::releaseShared(T* shared, std::atomic<unsigned>* count) {
+    if (count->fetch_sub(1u, std::memory_order_acq_rel) != 1u)
+        return;
+    resource->deallocate(shared, numberOfDimension * sizeof(T), alignof(T));
+    count->~atomic();
+    resource->deallocate(count, sizeof(std::atomic<unsigned>), alignof(std::atomic<unsigned>));
+}
+
+// Share the heap magnitudes of other, which must be in copy-on-write mode and use our resource
+template <typename T>
+void BasicEuclideanVector<T>::share(const BasicEuclideanVector<T>& other) {
+    other.sharedCount->fetch_add(1u, std::memory_order_relaxed);
+    sharedCount = other.sharedCount;
+    magnitudes = other.magnitudes;
+}
+
+// Copy shared magnitudes into storage owned by this vector alone
+template <typename T>
+void BasicEuclideanVector<T>::unshare() {
+    T* shared = magnitudes;
+    std::atomic<unsigned>* count = sharedCount;
+    sharedCount = nullptr;
+    magnitudes = allocate(numberOfDimension);
+    std::copy(shared, shared + numberOfDimension, magnitudes);
+    releaseShared(shared, count);
+}
+
+// Make sharedCount agree with copyOnWrite after heap magnitudes changed hands
+template <typename T>
+void BasicEuclideanVector<T>::syncSharedCount() {
+    if (isInline())
+        return;
+    if (copyOnWrite && sharedCount == nullptr) {
+        sharedCount = newSharedCount();
+    } else if (!copyOnWrite && sharedCount != nullptr) {
+        if (sharedCount->load(std::memory_order_acquire) != 1u) {
+            unshare();
+        } else {
+            sharedCount->~atomic();
+            resource->deallocate(sharedCount, sizeof(std::atomic<unsigned>), alignof(std::atomic<unsigned>));
+            sharedCount = nullptr;
+        }
+    }
+}
+
 /**********************************************  Nonmember Functions  *************************************************/
-bool evec::operator==(const EuclideanVector& v1, const EuclideanVector& v2) {
+template <typename T>
+bool evec::operator==(const BasicEuclideanVector<T>& v1, const BasicEuclideanVector<T>& v2) {
     if (&v1 == &v2)
         return true;
 
@@ -185,54 +406,85 @@ bool evec::operator==(const EuclideanVector& v1, const EuclideanVector& v2) {
     return true;
 }
 
-bool evec::operator!=(const EuclideanVector& v1, const EuclideanVector& v2) {
+template <typename T>
+bool evec::operator!=(const BasicEuclideanVector<T>& v1, const BasicEuclideanVector<T>& v2) {
     return !(v1 == v2);
 }
 
-EuclideanVector evec::operator+(const EuclideanVector& v1, const EuclideanVector& v2) {
-    EuclideanVector sum {v1};
-    sum += v2;
-    return sum;
+template <typename T>
+double evec::operator*(const BasicEuclideanVector<T>& v1, const BasicEuclideanVector<T>& v2) {
+    return dotOf(v1.cbegin(), v2.cbegin(), v1.getNumDimensions());
 }
 
-EuclideanVector evec::operator-(const EuclideanVector& v1, const EuclideanVector& v2) {
-    EuclideanVector diff {v1};
-    diff -= v2;
-    return diff;
+template <typename T>
+double evec::cosineSimilarity(const BasicEuclideanVector<T>& v1, const BasicEuclideanVector<T>& v2) {
+    // A vector whose norm is cached is only read, so threads can share it
+    const bool cached1 = v1.euclideanNorm >= 0.0;
+    const bool cached2 = v2.euclideanNorm >= 0.0;
+    if (cached1 && cached2)
+        return detail::cosine(v1 * v2, v1.euclideanNorm, v2.euclideanNorm);
+
+    kernels::DotAndNorms r = dotAndNormsOf(v1.cbegin(), v2.cbegin(), v1.getNumDimensions());
+    if (!cached1) {
+        v1.squaredNorm = r.squaredNormA;
+        v1.euclideanNorm = std::sqrt(r.squaredNormA);
+    }
+    if (!cached2) {
+        v2.squaredNorm = r.squaredNormB;
+        v2.euclideanNorm = std::sqrt(r.squaredNormB);
+    }
+    return detail::cosine(r.dot, v1.euclideanNorm, v2.euclideanNorm);
 }
 
-double evec::operator*(const EuclideanVector& v1, const EuclideanVector& v2) {
-    double res = 0.0;
-    for (unsigned i = 0u; i < v1.getNumDimensions(); ++i)
-        res += v1[i] * v2[i];
-    return res;
+template <typename T>
+std::ostream& evec::operator<<(std::ostream& os, const BasicEuclideanVector<T>& v) {
+    return printMagnitudes(os, v);
 }
 
-EuclideanVector evec::operator*(const EuclideanVector& v, double n) {
-    EuclideanVector product {v};
-    for (unsigned i = 0u; i < product.getNumDimensions(); ++i)
-        product[i] *= n;
-    return product;
-}
+template <typename T>
+std::istream& evec::operator>>(std::istream& is, BasicEuclideanVector<T>& v) {
+    char open;
+    std::string text;
+    // getline only stops short of the end of the stream when it consumed the closing ']'
+    if (!(is >> open) || open != '[' || !std::getline(is, text, ']') || is.eof()) {
+        is.setstate(std::ios::failbit);
+        return is;
+    }
 
-EuclideanVector evec::operator*(double n, const EuclideanVector& v) {
-    return v * n;
+    std::vector<double> magnitudes;
+    const char* first = text.data();
+    const char* last = first + text.size();
+    while (true) {
+        while (first != last && std::isspace(static_cast<unsigned char>(*first)))
+            ++first;
+        if (first == last)
+            break;
+        double m;
+        first = parseMagnitude(first, last, m);
+        if (first == nullptr || (first != last && !std::isspace(static_cast<unsigned char>(*first)))) {
+            is.setstate(std::ios::failbit);
+            return is;
+        }
+        magnitudes.push_back(m);
+    }
+    v = BasicEuclideanVector<T>{magnitudes.cbegin(), magnitudes.cend()};
+    return is;
 }
 
-EuclideanVector evec::operator/(const EuclideanVector& v, double n) {
-    return v * (1 / n);
-}
+/**********************************************  Instantiations  ******************************************************/
 
-std::ostream& evec::operator<<(std::ostream& os, const EuclideanVector& v) {
-    if (v.getNumDimensions() == 0u) {
-        std::cout << "[]";
-        return os;
-    }
+#define EVEC_INSTANTIATE(T) \
+    template class evec::BasicEuclideanVector<T>; \
+    template bool evec::operator==<T>(const BasicEuclideanVector<T>&, const BasicEuclideanVector<T>&); \
+    template bool evec::operator!=<T>(const BasicEuclideanVector<T>&, const BasicEuclideanVector<T>&); \
+    template double evec::operator*<T>(const BasicEuclideanVector<T>&, const BasicEuclideanVector<T>&); \
+    template double evec::cosineSimilarity<T>(const BasicEuclideanVector<T>&, const BasicEuclideanVector<T>&); \
+    template std::ostream& evec::operator<< <T>(std::ostream&, const BasicEuclideanVector<T>&); \
+    template std::istream& evec::operator>> <T>(std::istream&, BasicEuclideanVector<T>&);
 
-    std::cout << '[';
-    for (unsigned i = 0u; i < v.getNumDimensions() - 1; ++i)
-        std::cout << v[i] << ' ';
+EVEC_INSTANTIATE(double)
+EVEC_INSTANTIATE(float)
+EVEC_INSTANTIATE(Half)
+EVEC_INSTANTIATE(BFloat16)
 
-    std::cout << v[v.getNumDimensions() - 1] << ']';
-    return os;
-}
\ No newline at end of file
+#undef EVEC_INSTANTIATE
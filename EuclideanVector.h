@@ -8,60 +8,195 @@
 #include <cmath>
 #include <numeric>
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+#include "EuclideanVectorExpression.h"
+#include "EuclideanVectorKernels.h"
+#include "MemoryResource.h"
+
+// Vectors with at most this many dimensions keep their magnitudes inside the object
+#ifndef EVEC_SMALL_BUFFER_SIZE
+#define EVEC_SMALL_BUFFER_SIZE 4
+#endif
 
 namespace evec {
-    class EuclideanVector {
+    namespace detail {
+        template <typename...>
+        struct MakeVoid { using type = void; };
+
+        // True for pointers and for class types that declare an iterator category
+        template <typename T, typename = void>
+        struct IsIterator : std::is_pointer<T> {};
+
+        template <typename T>
+        struct IsIterator<T, typename MakeVoid<typename T::iterator_category>::type> : std::true_type {};
+
+        // True for iterators over adjacent elements: pointers (including std::array iterators)
+        // and std::vector iterators
+        template <typename It, typename V = typename std::iterator_traits<It>::value_type>
+        struct IsContiguousIterator : std::integral_constant<bool, std::is_pointer<It>::value ||
+                (!std::is_same<V, bool>::value && (std::is_same<It, typename std::vector<V>::iterator>::value ||
+                                                   std::is_same<It, typename std::vector<V>::const_iterator>::value))> {};
+
+        // True for containers and arrays that std::begin and std::end accept, other than vector expressions
+        template <typename R, typename = void>
+        struct IsRange : std::false_type {};
+
+        template <typename R>
+        struct IsRange<R, typename MakeVoid<decltype(std::begin(std::declval<const R&>())),
+                                            decltype(std::end(std::declval<const R&>()))>::type>
+                : std::integral_constant<bool, !std::is_base_of<VectorExpression<R>, R>::value> {};
+
+        // Copy n contiguous numbers into magnitudes of type T, bulk copying doubles, widening
+        // floats and ints and converting between float and 16-bit storage with the SIMD kernels
+        template <typename S, typename T>
+        void convertMagnitudes(const S* src, T* dst, std::size_t n) {
+            std::transform(src, src + n, dst, [] (const S& x) { return static_cast<T>(x); });
+        }
+
+        inline void convertMagnitudes(const double* src, double* dst, std::size_t n) {
+            if (n != 0u)
+                std::memcpy(dst, src, n * sizeof(double));
+        }
+
+        inline void convertMagnitudes(const float* src, double* dst, std::size_t n) {
+            kernels::widen(src, dst, n);
+        }
+
+        inline void convertMagnitudes(const int* src, double* dst, std::size_t n) {
+            kernels::widen(src, dst, n);
+        }
+
+        inline void convertMagnitudes(const float* src, Half* dst, std::size_t n) {
+            kernels::convert(src, dst, n);
+        }
+
+        inline void convertMagnitudes(const float* src, BFloat16* dst, std::size_t n) {
+            kernels::convert(src, dst, n);
+        }
+
+        inline void convertMagnitudes(const Half* src, float* dst, std::size_t n) {
+            kernels::convert(src, dst, n);
+        }
+
+        inline void convertMagnitudes(const BFloat16* src, float* dst, std::size_t n) {
+            kernels::convert(src, dst, n);
+        }
+    }
+
+    // Vector whose magnitudes are stored as T: double, float, or one of the 16-bit types Half and
+    // BFloat16. Magnitudes are read as double whatever T is, and writes round to T. Arithmetic on
+    // float and 16-bit vectors accumulates in float, 16-bit magnitudes being converted to float a
+    // block at a time. Norms are cached as double. EuclideanVector is the double version.
+    template <typename T>
+    class BasicEuclideanVector : public VectorExpression<BasicEuclideanVector<T>> {
     public:
+        // Write proxy returned by the non-const subscript operator. Every write goes through
+        // the vector, which keeps its cached sum of squares up to date instead of discarding it.
+        class MagnitudeReference {
+        public:
+            MagnitudeReference(BasicEuclideanVector& v, unsigned i): owner{v}, index{i} {}
+
+            // Read the magnitude
+            operator double() const { return static_cast<double>(owner.magnitudes[index]); }
+
+            // Write the magnitude
+            MagnitudeReference& operator=(double m) { owner.setMagnitude(index, m); return *this; }
+            MagnitudeReference& operator=(const MagnitudeReference& other) { return *this = static_cast<double>(other); }
+
+            // Compound Assignment Operators
+            MagnitudeReference& operator+=(double m) { return *this = *this + m; }
+            MagnitudeReference& operator-=(double m) { return *this = *this - m; }
+            MagnitudeReference& operator*=(double m) { return *this = *this * m; }
+            MagnitudeReference& operator/=(double m) { return *this = *this / m; }
+
+        private:
+            BasicEuclideanVector& owner;
+            unsigned index;
+        };
+
         // Default constructor
-        EuclideanVector();
+        BasicEuclideanVector();
 
         // Constructor that takes the number of dimensions but no magnitudes
-        EuclideanVector(unsigned);
+        BasicEuclideanVector(unsigned);
 
         // Constructor that takes the number of dimensions and initialises the magnitude in each dimension as the second argument
-        EuclideanVector(unsigned, double);
+        BasicEuclideanVector(unsigned, double, MemoryResource* = getDefaultResource());
 
-        // Constructor that takes iterators from a vector
-        EuclideanVector(std::vector<double>::iterator, std::vector<double>::iterator);
+        // Constructor that takes iterators over numbers from any container (or raw pointers)
+        template <typename InputIt, typename = typename std::enable_if<detail::IsIterator<InputIt>::value>::type>
+        BasicEuclideanVector(InputIt first, InputIt last, MemoryResource* r = getDefaultResource()):
+                BasicEuclideanVector(first, last, r, typename std::iterator_traits<InputIt>::iterator_category{}) {}
 
-        // Constructor that takes iterators from a list
-        EuclideanVector(std::list<double>::iterator, std::list<double>::iterator);
+        // Constructor that takes any container or array of numbers
+        template <typename Range, typename = typename std::enable_if<detail::IsRange<Range>::value>::type>
+        explicit BasicEuclideanVector(const Range& range, MemoryResource* r = getDefaultResource()):
+                BasicEuclideanVector(std::begin(range), std::end(range), r) {}
 
         // Constructor that takes a initialiser list of doubles
-        EuclideanVector(std::initializer_list<double>);
+        BasicEuclideanVector(std::initializer_list<double>, MemoryResource* = getDefaultResource());
+
+        // Copy Constructor (the copy uses the default resource, like std::pmr containers)
+        BasicEuclideanVector(const BasicEuclideanVector &);
 
-        // Copy Constructor
-        EuclideanVector(const EuclideanVector &);
+        // Copy Constructor that takes the resource the copy allocates from
+        BasicEuclideanVector(const BasicEuclideanVector &, MemoryResource*);
 
-        // Move Constructor
-        EuclideanVector(EuclideanVector &&);
+        // Move Constructor (the new vector takes over the resource of the moved-from vector)
+        BasicEuclideanVector(BasicEuclideanVector &&);
+
+        // Constructor that evaluates a vector expression in a single fused loop
+        template <typename E>
+        BasicEuclideanVector(const VectorExpression<E>& expr, MemoryResource* r = getDefaultResource()):
+                numberOfDimension{expr.self().getNumDimensions()}, resource{r}, magnitudes{allocate(numberOfDimension)} {
+            for (unsigned i = 0u; i < numberOfDimension; ++i)
+                magnitudes[i] = static_cast<T>(expr.self()[i]);
+        }
 
         // Destructor
-        ~EuclideanVector() noexcept ;
+        ~BasicEuclideanVector() noexcept ;
 
         // Copy Assignment
-        EuclideanVector &operator=(const EuclideanVector &);
+        BasicEuclideanVector &operator=(const BasicEuclideanVector &);
 
         // Move Assignment
-        EuclideanVector &operator=(EuclideanVector &&);
+        BasicEuclideanVector &operator=(BasicEuclideanVector &&);
+
+        // Expression Assignment, evaluated in place when the number of dimensions is unchanged
+        template <typename E>
+        BasicEuclideanVector &operator=(const VectorExpression<E>& expr) {
+            if (expr.self().getNumDimensions() != numberOfDimension)
+                return *this = BasicEuclideanVector{expr, resource};
+
+            // Each element only reads the same element of its operands, so aliasing *this is safe
+            makeUnique();
+            for (unsigned i = 0u; i < numberOfDimension; ++i)
+                magnitudes[i] = static_cast<T>(expr.self()[i]);
+            invalidateNorm();
+            return *this;
+        }
 
         // Subscript Operator (set)
-        double& operator[] (int i);
+        MagnitudeReference operator[] (int i);
 
         // Subscript Operator (get)
         double  operator[] (int i) const;
 
         // Compound Assignment Operator (+=)
-        EuclideanVector& operator+=(const EuclideanVector&);
+        BasicEuclideanVector& operator+=(const BasicEuclideanVector&);
 
         // Compound Assignment Operator (+=)
-        EuclideanVector& operator-=(const EuclideanVector&);
+        BasicEuclideanVector& operator-=(const BasicEuclideanVector&);
 
         // Compound Assignment Operator (*=)
-        EuclideanVector& operator*=(double);
+        BasicEuclideanVector& operator*=(double);
 
         // Compound Assignment Operator (/=)
-        EuclideanVector& operator/=(double);
+        BasicEuclideanVector& operator/=(double);
 
         // Type Conversion Operator (std::vector)
         operator std::vector<double>() const;
@@ -79,57 +214,198 @@ namespace evec {
         double getEuclideanNorm() const;
 
         // Create a unit vector
-        EuclideanVector createUnitVector() const;
+        BasicEuclideanVector createUnitVector() const;
 
-    private:
-        unsigned numberOfDimension = 0u; // Number of dimensions
-        double* magnitudes = nullptr; // Array of magnitudes of each dimension
-        mutable double euclideanNorm = -1.0; // Euclidean norm
+        // Return the resource heap magnitudes are allocated from
+        MemoryResource* getResource() const { return resource; }
+
+        // Turn copy-on-write on or off. In copy-on-write mode, copies that use the same resource
+        // share the heap magnitudes until one of them is written through operator[], a compound
+        // assignment or an expression assignment. Copy construction inherits the mode, while
+        // assignment keeps the mode of the assigned-to vector (like its resource).
+        void setCopyOnWrite(bool);
+
+        // Return true if copies of this vector share its magnitudes
+        bool isCopyOnWrite() const { return copyOnWrite; }
+
+        // Return true if the magnitudes are currently shared with another vector
+        bool isShared() const { return sharedCount != nullptr && sharedCount->load(std::memory_order_acquire) > 1u; }
 
         // return a const pointer to the head of the magnitudes array
-        double const * cbegin() const { 
-            double const * p = magnitudes;
+        T const * cbegin() const { 
+            T const * p = magnitudes;
             return p;
         };
 
         // return a const pointer to the tail of the magnitudes array
-        double const * cend() const {
-            double const * p = magnitudes + numberOfDimension;
+        T const * cend() const {
+            T const * p = magnitudes + numberOfDimension;
             return p;
         }
 
-        // return a pointer to the head of the magnitudes array
-        double * begin() {
-            double * p = magnitudes;
+        // Computes the norms of both vectors along with the dot product, and caches them
+        template <typename U>
+        friend double cosineSimilarity(const BasicEuclideanVector<U>&, const BasicEuclideanVector<U>&);
+
+        // Type of the stored magnitudes
+        using Scalar = T;
+
+        // Maximum number of dimensions stored without a heap allocation
+        static constexpr unsigned smallBufferSize = EVEC_SMALL_BUFFER_SIZE;
+
+    private:
+        // Constructor that takes multi-pass iterators, which can be measured before copying
+        template <typename It>
+        BasicEuclideanVector(It first, It last, MemoryResource* r, std::forward_iterator_tag):
+                numberOfDimension{static_cast<unsigned>(std::distance(first, last))}, resource{r}, magnitudes{allocate(numberOfDimension)} {
+            copyMagnitudes(first, last, detail::IsContiguousIterator<It>{});
+        }
+
+        // Constructor that takes single-pass iterators, which are buffered first
+        template <typename It>
+        BasicEuclideanVector(It first, It last, MemoryResource* r, std::input_iterator_tag):
+                BasicEuclideanVector(std::vector<double>(first, last), r) {}
+
+        // copy magnitudes from adjacent elements
+        template <typename It>
+        void copyMagnitudes(It first, It last, std::true_type) {
+            if (first != last)
+                detail::convertMagnitudes(&*first, magnitudes, numberOfDimension);
+        }
+
+        // copy magnitudes one element at a time
+        template <typename It>
+        void copyMagnitudes(It first, It last, std::false_type) {
+            std::transform(first, last, magnitudes, [] (const typename std::iterator_traits<It>::value_type& x) {
+                return static_cast<T>(x);
+            });
+        }
+
+        unsigned numberOfDimension = 0u; // Number of dimensions
+        MemoryResource* resource = getDefaultResource(); // Resource heap magnitudes are allocated from
+        bool copyOnWrite = false; // Whether copies share the heap magnitudes until one of them writes
+        std::atomic<unsigned>* sharedCount = nullptr; // Number of vectors sharing the heap magnitudes (copy-on-write only)
+        T* magnitudes = nullptr; // Array of magnitudes of each dimension
+        mutable double euclideanNorm = -1.0; // Euclidean norm
+        mutable double squaredNorm = -1.0; // Sum of squares of the magnitudes, kept up to date by single-element writes
+        T smallBuffer[smallBufferSize]; // Inline storage for low-dimensional vectors
+
+        // forget the cached norm after the magnitudes changed in bulk
+        void invalidateNorm() {
+            euclideanNorm = -1.0;
+            squaredNorm = -1.0;
+        }
+
+        // write one magnitude, updating the cached sum of squares in O(1)
+        void setMagnitude(unsigned i, double value) {
+            makeUnique();
+            double old = static_cast<double>(magnitudes[i]);
+            magnitudes[i] = static_cast<T>(value);
+            // The cached sum is of the stored magnitudes, which may have been rounded
+            double m = static_cast<double>(magnitudes[i]);
+            euclideanNorm = -1.0;
+            if (squaredNorm < 0.0)
+                return;
+
+            // Removing most of the sum would leave mostly rounding error, so rescan lazily instead
+            if (old * old > 0.5 * squaredNorm)
+                squaredNorm = -1.0;
+            else
+                squaredNorm += m * m - old * old;
+        }
+
+        // return true if the magnitudes live in the inline buffer
+        bool isInline() const {
+            return magnitudes == smallBuffer;
+        }
+
+        // return storage for n magnitudes, using the inline buffer when it is large enough
+        T * allocate(unsigned n) {
+            if (n <= smallBufferSize)
+                return smallBuffer;
+            if (copyOnWrite)
+                sharedCount = newSharedCount();
+            return static_cast<T*>(resource->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        // release the storage of the magnitudes array if it was allocated from the resource
+        // (shared magnitudes are only released by the last vector sharing them)
+        void deallocate();
+
+        // return a reference count of one for newly allocated copy-on-write magnitudes
+        std::atomic<unsigned>* newSharedCount();
+
+        // drop a reference to shared magnitudes, releasing them if it was the last one
+        void releaseShared(T* shared, std::atomic<unsigned>* count);
+
+        // share the heap magnitudes of other, which must be in copy-on-write mode and use our resource
+        void share(const BasicEuclideanVector& other);
+
+        // make sharedCount agree with copyOnWrite after heap magnitudes changed hands
+        void syncSharedCount();
+
+        // take a private copy of the magnitudes if other vectors share them, before writing
+        void makeUnique() {
+            if (sharedCount != nullptr && sharedCount->load(std::memory_order_acquire) != 1u)
+                unshare();
+        }
+
+        // copy shared magnitudes into storage owned by this vector alone
+        void unshare();
+
+        // return a pointer to the head of the magnitudes array (for writing)
+        T * begin() {
+            makeUnique();
+            T * p = magnitudes;
             return p;
         }
 
-        // return a pointer to the tail of the magnitudes array
-        double * end() {
-            double * p = magnitudes + numberOfDimension;
+        // return a pointer to the tail of the magnitudes array (for writing)
+        T * end() {
+            makeUnique();
+            T * p = magnitudes + numberOfDimension;
             return p;
         }
     };
 
-    // Equality Operator
-    bool operator==(const EuclideanVector&, const EuclideanVector&);
-    bool operator!=(const EuclideanVector&, const EuclideanVector&);
+    template <typename T>
+    constexpr unsigned BasicEuclideanVector<T>::smallBufferSize;
 
-    // Addition Operator
-    EuclideanVector operator+(const EuclideanVector&, const EuclideanVector&);
+    using EuclideanVector = BasicEuclideanVector<double>;
 
-    // Subtraction Operator
-    EuclideanVector operator-(const EuclideanVector&, const EuclideanVector&);
+    // The members are defined in EuclideanVector.cpp for these scalar types
+    extern template class BasicEuclideanVector<double>;
+    extern template class BasicEuclideanVector<float>;
+    extern template class BasicEuclideanVector<Half>;
+    extern template class BasicEuclideanVector<BFloat16>;
+
+    // Equality Operator
+    template <typename T>
+    bool operator==(const BasicEuclideanVector<T>&, const BasicEuclideanVector<T>&);
+    template <typename T>
+    bool operator!=(const BasicEuclideanVector<T>&, const BasicEuclideanVector<T>&);
+
+    // Addition, Subtraction, scalar Multiplication and Division Operators build lazy
+    // expressions (see EuclideanVectorExpression.h) that are evaluated on assignment
 
     // Multiplication Operator
-    double operator*(const EuclideanVector&, const EuclideanVector&);
-    EuclideanVector operator*(const EuclideanVector&, double);
-    EuclideanVector operator*(double, const EuclideanVector&);
+    template <typename T>
+    double operator*(const BasicEuclideanVector<T>&, const BasicEuclideanVector<T>&);
 
-    // Division Operator
-    EuclideanVector operator/(const EuclideanVector&, double);
+    // Return the cosine similarity, zero if either vector is zero. The dot product and whichever
+    // norms are not cached yet are computed in one pass, and only those norm caches are filled, so
+    // comparing many vectors against the same query reads the query's magnitudes once per vector.
+    // Filling a cache writes to a const operand: threads may share a vector once its norm is cached
+    // (getEuclideanNorm caches it), but not a vector whose norm is not.
+    template <typename T>
+    double cosineSimilarity(const BasicEuclideanVector<T>&, const BasicEuclideanVector<T>&);
 
     // Ostream Operator
-    std::ostream& operator<<(std::ostream&, const EuclideanVector&);
+    template <typename T>
+    std::ostream& operator<<(std::ostream&, const BasicEuclideanVector<T>&);
+
+    // Read a vector written by operator<< ("[m0 m1 ...]"), setting failbit on malformed input
+    template <typename T>
+    std::istream& operator>>(std::istream&, BasicEuclideanVector<T>&);
 }
-#endif
\ No newline at end of file
+#endif
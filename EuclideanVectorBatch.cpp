@@ -0,0 +1,165 @@
+#include "EuclideanVectorBatch.h"
+#include "EuclideanVectorKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+using namespace evec;
+
+constexpr std::size_t EuclideanVectorBatch::alignment;
+
+/***************************************  Constructors and destructors  ***********************************************/
+
+// Constructor that takes the number of vectors and the number of dimensions, all magnitudes are zero
+EuclideanVectorBatch::EuclideanVectorBatch(std::size_t n, unsigned d, Layout l, MemoryResource* r):
+        count{n}, dimension{d}, layout{l}, resource{r} {
+    allocate();
+    std::fill(buffer, buffer + count * dimension, 0.0);
+}
+
+// Constructor that copies vectors of the same dimension
+EuclideanVectorBatch::EuclideanVectorBatch(const std::vector<EuclideanVector>& vectors, Layout l, MemoryResource* r):
+        count{vectors.size()}, dimension{vectors.empty() ? 0u : vectors.front().getNumDimensions()}, layout{l}, resource{r} {
+    for (const EuclideanVector& v : vectors) {
+        if (v.getNumDimensions() != dimension)
+            throw std::invalid_argument{"the vectors of a batch must have the same number of dimensions"};
+    }
+    allocate();
+    for (std::size_t i = 0u; i < count; ++i) {
+        if (layout == Layout::RowMajor)
+            std::copy(vectors[i].cbegin(), vectors[i].cend(), buffer + i * dimension);
+        else
+            (*this)[i] = vectors[i];
+    }
+}
+
+// Copy Constructor
+EuclideanVectorBatch::EuclideanVectorBatch(const EuclideanVectorBatch& other):
+        count{other.count}, dimension{other.dimension}, layout{other.layout}, resource{getDefaultResource()} {
+    allocate();
+    std::copy(other.buffer, other.buffer + count * dimension, buffer);
+}
+
+// Move Constructor
+EuclideanVectorBatch::EuclideanVectorBatch(EuclideanVectorBatch&& other) noexcept:
+        count{other.count}, dimension{other.dimension}, layout{other.layout}, resource{other.resource}, buffer{other.buffer} {
+    other.count = 0u;
+    other.buffer = nullptr;
+}
+
+// Destructor
+EuclideanVectorBatch::~EuclideanVectorBatch() noexcept { deallocate(); }
+
+/*******************************************  Overloading operators  **************************************************/
+
+// Copy Assignment
+EuclideanVectorBatch& EuclideanVectorBatch::operator=(const EuclideanVectorBatch& other) {
+    if (this != &other) {
+        // Reuse the current buffer when the number of magnitudes is unchanged
+        if (count * dimension != other.count * other.dimension) {
+            deallocate();
+            count = other.count;
+            dimension = other.dimension;
+            allocate();
+        }
+        count = other.count;
+        dimension = other.dimension;
+        layout = other.layout;
+        std::copy(other.buffer, other.buffer + count * dimension, buffer);
+    }
+    return *this;
+}
+
+// Move Assignment
+EuclideanVectorBatch& EuclideanVectorBatch::operator=(EuclideanVectorBatch&& other) noexcept {
+    if (this != &other) {
+        deallocate();
+        count = other.count;
+        dimension = other.dimension;
+        layout = other.layout;
+        resource = other.resource;
+        buffer = other.buffer;
+        other.count = 0u;
+        other.buffer = nullptr;
+    }
+    return *this;
+}
+
+/***********************************************  Member Functions  ***************************************************/
+
+// Return a copy of the batch stored in the given layout
+EuclideanVectorBatch EuclideanVectorBatch::toLayout(Layout l) const {
+    EuclideanVectorBatch converted {count, dimension, l, resource};
+    for (std::size_t i = 0u; i < count; ++i)
+        converted[i] = (*this)[i];
+    return converted;
+}
+
+// Write the euclidean norm of every vector to out
+void EuclideanVectorBatch::norms(double* out) const {
+    if (layout == Layout::RowMajor) {
+        for (std::size_t i = 0u; i < count; ++i)
+            out[i] = std::sqrt(kernels::sumOfSquares(buffer + i * dimension, dimension));
+        return;
+    }
+
+    // Column-major: walk one dimension of every vector at a time so the inner loop is unit stride
+    std::fill(out, out + count, 0.0);
+    for (unsigned d = 0u; d < dimension; ++d) {
+        const double* column = buffer + d * count;
+        for (std::size_t i = 0u; i < count; ++i)
+            out[i] += column[i] * column[i];
+    }
+    std::transform(out, out + count, out, [] (double s) { return std::sqrt(s); });
+}
+
+std::vector<double> EuclideanVectorBatch::norms() const {
+    std::vector<double> out(count);
+    norms(out.data());
+    return out;
+}
+
+// Write the dot product of every vector with the query to out
+void EuclideanVectorBatch::dot(const EuclideanVector& query, double* out) const {
+    assert(query.getNumDimensions() == dimension);
+    if (layout == Layout::RowMajor) {
+        for (std::size_t i = 0u; i < count; ++i)
+            out[i] = kernels::dot(buffer + i * dimension, query.cbegin(), dimension);
+        return;
+    }
+
+    // Column-major: accumulate one dimension of every vector at a time
+    std::fill(out, out + count, 0.0);
+    for (unsigned d = 0u; d < dimension; ++d) {
+        const double* column = buffer + d * count;
+        const double q = query[d];
+        for (std::size_t i = 0u; i < count; ++i)
+            out[i] += column[i] * q;
+    }
+}
+
+std::vector<double> EuclideanVectorBatch::dot(const EuclideanVector& query) const {
+    std::vector<double> out(count);
+    dot(query, out.data());
+    return out;
+}
+
+// Multiply every magnitude of every vector by k
+void EuclideanVectorBatch::scale(double k) {
+    kernels::scale(buffer, k, count * dimension);
+}
+
+// Allocate the buffer for count * dimension magnitudes
+void EuclideanVectorBatch::allocate() {
+    std::size_t bytes = count * dimension * sizeof(double);
+    buffer = bytes == 0u ? nullptr : static_cast<double*>(resource->allocate(bytes, alignment));
+}
+
+// Release the buffer
+void EuclideanVectorBatch::deallocate() {
+    if (buffer != nullptr)
+        resource->deallocate(buffer, count * dimension * sizeof(double), alignment);
+    buffer = nullptr;
+}
@@ -0,0 +1,188 @@
+#ifndef A2_EUCLIDEANVECTORBATCH_H
+#define A2_EUCLIDEANVECTORBATCH_H
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "EuclideanVector.h"
+#include "EuclideanVectorExpression.h"
+#include "MemoryResource.h"
+
+namespace evec {
+    // Lightweight view of one vector stored in an EuclideanVectorBatch. T is double for a mutable
+    // row and const double for a read-only row. Rows are vector expressions, so they work with the
+    // arithmetic operators, the dot product and getEuclideanNorm, and convert to EuclideanVector.
+    template <typename T>
+    class BatchRow : public VectorExpression<BatchRow<T>> {
+    public:
+        // Constructor that takes the first magnitude, the distance between magnitudes and the number of dimensions
+        BatchRow(T* first, std::size_t s, unsigned n): head{first}, stride{s}, numberOfDimension{n} {}
+
+        // Conversion from a mutable row to a read-only row
+        template <typename U, typename = typename std::enable_if<std::is_same<const U, T>::value>::type>
+        BatchRow(const BatchRow<U>& other): head{other.data()}, stride{other.getStride()}, numberOfDimension{other.getNumDimensions()} {}
+
+        // Expression Assignment (writes through to the batch)
+        template <typename E>
+        BatchRow& operator=(const VectorExpression<E>& expr) {
+            assert(expr.self().getNumDimensions() == numberOfDimension);
+            for (unsigned i = 0u; i < numberOfDimension; ++i)
+                (*this)[i] = expr.self()[i];
+            return *this;
+        }
+
+        // Copy Constructor (the new row views the same magnitudes)
+        BatchRow(const BatchRow&) = default;
+
+        // Copy Assignment (writes the magnitudes of the other row, the view itself is not rebound)
+        BatchRow& operator=(const BatchRow& other) {
+            return *this = static_cast<const VectorExpression<BatchRow>&>(other);
+        }
+
+        // Subscript Operator
+        T& operator[](unsigned i) const { return head[i * stride]; }
+
+        // Compound Assignment Operator (+=)
+        template <typename E>
+        BatchRow& operator+=(const VectorExpression<E>& expr) {
+            for (unsigned i = 0u; i < numberOfDimension; ++i)
+                (*this)[i] += expr.self()[i];
+            return *this;
+        }
+
+        // Compound Assignment Operator (-=)
+        template <typename E>
+        BatchRow& operator-=(const VectorExpression<E>& expr) {
+            for (unsigned i = 0u; i < numberOfDimension; ++i)
+                (*this)[i] -= expr.self()[i];
+            return *this;
+        }
+
+        // Compound Assignment Operator (*=)
+        BatchRow& operator*=(double k) {
+            for (unsigned i = 0u; i < numberOfDimension; ++i)
+                (*this)[i] *= k;
+            return *this;
+        }
+
+        // Compound Assignment Operator (/=)
+        BatchRow& operator/=(double k) {
+            return *this *= (1 / k);
+        }
+
+        // Return the number of dimensions
+        unsigned getNumDimensions() const { return numberOfDimension; }
+
+        // Return true if the magnitudes are adjacent in memory (row-major batches)
+        bool isContiguous() const { return stride == 1u; }
+
+        // Return a pointer to the first magnitude
+        T* data() const { return head; }
+
+        // Return the distance between consecutive magnitudes
+        std::size_t getStride() const { return stride; }
+
+    private:
+        T* head; // First magnitude of the row
+        std::size_t stride; // Distance between consecutive magnitudes
+        unsigned numberOfDimension; // Number of dimensions
+    };
+
+    // Rows of row-major batches go through the SIMD kernels in distances and dot products
+    template <typename T>
+    struct RuntimeContiguity<BatchRow<T>> {
+        static const double* data(const BatchRow<T>& row) { return row.isContiguous() ? row.data() : nullptr; }
+    };
+
+    // N vectors of the same dimension D stored in a single 64-byte aligned buffer, either one
+    // vector after another (row-major) or one dimension after another (column-major, SoA)
+    class EuclideanVectorBatch {
+    public:
+        enum class Layout { RowMajor, ColumnMajor };
+
+        using Row = BatchRow<double>;
+        using ConstRow = BatchRow<const double>;
+
+        // Alignment of the buffer in bytes
+        static constexpr std::size_t alignment = 64u;
+
+        // Constructor that takes the number of vectors and the number of dimensions, all magnitudes are zero
+        EuclideanVectorBatch(std::size_t count, unsigned dimension, Layout = Layout::RowMajor,
+                             MemoryResource* = getDefaultResource());
+
+        // Constructor that copies vectors of the same dimension. Throws std::invalid_argument if
+        // their dimensions differ.
+        explicit EuclideanVectorBatch(const std::vector<EuclideanVector>&, Layout = Layout::RowMajor,
+                                      MemoryResource* = getDefaultResource());
+
+        // Copy Constructor
+        EuclideanVectorBatch(const EuclideanVectorBatch&);
+
+        // Move Constructor
+        EuclideanVectorBatch(EuclideanVectorBatch&&) noexcept;
+
+        // Destructor
+        ~EuclideanVectorBatch() noexcept;
+
+        // Copy Assignment
+        EuclideanVectorBatch& operator=(const EuclideanVectorBatch&);
+
+        // Move Assignment
+        EuclideanVectorBatch& operator=(EuclideanVectorBatch&&) noexcept;
+
+        // Subscript Operator (set)
+        Row operator[](std::size_t i) {
+            return layout == Layout::RowMajor ? Row{buffer + i * dimension, 1u, dimension}
+                                              : Row{buffer + i, count, dimension};
+        }
+
+        // Subscript Operator (get)
+        ConstRow operator[](std::size_t i) const {
+            return layout == Layout::RowMajor ? ConstRow{buffer + i * dimension, 1u, dimension}
+                                              : ConstRow{buffer + i, count, dimension};
+        }
+
+        // Return the number of vectors
+        std::size_t size() const { return count; }
+
+        // Return the number of dimensions of every vector
+        unsigned getNumDimensions() const { return dimension; }
+
+        // Return the layout of the buffer
+        Layout getLayout() const { return layout; }
+
+        // Return the buffer holding size() * getNumDimensions() magnitudes
+        double* data() { return buffer; }
+        const double* data() const { return buffer; }
+
+        // Return a copy of the batch stored in the given layout
+        EuclideanVectorBatch toLayout(Layout) const;
+
+        // Write the euclidean norm of every vector to out (size() values)
+        void norms(double* out) const;
+        std::vector<double> norms() const;
+
+        // Write the dot product of every vector with the query to out (size() values)
+        void dot(const EuclideanVector& query, double* out) const;
+        std::vector<double> dot(const EuclideanVector& query) const;
+
+        // Multiply every magnitude of every vector by k
+        void scale(double k);
+
+    private:
+        std::size_t count; // Number of vectors
+        unsigned dimension; // Number of dimensions of every vector
+        Layout layout; // Order of the magnitudes in the buffer
+        MemoryResource* resource; // Resource the buffer is allocated from
+        double* buffer = nullptr; // count * dimension magnitudes
+
+        // Allocate the buffer for count * dimension magnitudes
+        void allocate();
+
+        // Release the buffer
+        void deallocate();
+    };
+}
+#endif
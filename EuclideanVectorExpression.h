@@ -0,0 +1,349 @@
+#ifndef A2_EUCLIDEANVECTOREXPRESSION_H
+#define A2_EUCLIDEANVECTOREXPRESSION_H
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <type_traits>
+
+#include "EuclideanVectorFormat.h"
+#include "EuclideanVectorKernels.h"
+
+namespace evec {
+    template <typename T>
+    class BasicEuclideanVector;
+
+    using EuclideanVector = BasicEuclideanVector<double>;
+
+    // Base class of everything that can appear in a lazily evaluated vector expression.
+    // E must provide getNumDimensions() and a const operator[] returning the magnitude.
+    template <typename E>
+    class VectorExpression {
+    public:
+        // return the concrete expression
+        const E& self() const {
+            return static_cast<const E&>(*this);
+        }
+
+        // Return the euclidean norm without materialising the expression
+        double getEuclideanNorm() const {
+            double sum = 0.0;
+            for (unsigned i = 0u; i < self().getNumDimensions(); ++i) {
+                double m = self()[i];
+                sum += m * m;
+            }
+            return std::sqrt(sum);
+        }
+    };
+
+    // True if T can be used as an operand of the expression operators
+    template <typename T>
+    struct IsVectorExpression : std::is_base_of<VectorExpression<T>, T> {};
+
+    // Leaves are stored by reference inside expression nodes, every other node by value
+    template <typename T>
+    struct IsExpressionLeaf : std::false_type {};
+
+    template <typename T>
+    struct IsExpressionLeaf<BasicEuclideanVector<T>> : std::true_type {};
+
+    // Operands whose magnitudes are adjacent doubles reachable through cbegin(), which lets
+    // reductions over them use the SIMD kernels
+    template <typename T>
+    struct IsContiguousExpression : std::false_type {};
+
+    template <>
+    struct IsContiguousExpression<EuclideanVector> : std::true_type {};
+
+    // Operands whose magnitudes are adjacent doubles in some instances only, which is known at run
+    // time (rows of a batch are in row-major batches). data() returns the first magnitude of an
+    // operand whose magnitudes are adjacent and nullptr otherwise, so reductions over it can still
+    // use the SIMD kernels.
+    template <typename T>
+    struct RuntimeContiguity {
+        static const double* data(const T&) { return nullptr; }
+    };
+
+    namespace detail {
+        // Return the first magnitude of an operand if its magnitudes are adjacent, nullptr otherwise
+        template <typename E>
+        const double* adjacentMagnitudes(const E& e, std::true_type) { return e.cbegin(); }
+
+        template <typename E>
+        const double* adjacentMagnitudes(const E& e, std::false_type) { return RuntimeContiguity<E>::data(e); }
+
+        template <typename E>
+        const double* adjacentMagnitudes(const E& e) { return adjacentMagnitudes(e, IsContiguousExpression<E>{}); }
+    }
+
+    template <typename T>
+    using ExpressionOperand = typename std::conditional<IsExpressionLeaf<T>::value, const T&, const T>::type;
+
+    template <typename L, typename R>
+    using EnableIfExpressions = typename std::enable_if<IsVectorExpression<L>::value && IsVectorExpression<R>::value>::type;
+
+    template <typename E>
+    using EnableIfExpression = typename std::enable_if<IsVectorExpression<E>::value>::type;
+
+    // Lazy element-wise sum of two expressions
+    template <typename L, typename R>
+    class VectorSum : public VectorExpression<VectorSum<L, R>> {
+    public:
+        VectorSum(const L& l, const R& r): lhs{l}, rhs{r} {}
+
+        unsigned getNumDimensions() const { return lhs.getNumDimensions(); }
+
+        double operator[](unsigned i) const { return lhs[i] + rhs[i]; }
+
+    private:
+        ExpressionOperand<L> lhs;
+        ExpressionOperand<R> rhs;
+    };
+
+    // Lazy element-wise difference of two expressions
+    template <typename L, typename R>
+    class VectorDifference : public VectorExpression<VectorDifference<L, R>> {
+    public:
+        VectorDifference(const L& l, const R& r): lhs{l}, rhs{r} {}
+
+        unsigned getNumDimensions() const { return lhs.getNumDimensions(); }
+
+        double operator[](unsigned i) const { return lhs[i] - rhs[i]; }
+
+    private:
+        ExpressionOperand<L> lhs;
+        ExpressionOperand<R> rhs;
+    };
+
+    // Lazy product of an expression and a scalar
+    template <typename E>
+    class ScaledVector : public VectorExpression<ScaledVector<E>> {
+    public:
+        ScaledVector(const E& e, double k): operand{e}, factor{k} {}
+
+        unsigned getNumDimensions() const { return operand.getNumDimensions(); }
+
+        double operator[](unsigned i) const { return operand[i] * factor; }
+
+    private:
+        ExpressionOperand<E> operand;
+        double factor;
+    };
+
+    // Addition Operator
+    template <typename L, typename R, typename = EnableIfExpressions<L, R>>
+    VectorSum<L, R> operator+(const L& v1, const R& v2) {
+        return VectorSum<L, R>{v1, v2};
+    }
+
+    // Subtraction Operator
+    template <typename L, typename R, typename = EnableIfExpressions<L, R>>
+    VectorDifference<L, R> operator-(const L& v1, const R& v2) {
+        return VectorDifference<L, R>{v1, v2};
+    }
+
+    namespace detail {
+        // dot product of two contiguous operands
+        template <typename L, typename R>
+        double dot(const L& v1, const R& v2, std::true_type) {
+            return kernels::parallelDot(v1.cbegin(), v2.cbegin(), v1.getNumDimensions());
+        }
+
+        // dot product of operands that have to be evaluated element by element, unless both turn
+        // out to be contiguous at run time
+        template <typename L, typename R>
+        double dot(const L& v1, const R& v2, std::false_type) {
+            const double* a = adjacentMagnitudes(v1);
+            const double* b = adjacentMagnitudes(v2);
+            if (a != nullptr && b != nullptr)
+                return kernels::parallelDot(a, b, v1.getNumDimensions());
+            double res = 0.0;
+            for (unsigned i = 0u; i < v1.getNumDimensions(); ++i)
+                res += v1[i] * v2[i];
+            return res;
+        }
+    }
+
+    // Equality Operator
+    template <typename L, typename R, typename = EnableIfExpressions<L, R>>
+    bool operator==(const L& v1, const R& v2) {
+        if (v1.getNumDimensions() != v2.getNumDimensions())
+            return false;
+        for (unsigned i = 0u; i < v1.getNumDimensions(); ++i) {
+            if (v1[i] != v2[i])
+                return false;
+        }
+        return true;
+    }
+
+    template <typename L, typename R, typename = EnableIfExpressions<L, R>>
+    bool operator!=(const L& v1, const R& v2) {
+        return !(v1 == v2);
+    }
+
+    // Multiplication Operator (dot product evaluated in a single pass)
+    template <typename L, typename R, typename = EnableIfExpressions<L, R>>
+    double operator*(const L& v1, const R& v2) {
+        using Contiguous = std::integral_constant<bool, IsContiguousExpression<L>::value && IsContiguousExpression<R>::value>;
+        return detail::dot(v1, v2, Contiguous{});
+    }
+
+    namespace detail {
+        // Distances between contiguous operands, a single pass of the SIMD kernels
+        template <typename L, typename R>
+        double squaredDistance(const L& v1, const R& v2, std::true_type) {
+            return kernels::squaredDistance(v1.cbegin(), v2.cbegin(), v1.getNumDimensions());
+        }
+
+        template <typename L, typename R>
+        double manhattanDistance(const L& v1, const R& v2, std::true_type) {
+            return kernels::manhattanDistance(v1.cbegin(), v2.cbegin(), v1.getNumDimensions());
+        }
+
+        template <typename L, typename R>
+        double chebyshevDistance(const L& v1, const R& v2, std::true_type) {
+            return kernels::chebyshevDistance(v1.cbegin(), v2.cbegin(), v1.getNumDimensions());
+        }
+
+        // Distances between operands that have to be evaluated element by element, unless both turn
+        // out to be contiguous at run time
+        template <typename L, typename R>
+        double squaredDistance(const L& v1, const R& v2, std::false_type) {
+            const double* a = adjacentMagnitudes(v1);
+            const double* b = adjacentMagnitudes(v2);
+            if (a != nullptr && b != nullptr)
+                return kernels::squaredDistance(a, b, v1.getNumDimensions());
+            double res = 0.0;
+            for (unsigned i = 0u; i < v1.getNumDimensions(); ++i) {
+                double d = v1[i] - v2[i];
+                res += d * d;
+            }
+            return res;
+        }
+
+        template <typename L, typename R>
+        double manhattanDistance(const L& v1, const R& v2, std::false_type) {
+            const double* a = adjacentMagnitudes(v1);
+            const double* b = adjacentMagnitudes(v2);
+            if (a != nullptr && b != nullptr)
+                return kernels::manhattanDistance(a, b, v1.getNumDimensions());
+            double res = 0.0;
+            for (unsigned i = 0u; i < v1.getNumDimensions(); ++i)
+                res += std::abs(v1[i] - v2[i]);
+            return res;
+        }
+
+        template <typename L, typename R>
+        double chebyshevDistance(const L& v1, const R& v2, std::false_type) {
+            const double* a = adjacentMagnitudes(v1);
+            const double* b = adjacentMagnitudes(v2);
+            if (a != nullptr && b != nullptr)
+                return kernels::chebyshevDistance(a, b, v1.getNumDimensions());
+            double res = 0.0;
+            for (unsigned i = 0u; i < v1.getNumDimensions(); ++i)
+                res = std::max(res, std::abs(v1[i] - v2[i]));
+            return res;
+        }
+
+        template <typename L, typename R>
+        using BothContiguous = std::integral_constant<bool, IsContiguousExpression<L>::value && IsContiguousExpression<R>::value>;
+    }
+
+    // Distances between two expressions of the same number of dimensions. Each is one pass over
+    // both operands that never stores their difference, unlike (v1 - v2).getEuclideanNorm().
+
+    // Return the squared euclidean distance
+    template <typename L, typename R, typename = EnableIfExpressions<L, R>>
+    double squaredDistance(const L& v1, const R& v2) {
+        return detail::squaredDistance(v1, v2, detail::BothContiguous<L, R>{});
+    }
+
+    // Return the euclidean distance
+    template <typename L, typename R, typename = EnableIfExpressions<L, R>>
+    double distance(const L& v1, const R& v2) {
+        return std::sqrt(squaredDistance(v1, v2));
+    }
+
+    // Return the manhattan (L1) distance
+    template <typename L, typename R, typename = EnableIfExpressions<L, R>>
+    double manhattanDistance(const L& v1, const R& v2) {
+        return detail::manhattanDistance(v1, v2, detail::BothContiguous<L, R>{});
+    }
+
+    // Return the chebyshev (L-infinity) distance, the largest difference in any dimension
+    template <typename L, typename R, typename = EnableIfExpressions<L, R>>
+    double chebyshevDistance(const L& v1, const R& v2) {
+        return detail::chebyshevDistance(v1, v2, detail::BothContiguous<L, R>{});
+    }
+
+    namespace detail {
+        // dot product and squared norms of contiguous operands, one pass of the SIMD kernels
+        template <typename L, typename R>
+        kernels::DotAndNorms dotAndNorms(const L& v1, const R& v2, std::true_type) {
+            return kernels::parallelDotAndNorms(v1.cbegin(), v2.cbegin(), v1.getNumDimensions());
+        }
+
+        // dot product and squared norms of operands that have to be evaluated element by element,
+        // unless both turn out to be contiguous at run time
+        template <typename L, typename R>
+        kernels::DotAndNorms dotAndNorms(const L& v1, const R& v2, std::false_type) {
+            const double* a = adjacentMagnitudes(v1);
+            const double* b = adjacentMagnitudes(v2);
+            if (a != nullptr && b != nullptr)
+                return kernels::parallelDotAndNorms(a, b, v1.getNumDimensions());
+            kernels::DotAndNorms res {0.0, 0.0, 0.0};
+            for (unsigned i = 0u; i < v1.getNumDimensions(); ++i) {
+                double x = v1[i], y = v2[i];
+                res.dot += x * y;
+                res.squaredNormA += x * x;
+                res.squaredNormB += y * y;
+            }
+            return res;
+        }
+
+        // Return the cosine of the angle between vectors with the given dot product and norms, zero if either is zero
+        inline double cosine(double dot, double norm1, double norm2) {
+            double norms = norm1 * norm2;
+            return norms == 0.0 ? 0.0 : std::max(-1.0, std::min(1.0, dot / norms));
+        }
+    }
+
+    // Return the cosine similarity, computing the dot product and both norms in a single pass.
+    // Zero if either operand is the zero vector. EuclideanVector operands have an overload that
+    // also fills their norm caches (see EuclideanVector.h).
+    template <typename L, typename R, typename = EnableIfExpressions<L, R>>
+    double cosineSimilarity(const L& v1, const R& v2) {
+        kernels::DotAndNorms r = detail::dotAndNorms(v1, v2, detail::BothContiguous<L, R>{});
+        return detail::cosine(r.dot, std::sqrt(r.squaredNormA), std::sqrt(r.squaredNormB));
+    }
+
+    // Return the angle between two vectors divided by pi, from 0 (same direction) to 1 (opposite)
+    template <typename L, typename R, typename = EnableIfExpressions<L, R>>
+    double angularDistance(const L& v1, const R& v2) {
+        const double pi = 3.14159265358979323846;
+        return std::acos(cosineSimilarity(v1, v2)) / pi;
+    }
+
+    template <typename E, typename = EnableIfExpression<E>>
+    ScaledVector<E> operator*(const E& v, double n) {
+        return ScaledVector<E>{v, n};
+    }
+
+    template <typename E, typename = EnableIfExpression<E>>
+    ScaledVector<E> operator*(double n, const E& v) {
+        return ScaledVector<E>{v, n};
+    }
+
+    // Division Operator
+    template <typename E, typename = EnableIfExpression<E>>
+    ScaledVector<E> operator/(const E& v, double n) {
+        return ScaledVector<E>{v, 1 / n};
+    }
+
+    // Ostream Operator
+    template <typename E, typename = EnableIfExpression<E>>
+    std::ostream& operator<<(std::ostream& os, const E& v) {
+        return printMagnitudes(os, v);
+    }
+}
+#endif
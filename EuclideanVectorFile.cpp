@@ -0,0 +1,251 @@
+#include "EuclideanVectorFile.h"
+#include "EuclideanVectorFormat.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace evec;
+
+namespace {
+    const char fileMagic[8] = {'E', 'V', 'E', 'C', 'B', 'I', 'N', '\0'};
+    const std::uint32_t fileVersion = 1u;
+    const std::uint32_t byteOrderMark = 0x01020304u;
+
+    // Return the message of a failed system call on path
+    std::runtime_error systemError(const char* what, const std::string& path) {
+        return std::runtime_error{std::string{what} + " " + path + ": " + std::strerror(errno)};
+    }
+
+    // Return the header of a file holding count vectors of the given dimension
+    VectorFileHeader makeHeader(std::size_t count, unsigned dimension) {
+        VectorFileHeader header;
+        std::memset(&header, 0, sizeof header);
+        std::memcpy(header.magic, fileMagic, sizeof fileMagic);
+        header.version = fileVersion;
+        header.byteOrder = byteOrderMark;
+        header.count = count;
+        header.dimension = dimension;
+        header.dataOffset = sizeof header;
+        return header;
+    }
+
+    // Owns a FILE opened for writing and reports every failure as an exception
+    class FileWriter {
+    public:
+        explicit FileWriter(const std::string& p): path{p}, file{std::fopen(p.c_str(), "wb")} {
+            if (file == nullptr)
+                throw systemError("cannot open", path);
+        }
+
+        FileWriter(const FileWriter&) = delete;
+        FileWriter& operator=(const FileWriter&) = delete;
+
+        ~FileWriter() noexcept {
+            if (file != nullptr)
+                std::fclose(file);
+        }
+
+        void write(const void* data, std::size_t bytes) {
+            if (bytes != 0u && std::fwrite(data, 1u, bytes, file) != bytes)
+                throw systemError("cannot write", path);
+        }
+
+        void close() {
+            std::FILE* f = file;
+            file = nullptr;
+            if (std::fclose(f) != 0)
+                throw systemError("cannot write", path);
+        }
+
+    private:
+        std::string path;
+        std::FILE* file;
+    };
+}
+
+/***********************************************  Writing  ************************************************************/
+
+// Write a vector to the file at path
+void evec::writeVectorFile(const std::string& path, const EuclideanVector& v) {
+    VectorFileHeader header = makeHeader(1u, v.getNumDimensions());
+    FileWriter out {path};
+    out.write(&header, sizeof header);
+    out.write(v.cbegin(), v.getNumDimensions() * sizeof(double));
+    out.close();
+}
+
+// Write every vector of a batch to the file at path
+void evec::writeVectorFile(const std::string& path, const EuclideanVectorBatch& batch) {
+    VectorFileHeader header = makeHeader(batch.size(), batch.getNumDimensions());
+    FileWriter out {path};
+    out.write(&header, sizeof header);
+    if (batch.getLayout() == EuclideanVectorBatch::Layout::RowMajor) {
+        out.write(batch.data(), batch.size() * batch.getNumDimensions() * sizeof(double));
+    } else {
+        // The file is always row-major, gather one row at a time
+        std::vector<double> row(batch.getNumDimensions());
+        for (std::size_t i = 0u; i < batch.size(); ++i) {
+            for (unsigned j = 0u; j < batch.getNumDimensions(); ++j)
+                row[j] = batch[i][j];
+            out.write(row.data(), row.size() * sizeof(double));
+        }
+    }
+    out.close();
+}
+
+// Write every vector of a batch as one line of delimiter-separated magnitudes
+void evec::writeDelimited(std::ostream& os, const EuclideanVectorBatch& batch, char delimiter) {
+    // One line at a time goes through the stream, formatted into a reused buffer
+    std::vector<char> line(batch.getNumDimensions() * (maxMagnitudeLength + 1u) + 1u);
+    for (std::size_t i = 0u; i < batch.size(); ++i) {
+        EuclideanVectorBatch::ConstRow row = batch[i];
+        NumericLocaleScope locale;
+        char* out = line.data();
+        for (unsigned j = 0u; j < row.getNumDimensions(); ++j) {
+            if (j != 0u)
+                *out++ = delimiter;
+            out = formatMagnitude(row[j], out);
+        }
+        *out++ = '\n';
+        os.write(line.data(), out - line.data());
+    }
+}
+
+/***********************************************  Reading  ************************************************************/
+
+// Read lines of delimiter-separated magnitudes into a row-major batch
+EuclideanVectorBatch evec::readDelimited(std::istream& is, char delimiter, MemoryResource* r) {
+    std::vector<double> magnitudes;
+    std::size_t dimension = 0u;
+    std::size_t count = 0u;
+    std::string line;
+    for (std::size_t lineNumber = 1u; std::getline(is, line); ++lineNumber) {
+        std::size_t fields = parseDelimitedLine(line.data(), line.data() + line.size(), delimiter, lineNumber, magnitudes);
+        if (fields == 0u)
+            continue;
+
+        if (count == 0u)
+            dimension = fields;
+        else if (fields != dimension)
+            throw std::runtime_error{"line " + std::to_string(lineNumber) + " has " + std::to_string(fields) +
+                                     " magnitudes, expected " + std::to_string(dimension)};
+        ++count;
+    }
+    if (is.bad())
+        throw std::runtime_error{"cannot read delimited vectors"};
+
+    EuclideanVectorBatch batch {count, static_cast<unsigned>(dimension), EuclideanVectorBatch::Layout::RowMajor, r};
+    std::copy(magnitudes.cbegin(), magnitudes.cend(), batch.data());
+    return batch;
+}
+
+/***************************************  Constructors and destructors  ***********************************************/
+
+// Constructor that maps the file at path
+MappedVectorFile::MappedVectorFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw systemError("cannot open", path);
+
+    struct stat status;
+    if (::fstat(fd, &status) != 0) {
+        std::runtime_error error = systemError("cannot stat", path);
+        ::close(fd);
+        throw error;
+    }
+    if (static_cast<std::size_t>(status.st_size) < sizeof(VectorFileHeader)) {
+        ::close(fd);
+        throw std::runtime_error{path + " is too short to be a vector file"};
+    }
+
+    mappingSize = static_cast<std::size_t>(status.st_size);
+    mapping = ::mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file
+    int mapError = errno;
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        errno = mapError;
+        throw systemError("cannot map", path);
+    }
+
+    const VectorFileHeader* header = static_cast<const VectorFileHeader*>(mapping);
+    const char* problem = nullptr;
+    if (std::memcmp(header->magic, fileMagic, sizeof fileMagic) != 0)
+        problem = " is not a vector file";
+    else if (header->version != fileVersion)
+        problem = " has an unsupported version";
+    else if (header->byteOrder != byteOrderMark)
+        problem = " was written on a machine with a different byte order";
+    else if (header->dataOffset < sizeof(VectorFileHeader) || header->dataOffset % alignof(double) != 0u ||
+             header->dataOffset > mappingSize)
+        problem = " has a corrupt header";
+    else if (header->dimension != 0u &&
+             header->count > (mappingSize - header->dataOffset) / sizeof(double) / header->dimension)
+        problem = " is shorter than its header says";
+    if (problem != nullptr) {
+        unmap();
+        throw std::runtime_error{path + problem};
+    }
+
+    count = static_cast<std::size_t>(header->count);
+    dimension = header->dimension;
+    magnitudes = reinterpret_cast<const double*>(static_cast<const char*>(mapping) + header->dataOffset);
+}
+
+// Move Constructor
+MappedVectorFile::MappedVectorFile(MappedVectorFile&& other) noexcept:
+        mapping{other.mapping}, mappingSize{other.mappingSize}, magnitudes{other.magnitudes},
+        count{other.count}, dimension{other.dimension} {
+    other.mapping = nullptr;
+    other.mappingSize = 0u;
+    other.magnitudes = nullptr;
+    other.count = 0u;
+}
+
+// Move Assignment
+MappedVectorFile& MappedVectorFile::operator=(MappedVectorFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        mapping = other.mapping;
+        mappingSize = other.mappingSize;
+        magnitudes = other.magnitudes;
+        count = other.count;
+        dimension = other.dimension;
+        other.mapping = nullptr;
+        other.mappingSize = 0u;
+        other.magnitudes = nullptr;
+        other.count = 0u;
+    }
+    return *this;
+}
+
+// Destructor
+MappedVectorFile::~MappedVectorFile() noexcept { unmap(); }
+
+/***********************************************  Member Functions  ***************************************************/
+
+// Ask the OS to start reading the whole file in the background
+void MappedVectorFile::prefetch() const {
+    if (mapping != nullptr)
+        ::madvise(mapping, mappingSize, MADV_WILLNEED);
+}
+
+// Unmap the file
+void MappedVectorFile::unmap() {
+    if (mapping != nullptr)
+        ::munmap(mapping, mappingSize);
+    mapping = nullptr;
+    mappingSize = 0u;
+    magnitudes = nullptr;
+    count = 0u;
+}
@@ -0,0 +1,99 @@
+#ifndef A2_EUCLIDEANVECTORFILE_H
+#define A2_EUCLIDEANVECTORFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "EuclideanVector.h"
+#include "EuclideanVectorBatch.h"
+#include "EuclideanVectorView.h"
+
+// File formats for vectors: delimited text (CSV, TSV) for logs and interchange, and a binary
+// format for one EuclideanVector or an EuclideanVectorBatch. A binary file starts with a
+// 64-byte header followed by count * dimension doubles in row-major order, starting at a 64-byte
+// aligned offset, so a mapped file can be used in place without parsing. Magnitudes are stored in
+// the byte order of the machine that wrote the file, which the header records.
+namespace evec {
+    struct VectorFileHeader {
+        char magic[8]; // "EVECBIN" followed by a zero byte
+        std::uint32_t version; // Format version, currently 1
+        std::uint32_t byteOrder; // 0x01020304 as written by the producing machine
+        std::uint64_t count; // Number of vectors
+        std::uint32_t dimension; // Number of dimensions of every vector
+        std::uint32_t reserved; // Zero
+        std::uint64_t dataOffset; // Offset of the first magnitude from the start of the file
+        char padding[24]; // Zero, pads the header to 64 bytes
+    };
+
+    static_assert(sizeof(VectorFileHeader) == 64u, "the header must stay 64 bytes");
+
+    // Write a vector to the file at path, replacing its contents. Throws std::runtime_error on failure.
+    void writeVectorFile(const std::string& path, const EuclideanVector&);
+
+    // Write every vector of a batch to the file at path, replacing its contents. Throws std::runtime_error on failure.
+    void writeVectorFile(const std::string& path, const EuclideanVectorBatch&);
+
+    // Write every vector of a batch as one line of delimiter-separated magnitudes (',' for CSV,
+    // '\t' for TSV). Magnitudes are written with formatMagnitude, so readDelimited reads them back exactly.
+    void writeDelimited(std::ostream&, const EuclideanVectorBatch&, char delimiter = ',');
+
+    // Read lines of delimiter-separated magnitudes until the end of the stream into a row-major batch.
+    // Blank lines are skipped and spaces around magnitudes are ignored. Throws std::runtime_error
+    // naming the line if a field is not a number or a line has a different number of magnitudes
+    // than the first one.
+    EuclideanVectorBatch readDelimited(std::istream&, char delimiter = ',', MemoryResource* = getDefaultResource());
+
+    // Read-only memory mapping of a file written by writeVectorFile. Vectors are returned as views
+    // into the mapping, so opening a file costs one header check and the magnitudes are paged in
+    // by the OS as they are touched. Views must not outlive the MappedVectorFile.
+    class MappedVectorFile {
+    public:
+        // Constructor that maps the file at path. Throws std::runtime_error if the file cannot be
+        // mapped, is not a vector file, has an unknown version, comes from a machine with a
+        // different byte order, or is shorter than its header says.
+        explicit MappedVectorFile(const std::string& path);
+
+        MappedVectorFile(const MappedVectorFile&) = delete;
+        MappedVectorFile& operator=(const MappedVectorFile&) = delete;
+
+        // Move Constructor
+        MappedVectorFile(MappedVectorFile&&) noexcept;
+
+        // Move Assignment
+        MappedVectorFile& operator=(MappedVectorFile&&) noexcept;
+
+        // Destructor
+        ~MappedVectorFile() noexcept;
+
+        // Subscript Operator
+        ConstEuclideanVectorView operator[](std::size_t i) const {
+            return ConstEuclideanVectorView{magnitudes + i * dimension, dimension};
+        }
+
+        // Return the number of vectors
+        std::size_t size() const { return count; }
+
+        // Return the number of dimensions of every vector
+        unsigned getNumDimensions() const { return dimension; }
+
+        // Return the size() * getNumDimensions() magnitudes in row-major order
+        const double* data() const { return magnitudes; }
+
+        // Ask the OS to start reading the whole file in the background
+        void prefetch() const;
+
+    private:
+        void* mapping = nullptr; // Start of the mapped file
+        std::size_t mappingSize = 0u; // Size of the mapping in bytes
+        const double* magnitudes = nullptr; // First magnitude of the first vector
+        std::size_t count = 0u; // Number of vectors
+        unsigned dimension = 0u; // Number of dimensions of every vector
+
+        // Unmap the file
+        void unmap();
+    };
+}
+#endif
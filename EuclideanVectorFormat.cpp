@@ -0,0 +1,212 @@
+#include "EuclideanVectorFormat.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <locale.h>
+#include <stdlib.h>
+
+using namespace evec;
+
+namespace {
+    // Return the C locale, whose '.' decimal point is used whatever locale the program set
+    locale_t cLocale() {
+        static const locale_t locale = newlocale(LC_NUMERIC_MASK, "C", static_cast<locale_t>(0));
+        return locale;
+    }
+
+    // Significant digits of a magnitude and the decimal exponent of the first one, as %e writes them
+    struct Digits {
+        char digits[17];
+        int count;
+        int exponent;
+    };
+
+    // Read the digits and exponent of text written by snprintf's %.<n>e
+    void readScientific(const char* text, Digits& d) {
+        d.count = 0;
+        for (; *text != 'e'; ++text) {
+            if (std::isdigit(static_cast<unsigned char>(*text)))
+                d.digits[d.count++] = *text;
+        }
+        d.exponent = std::atoi(text + 1);
+    }
+
+    // Round the 17 digits of all to count digits in rounded. Return false if the dropped digits are
+    // a 5 followed by zeros: 17 digits are only within half a unit of the value, which may lie on
+    // either side of that tie.
+    bool roundDigits(const Digits& all, int count, Digits& rounded) {
+        bool tie = all.digits[count] == '5';
+        for (int i = count + 1; i < all.count; ++i)
+            tie = tie && all.digits[i] == '0';
+        if (tie)
+            return false;
+
+        std::memcpy(rounded.digits, all.digits, static_cast<std::size_t>(count));
+        rounded.count = count;
+        rounded.exponent = all.exponent;
+        if (all.digits[count] >= '5') {
+            int i = count - 1;
+            for (; i >= 0 && rounded.digits[i] == '9'; --i)
+                rounded.digits[i] = '0';
+            if (i >= 0) {
+                ++rounded.digits[i];
+            } else {
+                rounded.digits[0] = '1';
+                ++rounded.exponent;
+            }
+        }
+        return true;
+    }
+
+    // Write d the way %.<d.count>g does: fixed notation for exponents from -4 to below the number of
+    // digits, scientific otherwise, without trailing zeros. Return one past the last character.
+    char* writeGeneral(bool negative, const Digits& d, char* out) {
+        int count = d.count;
+        while (count > 1 && d.digits[count - 1] == '0')
+            --count;
+        if (negative)
+            *out++ = '-';
+
+        const int e = d.exponent;
+        if (e >= -4 && e < d.count) {
+            if (e < 0) {
+                *out++ = '0';
+                *out++ = '.';
+                for (int i = -1; i > e; --i)
+                    *out++ = '0';
+                std::memcpy(out, d.digits, static_cast<std::size_t>(count));
+                return out + count;
+            }
+            for (int i = 0; i <= e; ++i)
+                *out++ = i < count ? d.digits[i] : '0';
+            if (count > e + 1) {
+                *out++ = '.';
+                std::memcpy(out, d.digits + e + 1, static_cast<std::size_t>(count - e - 1));
+                out += count - e - 1;
+            }
+            return out;
+        }
+
+        *out++ = d.digits[0];
+        if (count > 1) {
+            *out++ = '.';
+            std::memcpy(out, d.digits + 1, static_cast<std::size_t>(count - 1));
+            out += count - 1;
+        }
+        *out++ = 'e';
+        *out++ = e < 0 ? '-' : '+';
+        const int magnitude = e < 0 ? -e : e;
+        if (magnitude >= 100)
+            *out++ = static_cast<char>('0' + magnitude / 100);
+        *out++ = static_cast<char>('0' + magnitude / 10 % 10);
+        *out++ = static_cast<char>('0' + magnitude % 10);
+        return out;
+    }
+}
+
+// Constructor that switches the calling thread to the C locale, remembering the one it had
+NumericLocaleScope::NumericLocaleScope(): previous{uselocale(cLocale())} {}
+
+// Destructor that gives the calling thread its previous locale back
+NumericLocaleScope::~NumericLocaleScope() {
+    uselocale(previous);
+}
+
+// Write the shortest text that reads back to m
+char* evec::formatMagnitude(double m, char* out) {
+    char text[32];
+    if (!std::isfinite(m)) {
+        int length = std::snprintf(text, sizeof text, "%g", m);
+        std::memcpy(out, text, static_cast<std::size_t>(length));
+        return out + length;
+    }
+
+    // One conversion gives the 17 significant digits that always read back to m. Shorter roundings
+    // are made from those digits and checked with strtod, 16 digits first because 15 can only read
+    // back if 16 do. snprintf is most of the cost, so it only runs again for ties.
+    const bool negative = std::signbit(m);
+    std::snprintf(text, sizeof text, "%.16e", m);
+    Digits all;
+    readScientific(text, all);
+    char* end = writeGeneral(negative, all, out);
+    for (int count = 16; count >= 15; --count) {
+        Digits rounded;
+        if (!roundDigits(all, count, rounded)) {
+            std::snprintf(text, sizeof text, "%.*e", count - 1, m);
+            readScientific(text, rounded);
+        }
+        char candidate[maxMagnitudeLength + 1u];
+        char* candidateEnd = writeGeneral(negative, rounded, candidate);
+        *candidateEnd = '\0';
+        if (std::strtod(candidate, nullptr) != m)
+            break;
+        std::memcpy(out, candidate, static_cast<std::size_t>(candidateEnd - candidate));
+        end = out + (candidateEnd - candidate);
+    }
+    return end;
+}
+
+// Parse a magnitude at the start of [first, last)
+const char* evec::parseMagnitude(const char* first, const char* last, double& m) {
+    // strtod needs a terminating null, so copy the characters a number can be made of
+    const char* end = first;
+    while (end != last && (std::isalnum(static_cast<unsigned char>(*end)) || *end == '.' || *end == '+' || *end == '-'))
+        ++end;
+    std::size_t length = static_cast<std::size_t>(end - first);
+    if (length == 0u)
+        return nullptr;
+
+    char shortText[64];
+    std::string longText;
+    const char* text = shortText;
+    if (length < sizeof shortText) {
+        std::memcpy(shortText, first, length);
+        shortText[length] = '\0';
+    } else {
+        longText.assign(first, end);
+        text = longText.c_str();
+    }
+
+    char* parsed;
+    double value = strtod_l(text, &parsed, cLocale());
+    if (parsed == text)
+        return nullptr;
+    m = value;
+    return first + (parsed - text);
+}
+
+// Parse one line of delimiter-separated magnitudes and append them to out
+std::size_t evec::parseDelimitedLine(const char* first, const char* last, char delimiter, std::size_t lineNumber,
+                                     std::vector<double>& out) {
+    auto skipSpaces = [&first, last, delimiter] {
+        while (first != last && *first != delimiter && std::isspace(static_cast<unsigned char>(*first)))
+            ++first;
+    };
+    skipSpaces();
+    if (first == last)
+        return 0u;
+
+    std::size_t fields = 0u;
+    while (true) {
+        double m;
+        const char* end = parseMagnitude(first, last, m);
+        if (end == nullptr)
+            throw std::runtime_error{"line " + std::to_string(lineNumber) + ": field " + std::to_string(fields + 1u) + " is not a number"};
+        out.push_back(m);
+        ++fields;
+        first = end;
+        skipSpaces();
+        if (first == last)
+            return fields;
+        if (*first != delimiter)
+            throw std::runtime_error{"line " + std::to_string(lineNumber) + ": expected a delimiter after field " + std::to_string(fields)};
+        ++first;
+        skipSpaces();
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef A2_EUCLIDEANVECTORFORMAT_H
+#define A2_EUCLIDEANVECTORFORMAT_H
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include <locale.h>
+
+// Conversion of magnitudes to and from text without going through iostream formatting.
+// Magnitudes are written with the fewest significant digits that read back to exactly the same
+// double, so text written by these functions round-trips. Both directions always use the C
+// locale's notation (a '.' decimal point), whatever locale is imbued in the streams or set with
+// setlocale, so files written under one locale read back under any other.
+namespace evec {
+    // Most characters formatMagnitude writes for one magnitude
+    constexpr std::size_t maxMagnitudeLength = 24u;
+
+    // Switches the calling thread's numeric locale to the C locale until it goes out of scope.
+    // snprintf has no version that takes a locale and uselocale is not free, so callers take one
+    // scope around a whole vector or line rather than one per magnitude. Other threads are left alone.
+    class NumericLocaleScope {
+    public:
+        NumericLocaleScope();
+        ~NumericLocaleScope();
+
+        NumericLocaleScope(const NumericLocaleScope&) = delete;
+        NumericLocaleScope& operator=(const NumericLocaleScope&) = delete;
+
+    private:
+        locale_t previous;
+    };
+
+    // Write the shortest text that reads back to m into out, which must have room for
+    // maxMagnitudeLength characters. No terminating null is written. Return one past the last character.
+    // The calling thread must hold a NumericLocaleScope.
+    char* formatMagnitude(double m, char* out);
+
+    // Parse a magnitude at the start of [first, last), store it in m and return one past its last
+    // character. Return nullptr and leave m unchanged if the range does not start with a number.
+    const char* parseMagnitude(const char* first, const char* last, double& m);
+
+    // Parse one line of delimiter-separated magnitudes in [first, last), ignoring spaces around them,
+    // and append them to out. Return the number of magnitudes, zero for a blank line. Throws
+    // std::runtime_error naming lineNumber and the field if the line is malformed.
+    std::size_t parseDelimitedLine(const char* first, const char* last, char delimiter, std::size_t lineNumber,
+                                   std::vector<double>& out);
+
+    // Write a vector expression as "[m0 m1 ...]" to os, formatting through a buffer on the stack
+    template <typename E>
+    std::ostream& printMagnitudes(std::ostream& os, const E& v) {
+        NumericLocaleScope locale;
+        char buffer[1024];
+        char* out = buffer;
+        *out++ = '[';
+        for (unsigned i = 0u; i < v.getNumDimensions(); ++i) {
+            if (static_cast<std::size_t>(buffer + sizeof buffer - out) < maxMagnitudeLength + 2u) {
+                os.write(buffer, out - buffer);
+                out = buffer;
+            }
+            if (i != 0u)
+                *out++ = ' ';
+            out = formatMagnitude(v[i], out);
+        }
+        *out++ = ']';
+        return os.write(buffer, out - buffer);
+    }
+}
+#endif
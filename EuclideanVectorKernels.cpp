@@ -0,0 +1,1523 @@
+#include "EuclideanVectorKernels.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <numeric>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define EVEC_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+using namespace evec;
+
+namespace {
+    // Function pointers of one implementation of every kernel
+    struct KernelTable {
+        const char* name;
+        void (*add)(double*, const double*, std::size_t);
+        void (*subtract)(double*, const double*, std::size_t);
+        void (*scale)(double*, double, std::size_t);
+        double (*dot)(const double*, const double*, std::size_t);
+        double (*sumOfSquares)(const double*, std::size_t);
+        double (*squaredDistance)(const double*, const double*, std::size_t);
+        double (*manhattanDistance)(const double*, const double*, std::size_t);
+        double (*chebyshevDistance)(const double*, const double*, std::size_t);
+        kernels::DotAndNorms (*dotAndNorms)(const double*, const double*, std::size_t);
+        void (*dotBlock)(const double*, std::size_t, const double*, std::size_t, std::size_t, std::size_t, double*, std::size_t);
+        void (*widenFloat)(const float*, double*, std::size_t);
+        void (*widenInt)(const int*, double*, std::size_t);
+        void (*addFloat)(float*, const float*, std::size_t);
+        void (*subtractFloat)(float*, const float*, std::size_t);
+        void (*scaleFloat)(float*, float, std::size_t);
+        float (*dotFloat)(const float*, const float*, std::size_t);
+        float (*sumOfSquaresFloat)(const float*, std::size_t);
+        void (*halfToFloat)(const Half*, float*, std::size_t);
+        void (*floatToHalf)(const float*, Half*, std::size_t);
+        void (*bfloat16ToFloat)(const BFloat16*, float*, std::size_t);
+        void (*floatToBFloat16)(const float*, BFloat16*, std::size_t);
+        std::int32_t (*dotInt8)(const std::int8_t*, const std::int8_t*, std::size_t);
+        std::int32_t (*squaredDistanceInt8)(const std::int8_t*, const std::int8_t*, std::size_t);
+    };
+
+    // Block of dot products computed one pair at a time, for the levels without a register-blocked
+    // version and for the rows and columns left over by the levels that have one
+    template <double (*Dot)(const double*, const double*, std::size_t)>
+    void dotBlockPairs(const double* a, std::size_t rows, const double* b, std::size_t columns, std::size_t n,
+                       std::size_t stride, double* out, std::size_t outStride) {
+        for (std::size_t i = 0u; i < rows; ++i)
+            for (std::size_t j = 0u; j < columns; ++j)
+                out[i * outStride + j] += Dot(a + i * stride, b + j * stride, n);
+    }
+
+/*************************************************  Scalar kernels  ***************************************************/
+
+    void addScalar(double* dst, const double* src, std::size_t n) {
+        for (std::size_t i = 0u; i < n; ++i)
+            dst[i] += src[i];
+    }
+
+    void subtractScalar(double* dst, const double* src, std::size_t n) {
+        for (std::size_t i = 0u; i < n; ++i)
+            dst[i] -= src[i];
+    }
+
+    void scaleScalar(double* dst, double k, std::size_t n) {
+        for (std::size_t i = 0u; i < n; ++i)
+            dst[i] *= k;
+    }
+
+    double dotScalar(const double* a, const double* b, std::size_t n) {
+        double res = 0.0;
+        for (std::size_t i = 0u; i < n; ++i)
+            res += a[i] * b[i];
+        return res;
+    }
+
+    double sumOfSquaresScalar(const double* a, std::size_t n) {
+        double res = 0.0;
+        for (std::size_t i = 0u; i < n; ++i)
+            res += a[i] * a[i];
+        return res;
+    }
+
+    double squaredDistanceScalar(const double* a, const double* b, std::size_t n) {
+        double res = 0.0;
+        for (std::size_t i = 0u; i < n; ++i) {
+            double d = a[i] - b[i];
+            res += d * d;
+        }
+        return res;
+    }
+
+    double manhattanDistanceScalar(const double* a, const double* b, std::size_t n) {
+        double res = 0.0;
+        for (std::size_t i = 0u; i < n; ++i)
+            res += std::abs(a[i] - b[i]);
+        return res;
+    }
+
+    double chebyshevDistanceScalar(const double* a, const double* b, std::size_t n) {
+        double res = 0.0;
+        for (std::size_t i = 0u; i < n; ++i)
+            res = std::max(res, std::abs(a[i] - b[i]));
+        return res;
+    }
+
+    kernels::DotAndNorms dotAndNormsScalar(const double* a, const double* b, std::size_t n) {
+        kernels::DotAndNorms res {0.0, 0.0, 0.0};
+        for (std::size_t i = 0u; i < n; ++i) {
+            res.dot += a[i] * b[i];
+            res.squaredNormA += a[i] * a[i];
+            res.squaredNormB += b[i] * b[i];
+        }
+        return res;
+    }
+
+    void dotBlockScalar(const double* a, std::size_t rows, const double* b, std::size_t columns, std::size_t n,
+                        std::size_t stride, double* out, std::size_t outStride) {
+        dotBlockPairs<dotScalar>(a, rows, b, columns, n, stride, out, outStride);
+    }
+
+    void widenFloatScalar(const float* src, double* dst, std::size_t n) {
+        for (std::size_t i = 0u; i < n; ++i)
+            dst[i] = src[i];
+    }
+
+    void widenIntScalar(const int* src, double* dst, std::size_t n) {
+        for (std::size_t i = 0u; i < n; ++i)
+            dst[i] = src[i];
+    }
+
+    void addFloatScalar(float* dst, const float* src, std::size_t n) {
+        for (std::size_t i = 0u; i < n; ++i)
+            dst[i] += src[i];
+    }
+
+    void subtractFloatScalar(float* dst, const float* src, std::size_t n) {
+        for (std::size_t i = 0u; i < n; ++i)
+            dst[i] -= src[i];
+    }
+
+    void scaleFloatScalar(float* dst, float k, std::size_t n) {
+        for (std::size_t i = 0u; i < n; ++i)
+            dst[i] *= k;
+    }
+
+    float dotFloatScalar(const float* a, const float* b, std::size_t n) {
+        float res = 0.0f;
+        for (std::size_t i = 0u; i < n; ++i)
+            res += a[i] * b[i];
+        return res;
+    }
+
+    float sumOfSquaresFloatScalar(const float* a, std::size_t n) {
+        return dotFloatScalar(a, a, n);
+    }
+
+    void halfToFloatScalar(const Half* src, float* dst, std::size_t n) {
+        for (std::size_t i = 0u; i < n; ++i)
+            dst[i] = src[i];
+    }
+
+    void floatToHalfScalar(const float* src, Half* dst, std::size_t n) {
+        for (std::size_t i = 0u; i < n; ++i)
+            dst[i] = Half{src[i]};
+    }
+
+    void bfloat16ToFloatScalar(const BFloat16* src, float* dst, std::size_t n) {
+        for (std::size_t i = 0u; i < n; ++i)
+            dst[i] = src[i];
+    }
+
+    void floatToBFloat16Scalar(const float* src, BFloat16* dst, std::size_t n) {
+        for (std::size_t i = 0u; i < n; ++i)
+            dst[i] = BFloat16{src[i]};
+    }
+
+    std::int32_t dotInt8Scalar(const std::int8_t* a, const std::int8_t* b, std::size_t n) {
+        std::int32_t res = 0;
+        for (std::size_t i = 0u; i < n; ++i)
+            res += a[i] * b[i];
+        return res;
+    }
+
+    std::int32_t squaredDistanceInt8Scalar(const std::int8_t* a, const std::int8_t* b, std::size_t n) {
+        std::int32_t res = 0;
+        for (std::size_t i = 0u; i < n; ++i) {
+            std::int32_t d = a[i] - b[i];
+            res += d * d;
+        }
+        return res;
+    }
+
+    const KernelTable scalarKernels {"scalar", addScalar, subtractScalar, scaleScalar, dotScalar, sumOfSquaresScalar,
+                                     squaredDistanceScalar, manhattanDistanceScalar, chebyshevDistanceScalar, dotAndNormsScalar, dotBlockScalar,
+                                     widenFloatScalar, widenIntScalar,
+                                     addFloatScalar, subtractFloatScalar, scaleFloatScalar, dotFloatScalar, sumOfSquaresFloatScalar,
+                                     halfToFloatScalar, floatToHalfScalar, bfloat16ToFloatScalar, floatToBFloat16Scalar,
+                                     dotInt8Scalar, squaredDistanceInt8Scalar};
+
+#ifdef EVEC_X86_KERNELS
+
+/**************************************************  SSE2 kernels  ****************************************************/
+
+    __attribute__((target("sse2")))
+    void addSse2(double* dst, const double* src, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 2 <= n; i += 2)
+            _mm_storeu_pd(dst + i, _mm_add_pd(_mm_loadu_pd(dst + i), _mm_loadu_pd(src + i)));
+        for (; i < n; ++i)
+            dst[i] += src[i];
+    }
+
+    __attribute__((target("sse2")))
+    void subtractSse2(double* dst, const double* src, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 2 <= n; i += 2)
+            _mm_storeu_pd(dst + i, _mm_sub_pd(_mm_loadu_pd(dst + i), _mm_loadu_pd(src + i)));
+        for (; i < n; ++i)
+            dst[i] -= src[i];
+    }
+
+    __attribute__((target("sse2")))
+    void scaleSse2(double* dst, double k, std::size_t n) {
+        const __m128d factor = _mm_set1_pd(k);
+        std::size_t i = 0u;
+        for (; i + 2 <= n; i += 2)
+            _mm_storeu_pd(dst + i, _mm_mul_pd(_mm_loadu_pd(dst + i), factor));
+        for (; i < n; ++i)
+            dst[i] *= k;
+    }
+
+    __attribute__((target("sse2")))
+    double horizontalSumSse2(__m128d v) {
+        return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+    }
+
+    __attribute__((target("sse2")))
+    double dotSse2(const double* a, const double* b, std::size_t n) {
+        // Two independent accumulators hide the latency of the additions
+        __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+        std::size_t i = 0u;
+        for (; i + 4 <= n; i += 4) {
+            acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+            acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+        }
+        double res = horizontalSumSse2(_mm_add_pd(acc0, acc1));
+        for (; i < n; ++i)
+            res += a[i] * b[i];
+        return res;
+    }
+
+    __attribute__((target("sse2")))
+    double sumOfSquaresSse2(const double* a, std::size_t n) {
+        return dotSse2(a, a, n);
+    }
+
+    // |x| with the sign bits cleared
+    __attribute__((target("sse2")))
+    __m128d absSse2(__m128d x) { return _mm_andnot_pd(_mm_set1_pd(-0.0), x); }
+
+    __attribute__((target("sse2")))
+    double squaredDistanceSse2(const double* a, const double* b, std::size_t n) {
+        __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+        std::size_t i = 0u;
+        for (; i + 4 <= n; i += 4) {
+            __m128d d0 = _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i));
+            __m128d d1 = _mm_sub_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2));
+            acc0 = _mm_add_pd(acc0, _mm_mul_pd(d0, d0));
+            acc1 = _mm_add_pd(acc1, _mm_mul_pd(d1, d1));
+        }
+        double res = horizontalSumSse2(_mm_add_pd(acc0, acc1));
+        for (; i < n; ++i) {
+            double d = a[i] - b[i];
+            res += d * d;
+        }
+        return res;
+    }
+
+    __attribute__((target("sse2")))
+    double manhattanDistanceSse2(const double* a, const double* b, std::size_t n) {
+        __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+        std::size_t i = 0u;
+        for (; i + 4 <= n; i += 4) {
+            acc0 = _mm_add_pd(acc0, absSse2(_mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i))));
+            acc1 = _mm_add_pd(acc1, absSse2(_mm_sub_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2))));
+        }
+        double res = horizontalSumSse2(_mm_add_pd(acc0, acc1));
+        for (; i < n; ++i)
+            res += std::abs(a[i] - b[i]);
+        return res;
+    }
+
+    __attribute__((target("sse2")))
+    double chebyshevDistanceSse2(const double* a, const double* b, std::size_t n) {
+        __m128d acc = _mm_setzero_pd();
+        std::size_t i = 0u;
+        for (; i + 2 <= n; i += 2)
+            acc = _mm_max_pd(acc, absSse2(_mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i))));
+        double res = std::max(_mm_cvtsd_f64(acc), _mm_cvtsd_f64(_mm_unpackhi_pd(acc, acc)));
+        for (; i < n; ++i)
+            res = std::max(res, std::abs(a[i] - b[i]));
+        return res;
+    }
+
+    __attribute__((target("sse2")))
+    kernels::DotAndNorms dotAndNormsSse2(const double* a, const double* b, std::size_t n) {
+        __m128d ab = _mm_setzero_pd(), aa = _mm_setzero_pd(), bb = _mm_setzero_pd();
+        std::size_t i = 0u;
+        for (; i + 2 <= n; i += 2) {
+            __m128d x = _mm_loadu_pd(a + i), y = _mm_loadu_pd(b + i);
+            ab = _mm_add_pd(ab, _mm_mul_pd(x, y));
+            aa = _mm_add_pd(aa, _mm_mul_pd(x, x));
+            bb = _mm_add_pd(bb, _mm_mul_pd(y, y));
+        }
+        kernels::DotAndNorms res {horizontalSumSse2(ab), horizontalSumSse2(aa), horizontalSumSse2(bb)};
+        for (; i < n; ++i) {
+            res.dot += a[i] * b[i];
+            res.squaredNormA += a[i] * a[i];
+            res.squaredNormB += b[i] * b[i];
+        }
+        return res;
+    }
+
+    // Two doubles per register leave too few registers to block several rows, so pairs go one at a time
+    __attribute__((target("sse2")))
+    void dotBlockSse2(const double* a, std::size_t rows, const double* b, std::size_t columns, std::size_t n,
+                      std::size_t stride, double* out, std::size_t outStride) {
+        dotBlockPairs<dotSse2>(a, rows, b, columns, n, stride, out, outStride);
+    }
+
+    __attribute__((target("sse2")))
+    void widenFloatSse2(const float* src, double* dst, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 2 <= n; i += 2)
+            _mm_storeu_pd(dst + i, _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(src + i)))));
+        for (; i < n; ++i)
+            dst[i] = src[i];
+    }
+
+    __attribute__((target("sse2")))
+    void widenIntSse2(const int* src, double* dst, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 2 <= n; i += 2)
+            _mm_storeu_pd(dst + i, _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i))));
+        for (; i < n; ++i)
+            dst[i] = src[i];
+    }
+
+    __attribute__((target("sse2")))
+    void addFloatSse2(float* dst, const float* src, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+        for (; i < n; ++i)
+            dst[i] += src[i];
+    }
+
+    __attribute__((target("sse2")))
+    void subtractFloatSse2(float* dst, const float* src, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps(dst + i, _mm_sub_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+        for (; i < n; ++i)
+            dst[i] -= src[i];
+    }
+
+    __attribute__((target("sse2")))
+    void scaleFloatSse2(float* dst, float k, std::size_t n) {
+        const __m128 factor = _mm_set1_ps(k);
+        std::size_t i = 0u;
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(dst + i), factor));
+        for (; i < n; ++i)
+            dst[i] *= k;
+    }
+
+    __attribute__((target("sse2")))
+    float horizontalSumSse2(__m128 v) {
+        __m128 pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+
+    __attribute__((target("sse2")))
+    float dotFloatSse2(const float* a, const float* b, std::size_t n) {
+        __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+        std::size_t i = 0u;
+        for (; i + 8 <= n; i += 8) {
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        }
+        float res = horizontalSumSse2(_mm_add_ps(acc0, acc1));
+        for (; i < n; ++i)
+            res += a[i] * b[i];
+        return res;
+    }
+
+    __attribute__((target("sse2")))
+    float sumOfSquaresFloatSse2(const float* a, std::size_t n) {
+        return dotFloatSse2(a, a, n);
+    }
+
+    __attribute__((target("sse2")))
+    std::int32_t horizontalSumSse2(__m128i v) {
+        __m128i pairs = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0x4E));
+        return _mm_cvtsi128_si32(_mm_add_epi32(pairs, _mm_shuffle_epi32(pairs, 0xB1)));
+    }
+
+    // Sign-extend the low and high eight bytes of x to 16 bits
+    __attribute__((target("sse2")))
+    __m128i widenLowInt8Sse2(__m128i x) { return _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8); }
+
+    __attribute__((target("sse2")))
+    __m128i widenHighInt8Sse2(__m128i x) { return _mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8); }
+
+    __attribute__((target("sse2")))
+    std::int32_t dotInt8Sse2(const std::int8_t* a, const std::int8_t* b, std::size_t n) {
+        __m128i acc = _mm_setzero_si128();
+        std::size_t i = 0u;
+        for (; i + 16 <= n; i += 16) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(widenLowInt8Sse2(x), widenLowInt8Sse2(y)));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(widenHighInt8Sse2(x), widenHighInt8Sse2(y)));
+        }
+        std::int32_t res = horizontalSumSse2(acc);
+        for (; i < n; ++i)
+            res += a[i] * b[i];
+        return res;
+    }
+
+    __attribute__((target("sse2")))
+    std::int32_t squaredDistanceInt8Sse2(const std::int8_t* a, const std::int8_t* b, std::size_t n) {
+        __m128i acc = _mm_setzero_si128();
+        std::size_t i = 0u;
+        for (; i + 16 <= n; i += 16) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            __m128i low = _mm_sub_epi16(widenLowInt8Sse2(x), widenLowInt8Sse2(y));
+            __m128i high = _mm_sub_epi16(widenHighInt8Sse2(x), widenHighInt8Sse2(y));
+            acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_madd_epi16(low, low), _mm_madd_epi16(high, high)));
+        }
+        std::int32_t res = horizontalSumSse2(acc);
+        for (; i < n; ++i) {
+            std::int32_t d = a[i] - b[i];
+            res += d * d;
+        }
+        return res;
+    }
+
+    // SSE2 has no half conversion instructions, so this level converts 16-bit values with the scalar code
+    const KernelTable sse2Kernels {"sse2", addSse2, subtractSse2, scaleSse2, dotSse2, sumOfSquaresSse2,
+                                   squaredDistanceSse2, manhattanDistanceSse2, chebyshevDistanceSse2, dotAndNormsSse2, dotBlockSse2,
+                                   widenFloatSse2, widenIntSse2,
+                                   addFloatSse2, subtractFloatSse2, scaleFloatSse2, dotFloatSse2, sumOfSquaresFloatSse2,
+                                   halfToFloatScalar, floatToHalfScalar, bfloat16ToFloatScalar, floatToBFloat16Scalar,
+                                   dotInt8Sse2, squaredDistanceInt8Sse2};
+
+/**************************************************  AVX2 kernels  ****************************************************/
+
+    __attribute__((target("avx2,fma")))
+    void addAvx2(double* dst, const double* src, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 4 <= n; i += 4)
+            _mm256_storeu_pd(dst + i, _mm256_add_pd(_mm256_loadu_pd(dst + i), _mm256_loadu_pd(src + i)));
+        for (; i < n; ++i)
+            dst[i] += src[i];
+    }
+
+    __attribute__((target("avx2,fma")))
+    void subtractAvx2(double* dst, const double* src, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 4 <= n; i += 4)
+            _mm256_storeu_pd(dst + i, _mm256_sub_pd(_mm256_loadu_pd(dst + i), _mm256_loadu_pd(src + i)));
+        for (; i < n; ++i)
+            dst[i] -= src[i];
+    }
+
+    __attribute__((target("avx2,fma")))
+    void scaleAvx2(double* dst, double k, std::size_t n) {
+        const __m256d factor = _mm256_set1_pd(k);
+        std::size_t i = 0u;
+        for (; i + 4 <= n; i += 4)
+            _mm256_storeu_pd(dst + i, _mm256_mul_pd(_mm256_loadu_pd(dst + i), factor));
+        for (; i < n; ++i)
+            dst[i] *= k;
+    }
+
+    __attribute__((target("avx2,fma")))
+    double horizontalSumAvx2(__m256d v) {
+        __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+    }
+
+    __attribute__((target("avx2,fma")))
+    double dotAvx2(const double* a, const double* b, std::size_t n) {
+        // Four independent accumulators keep both FMA ports busy
+        __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+        __m256d acc2 = _mm256_setzero_pd(), acc3 = _mm256_setzero_pd();
+        std::size_t i = 0u;
+        for (; i + 16 <= n; i += 16) {
+            acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+            acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), acc1);
+            acc2 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 8), _mm256_loadu_pd(b + i + 8), acc2);
+            acc3 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 12), _mm256_loadu_pd(b + i + 12), acc3);
+        }
+        for (; i + 4 <= n; i += 4)
+            acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+        double res = horizontalSumAvx2(_mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3)));
+        for (; i < n; ++i)
+            res += a[i] * b[i];
+        return res;
+    }
+
+    __attribute__((target("avx2,fma")))
+    double sumOfSquaresAvx2(const double* a, std::size_t n) {
+        return dotAvx2(a, a, n);
+    }
+
+    // |x| with the sign bits cleared
+    __attribute__((target("avx2,fma")))
+    __m256d absAvx2(__m256d x) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), x); }
+
+    __attribute__((target("avx2,fma")))
+    double squaredDistanceAvx2(const double* a, const double* b, std::size_t n) {
+        __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+        __m256d acc2 = _mm256_setzero_pd(), acc3 = _mm256_setzero_pd();
+        std::size_t i = 0u;
+        for (; i + 16 <= n; i += 16) {
+            __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+            __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4));
+            __m256d d2 = _mm256_sub_pd(_mm256_loadu_pd(a + i + 8), _mm256_loadu_pd(b + i + 8));
+            __m256d d3 = _mm256_sub_pd(_mm256_loadu_pd(a + i + 12), _mm256_loadu_pd(b + i + 12));
+            acc0 = _mm256_fmadd_pd(d0, d0, acc0);
+            acc1 = _mm256_fmadd_pd(d1, d1, acc1);
+            acc2 = _mm256_fmadd_pd(d2, d2, acc2);
+            acc3 = _mm256_fmadd_pd(d3, d3, acc3);
+        }
+        for (; i + 4 <= n; i += 4) {
+            __m256d d = _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+            acc0 = _mm256_fmadd_pd(d, d, acc0);
+        }
+        double res = horizontalSumAvx2(_mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3)));
+        for (; i < n; ++i) {
+            double d = a[i] - b[i];
+            res += d * d;
+        }
+        return res;
+    }
+
+    __attribute__((target("avx2,fma")))
+    double manhattanDistanceAvx2(const double* a, const double* b, std::size_t n) {
+        __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+        std::size_t i = 0u;
+        for (; i + 8 <= n; i += 8) {
+            acc0 = _mm256_add_pd(acc0, absAvx2(_mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i))));
+            acc1 = _mm256_add_pd(acc1, absAvx2(_mm256_sub_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4))));
+        }
+        for (; i + 4 <= n; i += 4)
+            acc0 = _mm256_add_pd(acc0, absAvx2(_mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i))));
+        double res = horizontalSumAvx2(_mm256_add_pd(acc0, acc1));
+        for (; i < n; ++i)
+            res += std::abs(a[i] - b[i]);
+        return res;
+    }
+
+    __attribute__((target("avx2,fma")))
+    double chebyshevDistanceAvx2(const double* a, const double* b, std::size_t n) {
+        __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+        std::size_t i = 0u;
+        for (; i + 8 <= n; i += 8) {
+            acc0 = _mm256_max_pd(acc0, absAvx2(_mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i))));
+            acc1 = _mm256_max_pd(acc1, absAvx2(_mm256_sub_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4))));
+        }
+        for (; i + 4 <= n; i += 4)
+            acc0 = _mm256_max_pd(acc0, absAvx2(_mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i))));
+        __m128d pair = _mm_max_pd(_mm256_castpd256_pd128(_mm256_max_pd(acc0, acc1)), _mm256_extractf128_pd(_mm256_max_pd(acc0, acc1), 1));
+        double res = std::max(_mm_cvtsd_f64(pair), _mm_cvtsd_f64(_mm_unpackhi_pd(pair, pair)));
+        for (; i < n; ++i)
+            res = std::max(res, std::abs(a[i] - b[i]));
+        return res;
+    }
+
+    // Two sets of accumulators hide the latency of the FMAs
+    __attribute__((target("avx2,fma")))
+    kernels::DotAndNorms dotAndNormsAvx2(const double* a, const double* b, std::size_t n) {
+        __m256d ab0 = _mm256_setzero_pd(), aa0 = _mm256_setzero_pd(), bb0 = _mm256_setzero_pd();
+        __m256d ab1 = _mm256_setzero_pd(), aa1 = _mm256_setzero_pd(), bb1 = _mm256_setzero_pd();
+        std::size_t i = 0u;
+        for (; i + 8 <= n; i += 8) {
+            __m256d x0 = _mm256_loadu_pd(a + i), y0 = _mm256_loadu_pd(b + i);
+            __m256d x1 = _mm256_loadu_pd(a + i + 4), y1 = _mm256_loadu_pd(b + i + 4);
+            ab0 = _mm256_fmadd_pd(x0, y0, ab0);
+            aa0 = _mm256_fmadd_pd(x0, x0, aa0);
+            bb0 = _mm256_fmadd_pd(y0, y0, bb0);
+            ab1 = _mm256_fmadd_pd(x1, y1, ab1);
+            aa1 = _mm256_fmadd_pd(x1, x1, aa1);
+            bb1 = _mm256_fmadd_pd(y1, y1, bb1);
+        }
+        for (; i + 4 <= n; i += 4) {
+            __m256d x = _mm256_loadu_pd(a + i), y = _mm256_loadu_pd(b + i);
+            ab0 = _mm256_fmadd_pd(x, y, ab0);
+            aa0 = _mm256_fmadd_pd(x, x, aa0);
+            bb0 = _mm256_fmadd_pd(y, y, bb0);
+        }
+        kernels::DotAndNorms res {horizontalSumAvx2(_mm256_add_pd(ab0, ab1)), horizontalSumAvx2(_mm256_add_pd(aa0, aa1)),
+                                  horizontalSumAvx2(_mm256_add_pd(bb0, bb1))};
+        for (; i < n; ++i) {
+            res.dot += a[i] * b[i];
+            res.squaredNormA += a[i] * a[i];
+            res.squaredNormB += b[i] * b[i];
+        }
+        return res;
+    }
+
+    // Return the sums of the lanes of a, b, c and d, in that order
+    __attribute__((target("avx2,fma")))
+    __m256d horizontalSums4Avx2(__m256d a, __m256d b, __m256d c, __m256d d) {
+        __m256d ab = _mm256_hadd_pd(a, b), cd = _mm256_hadd_pd(c, d);
+        return _mm256_add_pd(_mm256_permute2f128_pd(ab, cd, 0x20), _mm256_permute2f128_pd(ab, cd, 0x31));
+    }
+
+    // Two rows of a against four rows of b at a time: eight accumulators and six loads per step fit
+    // the sixteen registers. The rows of b are the outer loop so their four rows stay in the L1 cache
+    // while the rows of a go past.
+    __attribute__((target("avx2,fma")))
+    void dotBlockAvx2(const double* a, std::size_t rows, const double* b, std::size_t columns, std::size_t n,
+                      std::size_t stride, double* out, std::size_t outStride) {
+        std::size_t j = 0u;
+        for (; j + 4 <= columns; j += 4) {
+            const double* y0 = b + j * stride;
+            const double* y1 = y0 + stride;
+            const double* y2 = y1 + stride;
+            const double* y3 = y2 + stride;
+            std::size_t i = 0u;
+            for (; i + 2 <= rows; i += 2) {
+                const double* x0 = a + i * stride;
+                const double* x1 = x0 + stride;
+                __m256d acc00 = _mm256_setzero_pd(), acc01 = _mm256_setzero_pd(), acc02 = _mm256_setzero_pd(), acc03 = _mm256_setzero_pd();
+                __m256d acc10 = _mm256_setzero_pd(), acc11 = _mm256_setzero_pd(), acc12 = _mm256_setzero_pd(), acc13 = _mm256_setzero_pd();
+                std::size_t k = 0u;
+                for (; k + 4 <= n; k += 4) {
+                    __m256d u0 = _mm256_loadu_pd(x0 + k), u1 = _mm256_loadu_pd(x1 + k);
+                    __m256d v = _mm256_loadu_pd(y0 + k);
+                    acc00 = _mm256_fmadd_pd(u0, v, acc00);
+                    acc10 = _mm256_fmadd_pd(u1, v, acc10);
+                    v = _mm256_loadu_pd(y1 + k);
+                    acc01 = _mm256_fmadd_pd(u0, v, acc01);
+                    acc11 = _mm256_fmadd_pd(u1, v, acc11);
+                    v = _mm256_loadu_pd(y2 + k);
+                    acc02 = _mm256_fmadd_pd(u0, v, acc02);
+                    acc12 = _mm256_fmadd_pd(u1, v, acc12);
+                    v = _mm256_loadu_pd(y3 + k);
+                    acc03 = _mm256_fmadd_pd(u0, v, acc03);
+                    acc13 = _mm256_fmadd_pd(u1, v, acc13);
+                }
+                double tail0[4] = {0.0, 0.0, 0.0, 0.0}, tail1[4] = {0.0, 0.0, 0.0, 0.0};
+                for (; k < n; ++k) {
+                    const double* ys[4] = {y0, y1, y2, y3};
+                    for (unsigned c = 0u; c < 4u; ++c) {
+                        tail0[c] += x0[k] * ys[c][k];
+                        tail1[c] += x1[k] * ys[c][k];
+                    }
+                }
+                double* out0 = out + i * outStride + j;
+                double* out1 = out0 + outStride;
+                __m256d sums0 = _mm256_add_pd(horizontalSums4Avx2(acc00, acc01, acc02, acc03), _mm256_loadu_pd(tail0));
+                __m256d sums1 = _mm256_add_pd(horizontalSums4Avx2(acc10, acc11, acc12, acc13), _mm256_loadu_pd(tail1));
+                _mm256_storeu_pd(out0, _mm256_add_pd(_mm256_loadu_pd(out0), sums0));
+                _mm256_storeu_pd(out1, _mm256_add_pd(_mm256_loadu_pd(out1), sums1));
+            }
+            dotBlockPairs<dotAvx2>(a + i * stride, rows - i, y0, 4u, n, stride, out + i * outStride + j, outStride);
+        }
+        dotBlockPairs<dotAvx2>(a, rows, b + j * stride, columns - j, n, stride, out + j, outStride);
+    }
+
+    __attribute__((target("avx2,fma")))
+    void widenFloatAvx2(const float* src, double* dst, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 4 <= n; i += 4)
+            _mm256_storeu_pd(dst + i, _mm256_cvtps_pd(_mm_loadu_ps(src + i)));
+        for (; i < n; ++i)
+            dst[i] = src[i];
+    }
+
+    __attribute__((target("avx2,fma")))
+    void widenIntAvx2(const int* src, double* dst, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 4 <= n; i += 4)
+            _mm256_storeu_pd(dst + i, _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+        for (; i < n; ++i)
+            dst[i] = src[i];
+    }
+
+    __attribute__((target("avx2,fma")))
+    void addFloatAvx2(float* dst, const float* src, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_loadu_ps(src + i)));
+        for (; i < n; ++i)
+            dst[i] += src[i];
+    }
+
+    __attribute__((target("avx2,fma")))
+    void subtractFloatAvx2(float* dst, const float* src, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps(dst + i, _mm256_sub_ps(_mm256_loadu_ps(dst + i), _mm256_loadu_ps(src + i)));
+        for (; i < n; ++i)
+            dst[i] -= src[i];
+    }
+
+    __attribute__((target("avx2,fma")))
+    void scaleFloatAvx2(float* dst, float k, std::size_t n) {
+        const __m256 factor = _mm256_set1_ps(k);
+        std::size_t i = 0u;
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_loadu_ps(dst + i), factor));
+        for (; i < n; ++i)
+            dst[i] *= k;
+    }
+
+    __attribute__((target("avx2,fma")))
+    float horizontalSumAvx2(__m256 v) {
+        __m128 quad = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        __m128 pairs = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+
+    __attribute__((target("avx2,fma")))
+    float dotFloatAvx2(const float* a, const float* b, std::size_t n) {
+        __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+        std::size_t i = 0u;
+        for (; i + 32 <= n; i += 32) {
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+            acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), acc2);
+            acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), acc3);
+        }
+        for (; i + 8 <= n; i += 8)
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        float res = horizontalSumAvx2(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+        for (; i < n; ++i)
+            res += a[i] * b[i];
+        return res;
+    }
+
+    __attribute__((target("avx2,fma")))
+    float sumOfSquaresFloatAvx2(const float* a, std::size_t n) {
+        return dotFloatAvx2(a, a, n);
+    }
+
+    __attribute__((target("avx2,fma,f16c")))
+    void halfToFloatAvx2(const Half* src, float* dst, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+        for (; i < n; ++i)
+            dst[i] = src[i];
+    }
+
+    __attribute__((target("avx2,fma,f16c")))
+    void floatToHalfAvx2(const float* src, Half* dst, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 8 <= n; i += 8)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+        for (; i < n; ++i)
+            dst[i] = Half{src[i]};
+    }
+
+    __attribute__((target("avx2,fma")))
+    void bfloat16ToFloatAvx2(const BFloat16* src, float* dst, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 8 <= n; i += 8) {
+            __m256i widened = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+            _mm256_storeu_ps(dst + i, _mm256_castsi256_ps(_mm256_slli_epi32(widened, 16)));
+        }
+        for (; i < n; ++i)
+            dst[i] = src[i];
+    }
+
+    __attribute__((target("avx2,fma")))
+    void floatToBFloat16Avx2(const float* src, BFloat16* dst, std::size_t n) {
+        const __m256i roundingBias = _mm256_set1_epi32(0x7FFF);
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i quietBit = _mm256_set1_epi32(0x400000);
+        std::size_t i = 0u;
+        for (; i + 8 <= n; i += 8) {
+            __m256 x = _mm256_loadu_ps(src + i);
+            __m256i bits = _mm256_castps_si256(x);
+            // Round to nearest even by adding 0x7FFF plus the lowest kept bit, NaNs are kept quiet
+            __m256i odd = _mm256_and_si256(_mm256_srli_epi32(bits, 16), one);
+            __m256i rounded = _mm256_add_epi32(bits, _mm256_add_epi32(roundingBias, odd));
+            __m256i nan = _mm256_castps_si256(_mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+            __m256i upper = _mm256_srli_epi32(_mm256_blendv_epi8(rounded, _mm256_or_si256(bits, quietBit), nan), 16);
+            // Pack the eight 32-bit lanes into 16-bit ones, packus works within 128-bit halves
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(upper, upper), 0x08);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_castsi256_si128(packed));
+        }
+        for (; i < n; ++i)
+            dst[i] = BFloat16{src[i]};
+    }
+
+    __attribute__((target("avx2,fma")))
+    std::int32_t horizontalSumAvx2(__m256i v) {
+        __m128i quad = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        __m128i pairs = _mm_add_epi32(quad, _mm_shuffle_epi32(quad, 0x4E));
+        return _mm_cvtsi128_si32(_mm_add_epi32(pairs, _mm_shuffle_epi32(pairs, 0xB1)));
+    }
+
+    // maddubs multiplies unsigned by signed bytes, so |a| is multiplied by b with the sign of a.
+    // Pairs of products stay below 2 * 127 * 127 and cannot saturate 16 bits.
+    __attribute__((target("avx2,fma")))
+    std::int32_t dotInt8Avx2(const std::int8_t* a, const std::int8_t* b, std::size_t n) {
+        const __m256i ones = _mm256_set1_epi16(1);
+        __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+        std::size_t i = 0u;
+        for (; i + 64 <= n; i += 64) {
+            __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            __m256i y0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            __m256i x1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + 32));
+            __m256i y1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i + 32));
+            __m256i p0 = _mm256_maddubs_epi16(_mm256_abs_epi8(x0), _mm256_sign_epi8(y0, x0));
+            __m256i p1 = _mm256_maddubs_epi16(_mm256_abs_epi8(x1), _mm256_sign_epi8(y1, x1));
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(p0, ones));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(p1, ones));
+        }
+        for (; i + 32 <= n; i += 32) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            __m256i p = _mm256_maddubs_epi16(_mm256_abs_epi8(x), _mm256_sign_epi8(y, x));
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(p, ones));
+        }
+        std::int32_t res = horizontalSumAvx2(_mm256_add_epi32(acc0, acc1));
+        for (; i < n; ++i)
+            res += a[i] * b[i];
+        return res;
+    }
+
+    // Differences need nine bits, so the bytes are widened to 16 bits before subtracting
+    __attribute__((target("avx2,fma")))
+    std::int32_t squaredDistanceInt8Avx2(const std::int8_t* a, const std::int8_t* b, std::size_t n) {
+        __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+        std::size_t i = 0u;
+        for (; i + 32 <= n; i += 32) {
+            __m256i d0 = _mm256_sub_epi16(_mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i))),
+                                          _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i))));
+            __m256i d1 = _mm256_sub_epi16(_mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i + 16))),
+                                          _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i + 16))));
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(d0, d0));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(d1, d1));
+        }
+        std::int32_t res = horizontalSumAvx2(_mm256_add_epi32(acc0, acc1));
+        for (; i < n; ++i) {
+            std::int32_t d = a[i] - b[i];
+            res += d * d;
+        }
+        return res;
+    }
+
+    const KernelTable avx2Kernels {"avx2", addAvx2, subtractAvx2, scaleAvx2, dotAvx2, sumOfSquaresAvx2,
+                                   squaredDistanceAvx2, manhattanDistanceAvx2, chebyshevDistanceAvx2, dotAndNormsAvx2, dotBlockAvx2,
+                                   widenFloatAvx2, widenIntAvx2,
+                                   addFloatAvx2, subtractFloatAvx2, scaleFloatAvx2, dotFloatAvx2, sumOfSquaresFloatAvx2,
+                                   halfToFloatAvx2, floatToHalfAvx2, bfloat16ToFloatAvx2, floatToBFloat16Avx2,
+                                   dotInt8Avx2, squaredDistanceInt8Avx2};
+
+/*************************************************  AVX-512 kernels  **************************************************/
+
+    // Mask selecting the first n (< 8) lanes of a 512-bit vector of doubles
+    __attribute__((target("avx512f")))
+    __mmask8 tailMask(std::size_t n) {
+        return static_cast<__mmask8>((1u << n) - 1u);
+    }
+
+    // Sum the lanes through memory. GCC's own header trips -Wuninitialized in intrinsics that start
+    // from an undefined vector (_mm512_reduce_add_pd, unmasked conversions), so the kernels below
+    // use the zero-masked forms of those intrinsics instead.
+    __attribute__((target("avx512f")))
+    double horizontalSumAvx512(__m512d v) {
+        alignas(64) double lanes[8];
+        _mm512_store_pd(lanes, v);
+        return ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+    }
+
+    __attribute__((target("avx512f")))
+    void addAvx512(double* dst, const double* src, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 8 <= n; i += 8)
+            _mm512_storeu_pd(dst + i, _mm512_add_pd(_mm512_loadu_pd(dst + i), _mm512_loadu_pd(src + i)));
+        if (i < n) {
+            __mmask8 m = tailMask(n - i);
+            _mm512_mask_storeu_pd(dst + i, m, _mm512_add_pd(_mm512_maskz_loadu_pd(m, dst + i), _mm512_maskz_loadu_pd(m, src + i)));
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    void subtractAvx512(double* dst, const double* src, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 8 <= n; i += 8)
+            _mm512_storeu_pd(dst + i, _mm512_sub_pd(_mm512_loadu_pd(dst + i), _mm512_loadu_pd(src + i)));
+        if (i < n) {
+            __mmask8 m = tailMask(n - i);
+            _mm512_mask_storeu_pd(dst + i, m, _mm512_sub_pd(_mm512_maskz_loadu_pd(m, dst + i), _mm512_maskz_loadu_pd(m, src + i)));
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    void scaleAvx512(double* dst, double k, std::size_t n) {
+        const __m512d factor = _mm512_set1_pd(k);
+        std::size_t i = 0u;
+        for (; i + 8 <= n; i += 8)
+            _mm512_storeu_pd(dst + i, _mm512_mul_pd(_mm512_loadu_pd(dst + i), factor));
+        if (i < n) {
+            __mmask8 m = tailMask(n - i);
+            _mm512_mask_storeu_pd(dst + i, m, _mm512_mul_pd(_mm512_maskz_loadu_pd(m, dst + i), factor));
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    double dotAvx512(const double* a, const double* b, std::size_t n) {
+        __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+        __m512d acc2 = _mm512_setzero_pd(), acc3 = _mm512_setzero_pd();
+        std::size_t i = 0u;
+        for (; i + 32 <= n; i += 32) {
+            acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), acc0);
+            acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8), acc1);
+            acc2 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 16), _mm512_loadu_pd(b + i + 16), acc2);
+            acc3 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 24), _mm512_loadu_pd(b + i + 24), acc3);
+        }
+        for (; i + 8 <= n; i += 8)
+            acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), acc0);
+        if (i < n) {
+            __mmask8 m = tailMask(n - i);
+            acc1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(m, a + i), _mm512_maskz_loadu_pd(m, b + i), acc1);
+        }
+        return horizontalSumAvx512(_mm512_add_pd(_mm512_add_pd(acc0, acc1), _mm512_add_pd(acc2, acc3)));
+    }
+
+    __attribute__((target("avx512f")))
+    double sumOfSquaresAvx512(const double* a, std::size_t n) {
+        return dotAvx512(a, a, n);
+    }
+
+    // |x| with the sign bits cleared (_mm512_abs_pd starts from an undefined vector, andnot_pd needs DQ)
+    __attribute__((target("avx512f")))
+    __m512d absAvx512(__m512d x) {
+        return _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(x), _mm512_set1_epi64(0x7FFFFFFFFFFFFFFF)));
+    }
+
+    __attribute__((target("avx512f")))
+    double squaredDistanceAvx512(const double* a, const double* b, std::size_t n) {
+        __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+        __m512d acc2 = _mm512_setzero_pd(), acc3 = _mm512_setzero_pd();
+        std::size_t i = 0u;
+        for (; i + 32 <= n; i += 32) {
+            __m512d d0 = _mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i));
+            __m512d d1 = _mm512_sub_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8));
+            __m512d d2 = _mm512_sub_pd(_mm512_loadu_pd(a + i + 16), _mm512_loadu_pd(b + i + 16));
+            __m512d d3 = _mm512_sub_pd(_mm512_loadu_pd(a + i + 24), _mm512_loadu_pd(b + i + 24));
+            acc0 = _mm512_fmadd_pd(d0, d0, acc0);
+            acc1 = _mm512_fmadd_pd(d1, d1, acc1);
+            acc2 = _mm512_fmadd_pd(d2, d2, acc2);
+            acc3 = _mm512_fmadd_pd(d3, d3, acc3);
+        }
+        for (; i + 8 <= n; i += 8) {
+            __m512d d = _mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i));
+            acc0 = _mm512_fmadd_pd(d, d, acc0);
+        }
+        if (i < n) {
+            __mmask8 m = tailMask(n - i);
+            __m512d d = _mm512_sub_pd(_mm512_maskz_loadu_pd(m, a + i), _mm512_maskz_loadu_pd(m, b + i));
+            acc1 = _mm512_fmadd_pd(d, d, acc1);
+        }
+        return horizontalSumAvx512(_mm512_add_pd(_mm512_add_pd(acc0, acc1), _mm512_add_pd(acc2, acc3)));
+    }
+
+    __attribute__((target("avx512f")))
+    double manhattanDistanceAvx512(const double* a, const double* b, std::size_t n) {
+        __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+        std::size_t i = 0u;
+        for (; i + 16 <= n; i += 16) {
+            acc0 = _mm512_add_pd(acc0, absAvx512(_mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i))));
+            acc1 = _mm512_add_pd(acc1, absAvx512(_mm512_sub_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8))));
+        }
+        for (; i + 8 <= n; i += 8)
+            acc0 = _mm512_add_pd(acc0, absAvx512(_mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i))));
+        if (i < n) {
+            __mmask8 m = tailMask(n - i);
+            acc1 = _mm512_add_pd(acc1, absAvx512(_mm512_sub_pd(_mm512_maskz_loadu_pd(m, a + i), _mm512_maskz_loadu_pd(m, b + i))));
+        }
+        return horizontalSumAvx512(_mm512_add_pd(acc0, acc1));
+    }
+
+    __attribute__((target("avx512f")))
+    double chebyshevDistanceAvx512(const double* a, const double* b, std::size_t n) {
+        __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+        std::size_t i = 0u;
+        for (; i + 16 <= n; i += 16) {
+            acc0 = _mm512_maskz_max_pd(0xFF, acc0, absAvx512(_mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i))));
+            acc1 = _mm512_maskz_max_pd(0xFF, acc1, absAvx512(_mm512_sub_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8))));
+        }
+        for (; i + 8 <= n; i += 8)
+            acc0 = _mm512_maskz_max_pd(0xFF, acc0, absAvx512(_mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i))));
+        if (i < n) {
+            __mmask8 m = tailMask(n - i);
+            acc1 = _mm512_maskz_max_pd(0xFF, acc1, absAvx512(_mm512_sub_pd(_mm512_maskz_loadu_pd(m, a + i), _mm512_maskz_loadu_pd(m, b + i))));
+        }
+        alignas(64) double lanes[8];
+        _mm512_store_pd(lanes, _mm512_maskz_max_pd(0xFF, acc0, acc1));
+        return *std::max_element(lanes, lanes + 8);
+    }
+
+    __attribute__((target("avx512f")))
+    kernels::DotAndNorms dotAndNormsAvx512(const double* a, const double* b, std::size_t n) {
+        __m512d ab0 = _mm512_setzero_pd(), aa0 = _mm512_setzero_pd(), bb0 = _mm512_setzero_pd();
+        __m512d ab1 = _mm512_setzero_pd(), aa1 = _mm512_setzero_pd(), bb1 = _mm512_setzero_pd();
+        std::size_t i = 0u;
+        for (; i + 16 <= n; i += 16) {
+            __m512d x0 = _mm512_loadu_pd(a + i), y0 = _mm512_loadu_pd(b + i);
+            __m512d x1 = _mm512_loadu_pd(a + i + 8), y1 = _mm512_loadu_pd(b + i + 8);
+            ab0 = _mm512_fmadd_pd(x0, y0, ab0);
+            aa0 = _mm512_fmadd_pd(x0, x0, aa0);
+            bb0 = _mm512_fmadd_pd(y0, y0, bb0);
+            ab1 = _mm512_fmadd_pd(x1, y1, ab1);
+            aa1 = _mm512_fmadd_pd(x1, x1, aa1);
+            bb1 = _mm512_fmadd_pd(y1, y1, bb1);
+        }
+        for (; i < n; i += 8) {
+            __mmask8 m = n - i >= 8u ? static_cast<__mmask8>(0xFF) : tailMask(n - i);
+            __m512d x = _mm512_maskz_loadu_pd(m, a + i), y = _mm512_maskz_loadu_pd(m, b + i);
+            ab0 = _mm512_fmadd_pd(x, y, ab0);
+            aa0 = _mm512_fmadd_pd(x, x, aa0);
+            bb0 = _mm512_fmadd_pd(y, y, bb0);
+        }
+        return kernels::DotAndNorms {horizontalSumAvx512(_mm512_add_pd(ab0, ab1)), horizontalSumAvx512(_mm512_add_pd(aa0, aa1)),
+                                     horizontalSumAvx512(_mm512_add_pd(bb0, bb1))};
+    }
+
+    // Return the sum of the upper and lower halves of v
+    __attribute__((target("avx512f")))
+    __m256d foldAvx512(__m512d v) {
+        return _mm256_add_pd(_mm512_maskz_extractf64x4_pd(0xF, v, 0), _mm512_maskz_extractf64x4_pd(0xF, v, 1));
+    }
+
+    // Return the sums of the lanes of a, b, c and d, in that order
+    __attribute__((target("avx512f")))
+    __m256d horizontalSums4Avx512(__m512d a, __m512d b, __m512d c, __m512d d) {
+        __m256d ab = _mm256_hadd_pd(foldAvx512(a), foldAvx512(b)), cd = _mm256_hadd_pd(foldAvx512(c), foldAvx512(d));
+        return _mm256_add_pd(_mm256_permute2f128_pd(ab, cd, 0x20), _mm256_permute2f128_pd(ab, cd, 0x31));
+    }
+
+    // accK += uK * v for K = 0..3: one row of b against four rows of a
+    __attribute__((target("avx512f")))
+    void fmaddColumnAvx512(__m512d v, __m512d u0, __m512d u1, __m512d u2, __m512d u3,
+                           __m512d& acc0, __m512d& acc1, __m512d& acc2, __m512d& acc3) {
+        acc0 = _mm512_fmadd_pd(u0, v, acc0);
+        acc1 = _mm512_fmadd_pd(u1, v, acc1);
+        acc2 = _mm512_fmadd_pd(u2, v, acc2);
+        acc3 = _mm512_fmadd_pd(u3, v, acc3);
+    }
+
+    // Four rows of a against four rows of b at a time: sixteen accumulators and five live loads fit
+    // the 32 registers, with one masked step for the end of the rows
+    __attribute__((target("avx512f")))
+    void dotBlockAvx512(const double* a, std::size_t rows, const double* b, std::size_t columns, std::size_t n,
+                        std::size_t stride, double* out, std::size_t outStride) {
+        std::size_t j = 0u;
+        for (; j + 4 <= columns; j += 4) {
+            const double* y0 = b + j * stride;
+            const double* y1 = y0 + stride;
+            const double* y2 = y1 + stride;
+            const double* y3 = y2 + stride;
+            std::size_t i = 0u;
+            for (; i + 4 <= rows; i += 4) {
+                const double* x0 = a + i * stride;
+                const double* x1 = x0 + stride;
+                const double* x2 = x1 + stride;
+                const double* x3 = x2 + stride;
+                __m512d acc00 = _mm512_setzero_pd(), acc01 = _mm512_setzero_pd(), acc02 = _mm512_setzero_pd(), acc03 = _mm512_setzero_pd();
+                __m512d acc10 = _mm512_setzero_pd(), acc11 = _mm512_setzero_pd(), acc12 = _mm512_setzero_pd(), acc13 = _mm512_setzero_pd();
+                __m512d acc20 = _mm512_setzero_pd(), acc21 = _mm512_setzero_pd(), acc22 = _mm512_setzero_pd(), acc23 = _mm512_setzero_pd();
+                __m512d acc30 = _mm512_setzero_pd(), acc31 = _mm512_setzero_pd(), acc32 = _mm512_setzero_pd(), acc33 = _mm512_setzero_pd();
+                for (std::size_t k = 0u; k < n; k += 8) {
+                    __mmask8 m = n - k >= 8u ? static_cast<__mmask8>(0xFF) : tailMask(n - k);
+                    __m512d u0 = _mm512_maskz_loadu_pd(m, x0 + k), u1 = _mm512_maskz_loadu_pd(m, x1 + k);
+                    __m512d u2 = _mm512_maskz_loadu_pd(m, x2 + k), u3 = _mm512_maskz_loadu_pd(m, x3 + k);
+                    fmaddColumnAvx512(_mm512_maskz_loadu_pd(m, y0 + k), u0, u1, u2, u3, acc00, acc10, acc20, acc30);
+                    fmaddColumnAvx512(_mm512_maskz_loadu_pd(m, y1 + k), u0, u1, u2, u3, acc01, acc11, acc21, acc31);
+                    fmaddColumnAvx512(_mm512_maskz_loadu_pd(m, y2 + k), u0, u1, u2, u3, acc02, acc12, acc22, acc32);
+                    fmaddColumnAvx512(_mm512_maskz_loadu_pd(m, y3 + k), u0, u1, u2, u3, acc03, acc13, acc23, acc33);
+                }
+                double* out0 = out + i * outStride + j;
+                double* out1 = out0 + outStride;
+                double* out2 = out1 + outStride;
+                double* out3 = out2 + outStride;
+                _mm256_storeu_pd(out0, _mm256_add_pd(_mm256_loadu_pd(out0), horizontalSums4Avx512(acc00, acc01, acc02, acc03)));
+                _mm256_storeu_pd(out1, _mm256_add_pd(_mm256_loadu_pd(out1), horizontalSums4Avx512(acc10, acc11, acc12, acc13)));
+                _mm256_storeu_pd(out2, _mm256_add_pd(_mm256_loadu_pd(out2), horizontalSums4Avx512(acc20, acc21, acc22, acc23)));
+                _mm256_storeu_pd(out3, _mm256_add_pd(_mm256_loadu_pd(out3), horizontalSums4Avx512(acc30, acc31, acc32, acc33)));
+            }
+            dotBlockPairs<dotAvx512>(a + i * stride, rows - i, y0, 4u, n, stride, out + i * outStride + j, outStride);
+        }
+        dotBlockPairs<dotAvx512>(a, rows, b + j * stride, columns - j, n, stride, out + j, outStride);
+    }
+
+    __attribute__((target("avx512f")))
+    void widenFloatAvx512(const float* src, double* dst, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 8 <= n; i += 8)
+            _mm512_storeu_pd(dst + i, _mm512_maskz_cvtps_pd(0xFF, _mm256_loadu_ps(src + i)));
+        for (; i < n; ++i)
+            dst[i] = src[i];
+    }
+
+    __attribute__((target("avx512f")))
+    void widenIntAvx512(const int* src, double* dst, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 8 <= n; i += 8)
+            _mm512_storeu_pd(dst + i, _mm512_maskz_cvtepi32_pd(0xFF, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i))));
+        for (; i < n; ++i)
+            dst[i] = src[i];
+    }
+
+    // Mask selecting the first n (< 16) lanes of a 512-bit vector of floats
+    __attribute__((target("avx512f")))
+    __mmask16 tailMaskFloat(std::size_t n) {
+        return static_cast<__mmask16>((1u << n) - 1u);
+    }
+
+    __attribute__((target("avx512f")))
+    float horizontalSumAvx512(__m512 v) {
+        alignas(64) float lanes[16];
+        _mm512_store_ps(lanes, v);
+        float res = 0.0f;
+        for (float lane : lanes)
+            res += lane;
+        return res;
+    }
+
+    __attribute__((target("avx512f")))
+    void addFloatAvx512(float* dst, const float* src, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 16 <= n; i += 16)
+            _mm512_storeu_ps(dst + i, _mm512_add_ps(_mm512_loadu_ps(dst + i), _mm512_loadu_ps(src + i)));
+        if (i < n) {
+            __mmask16 m = tailMaskFloat(n - i);
+            _mm512_mask_storeu_ps(dst + i, m, _mm512_add_ps(_mm512_maskz_loadu_ps(m, dst + i), _mm512_maskz_loadu_ps(m, src + i)));
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    void subtractFloatAvx512(float* dst, const float* src, std::size_t n) {
+        std::size_t i = 0u;
+        for (; i + 16 <= n; i += 16)
+            _mm512_storeu_ps(dst + i, _mm512_sub_ps(_mm512_loadu_ps(dst + i), _mm512_loadu_ps(src + i)));
+        if (i < n) {
+            __mmask16 m = tailMaskFloat(n - i);
+            _mm512_mask_storeu_ps(dst + i, m, _mm512_sub_ps(_mm512_maskz_loadu_ps(m, dst + i), _mm512_maskz_loadu_ps(m, src + i)));
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    void scaleFloatAvx512(float* dst, float k, std::size_t n) {
+        const __m512 factor = _mm512_set1_ps(k);
+        std::size_t i = 0u;
+        for (; i + 16 <= n; i += 16)
+            _mm512_storeu_ps(dst + i, _mm512_mul_ps(_mm512_loadu_ps(dst + i), factor));
+        if (i < n) {
+            __mmask16 m = tailMaskFloat(n - i);
+            _mm512_mask_storeu_ps(dst + i, m, _mm512_mul_ps(_mm512_maskz_loadu_ps(m, dst + i), factor));
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    float dotFloatAvx512(const float* a, const float* b, std::size_t n) {
+        __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+        __m512 acc2 = _mm512_setzero_ps(), acc3 = _mm512_setzero_ps();
+        std::size_t i = 0u;
+        for (; i + 64 <= n; i += 64) {
+            acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+            acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), acc1);
+            acc2 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 32), _mm512_loadu_ps(b + i + 32), acc2);
+            acc3 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 48), _mm512_loadu_ps(b + i + 48), acc3);
+        }
+        for (; i + 16 <= n; i += 16)
+            acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+        if (i < n) {
+            __mmask16 m = tailMaskFloat(n - i);
+            acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, a + i), _mm512_maskz_loadu_ps(m, b + i), acc1);
+        }
+        return horizontalSumAvx512(_mm512_add_ps(_mm512_add_ps(acc0, acc1), _mm512_add_ps(acc2, acc3)));
+    }
+
+    __attribute__((target("avx512f")))
+    float sumOfSquaresFloatAvx512(const float* a, std::size_t n) {
+        return dotFloatAvx512(a, a, n);
+    }
+
+    // Conversions of 16-bit values are bound by memory, so this level reuses the AVX2 ones. The int8
+    // kernels need AVX-512 BW, which avx512f does not imply, and are only replaced at the VNNI level.
+    const KernelTable avx512Kernels {"avx512", addAvx512, subtractAvx512, scaleAvx512, dotAvx512, sumOfSquaresAvx512,
+                                     squaredDistanceAvx512, manhattanDistanceAvx512, chebyshevDistanceAvx512, dotAndNormsAvx512, dotBlockAvx512,
+                                     widenFloatAvx512, widenIntAvx512,
+                                     addFloatAvx512, subtractFloatAvx512, scaleFloatAvx512, dotFloatAvx512, sumOfSquaresFloatAvx512,
+                                     halfToFloatAvx2, floatToHalfAvx2, bfloat16ToFloatAvx2, floatToBFloat16Avx2,
+                                     dotInt8Avx2, squaredDistanceInt8Avx2};
+
+/*************************************************  AVX-512 VNNI kernels  *********************************************/
+
+    // Mask selecting the first n (< 64) bytes of a 512-bit vector
+    __attribute__((target("avx512f,avx512bw")))
+    __mmask64 tailMaskInt8(std::size_t n) {
+        return (static_cast<__mmask64>(1u) << n) - 1u;
+    }
+
+    __attribute__((target("avx512f")))
+    std::int64_t horizontalSumAvx512(__m512i v) {
+        alignas(64) std::int32_t lanes[16];
+        _mm512_store_si512(lanes, v);
+        std::int64_t res = 0;
+        for (std::int32_t lane : lanes)
+            res += lane;
+        return res;
+    }
+
+    // vpdpbusd multiplies unsigned by signed bytes and adds groups of four products to 32-bit lanes,
+    // so |a| is multiplied by b with the sign of a
+    __attribute__((target("avx512f,avx512bw,avx512vnni")))
+    __m512i dotInt8Vnni(__m512i acc, __m512i x, __m512i y) {
+        __m512i signedY = _mm512_mask_sub_epi8(y, _mm512_movepi8_mask(x), _mm512_setzero_si512(), y);
+        return _mm512_dpbusd_epi32(acc, _mm512_abs_epi8(x), signedY);
+    }
+
+    __attribute__((target("avx512f,avx512bw,avx512vnni")))
+    std::int32_t dotInt8Avx512Vnni(const std::int8_t* a, const std::int8_t* b, std::size_t n) {
+        __m512i acc0 = _mm512_setzero_si512(), acc1 = _mm512_setzero_si512();
+        std::size_t i = 0u;
+        for (; i + 128 <= n; i += 128) {
+            acc0 = dotInt8Vnni(acc0, _mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+            acc1 = dotInt8Vnni(acc1, _mm512_loadu_si512(a + i + 64), _mm512_loadu_si512(b + i + 64));
+        }
+        for (; i + 64 <= n; i += 64)
+            acc0 = dotInt8Vnni(acc0, _mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+        if (i < n) {
+            __mmask64 m = tailMaskInt8(n - i);
+            acc1 = dotInt8Vnni(acc1, _mm512_maskz_loadu_epi8(m, a + i), _mm512_maskz_loadu_epi8(m, b + i));
+        }
+        return static_cast<std::int32_t>(horizontalSumAvx512(_mm512_add_epi32(acc0, acc1)));
+    }
+
+    // The squared distance is expanded to a.a + b.b - 2 a.b, three products of bytes that fit vpdpbusd
+    __attribute__((target("avx512f,avx512bw,avx512vnni")))
+    std::int32_t squaredDistanceInt8Avx512Vnni(const std::int8_t* a, const std::int8_t* b, std::size_t n) {
+        __m512i squares = _mm512_setzero_si512(), products = _mm512_setzero_si512();
+        std::size_t i = 0u;
+        for (; i < n; i += 64) {
+            __mmask64 m = n - i >= 64u ? ~static_cast<__mmask64>(0u) : tailMaskInt8(n - i);
+            __m512i x = _mm512_maskz_loadu_epi8(m, a + i);
+            __m512i y = _mm512_maskz_loadu_epi8(m, b + i);
+            __m512i absX = _mm512_abs_epi8(x), absY = _mm512_abs_epi8(y);
+            squares = _mm512_dpbusd_epi32(_mm512_dpbusd_epi32(squares, absX, absX), absY, absY);
+            products = dotInt8Vnni(products, x, y);
+        }
+        return static_cast<std::int32_t>(horizontalSumAvx512(squares) - 2 * horizontalSumAvx512(products));
+    }
+
+    // Same as the AVX-512 kernels, with the int8 kernels replaced
+    KernelTable makeAvx512VnniKernels() {
+        KernelTable table = avx512Kernels;
+        table.name = "avx512vnni";
+        table.dotInt8 = dotInt8Avx512Vnni;
+        table.squaredDistanceInt8 = squaredDistanceInt8Avx512Vnni;
+        return table;
+    }
+
+    const KernelTable avx512VnniKernels = makeAvx512VnniKernels();
+
+#endif
+
+    // Pick the fastest kernels supported by both the CPU and the EVEC_KERNELS cap
+    const KernelTable& selectKernels() {
+        const char* cap = std::getenv("EVEC_KERNELS");
+        auto allowed = [cap] (const char* name) {
+            if (cap == nullptr)
+                return true;
+            for (const char* isa : {"avx512vnni", "avx512", "avx2", "sse2", "scalar"}) {
+                if (std::strcmp(isa, cap) == 0)
+                    return true;   // the cap comes first, so name is no faster than the cap
+                if (std::strcmp(isa, name) == 0)
+                    return false;
+            }
+            return true;           // unknown cap, ignore it
+        };
+        (void) allowed;
+
+#ifdef EVEC_X86_KERNELS
+        __builtin_cpu_init();
+        bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c");
+        bool vnni = __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vnni");
+        if (allowed("avx512vnni") && avx2 && __builtin_cpu_supports("avx512f") && vnni)
+            return avx512VnniKernels;
+        if (allowed("avx512") && avx2 && __builtin_cpu_supports("avx512f"))
+            return avx512Kernels;
+        if (allowed("avx2") && avx2)
+            return avx2Kernels;
+        if (allowed("sse2") && __builtin_cpu_supports("sse2"))
+            return sse2Kernels;
+#endif
+        return scalarKernels;
+    }
+
+    // Kernels used by this process, chosen on first use
+    const KernelTable& activeKernels() {
+        static const KernelTable& selected = selectKernels();
+        return selected;
+    }
+}
+
+void kernels::add(double* dst, const double* src, std::size_t n) {
+    activeKernels().add(dst, src, n);
+}
+
+void kernels::subtract(double* dst, const double* src, std::size_t n) {
+    activeKernels().subtract(dst, src, n);
+}
+
+void kernels::scale(double* dst, double k, std::size_t n) {
+    activeKernels().scale(dst, k, n);
+}
+
+double kernels::dot(const double* a, const double* b, std::size_t n) {
+    return activeKernels().dot(a, b, n);
+}
+
+double kernels::sumOfSquares(const double* a, std::size_t n) {
+    return activeKernels().sumOfSquares(a, n);
+}
+
+double kernels::squaredDistance(const double* a, const double* b, std::size_t n) {
+    return activeKernels().squaredDistance(a, b, n);
+}
+
+kernels::DotAndNorms kernels::dotAndNorms(const double* a, const double* b, std::size_t n) {
+    return activeKernels().dotAndNorms(a, b, n);
+}
+
+void kernels::dotBlock(const double* a, std::size_t rows, const double* b, std::size_t columns, std::size_t n,
+                       std::size_t stride, double* out, std::size_t outStride) {
+    activeKernels().dotBlock(a, rows, b, columns, n, stride, out, outStride);
+}
+
+double kernels::manhattanDistance(const double* a, const double* b, std::size_t n) {
+    return activeKernels().manhattanDistance(a, b, n);
+}
+
+double kernels::chebyshevDistance(const double* a, const double* b, std::size_t n) {
+    return activeKernels().chebyshevDistance(a, b, n);
+}
+
+void kernels::widen(const float* src, double* dst, std::size_t n) {
+    activeKernels().widenFloat(src, dst, n);
+}
+
+void kernels::widen(const int* src, double* dst, std::size_t n) {
+    activeKernels().widenInt(src, dst, n);
+}
+
+void kernels::add(float* dst, const float* src, std::size_t n) {
+    activeKernels().addFloat(dst, src, n);
+}
+
+void kernels::subtract(float* dst, const float* src, std::size_t n) {
+    activeKernels().subtractFloat(dst, src, n);
+}
+
+void kernels::scale(float* dst, float k, std::size_t n) {
+    activeKernels().scaleFloat(dst, k, n);
+}
+
+float kernels::dot(const float* a, const float* b, std::size_t n) {
+    return activeKernels().dotFloat(a, b, n);
+}
+
+float kernels::sumOfSquares(const float* a, std::size_t n) {
+    return activeKernels().sumOfSquaresFloat(a, n);
+}
+
+void kernels::convert(const Half* src, float* dst, std::size_t n) {
+    activeKernels().halfToFloat(src, dst, n);
+}
+
+void kernels::convert(const float* src, Half* dst, std::size_t n) {
+    activeKernels().floatToHalf(src, dst, n);
+}
+
+void kernels::convert(const BFloat16* src, float* dst, std::size_t n) {
+    activeKernels().bfloat16ToFloat(src, dst, n);
+}
+
+void kernels::convert(const float* src, BFloat16* dst, std::size_t n) {
+    activeKernels().floatToBFloat16(src, dst, n);
+}
+
+namespace {
+    // Number of 16-bit values converted to float at a time, small enough for the stack and the L1 cache
+    const std::size_t conversionBlock = 256u;
+
+    // Return the dot product of two 16-bit arrays, converting them to float a block at a time
+    template <typename T>
+    float dotConverted(const T* a, const T* b, std::size_t n) {
+        float x[conversionBlock], y[conversionBlock];
+        float res = 0.0f;
+        for (std::size_t i = 0u; i < n; i += conversionBlock) {
+            std::size_t m = std::min(conversionBlock, n - i);
+            kernels::convert(a + i, x, m);
+            kernels::convert(b + i, y, m);
+            res += kernels::dot(x, y, m);
+        }
+        return res;
+    }
+
+    // Return the sum of squares of a 16-bit array, converting it to float a block at a time
+    template <typename T>
+    float sumOfSquaresConverted(const T* a, std::size_t n) {
+        float x[conversionBlock];
+        float res = 0.0f;
+        for (std::size_t i = 0u; i < n; i += conversionBlock) {
+            std::size_t m = std::min(conversionBlock, n - i);
+            kernels::convert(a + i, x, m);
+            res += kernels::sumOfSquares(x, m);
+        }
+        return res;
+    }
+}
+
+float kernels::dot(const Half* a, const Half* b, std::size_t n) {
+    return dotConverted(a, b, n);
+}
+
+float kernels::dot(const BFloat16* a, const BFloat16* b, std::size_t n) {
+    return dotConverted(a, b, n);
+}
+
+float kernels::sumOfSquares(const Half* a, std::size_t n) {
+    return sumOfSquaresConverted(a, n);
+}
+
+float kernels::sumOfSquares(const BFloat16* a, std::size_t n) {
+    return sumOfSquaresConverted(a, n);
+}
+
+namespace {
+    // Number of int8 elements whose squared differences (up to 254 * 254 each) fit the 32-bit kernels
+    const std::size_t int8Chunk = 1u << 15;
+}
+
+std::int64_t kernels::dot(const std::int8_t* a, const std::int8_t* b, std::size_t n) {
+    std::int64_t res = 0;
+    for (std::size_t i = 0u; i < n; i += int8Chunk)
+        res += activeKernels().dotInt8(a + i, b + i, std::min(int8Chunk, n - i));
+    return res;
+}
+
+std::int64_t kernels::squaredDistance(const std::int8_t* a, const std::int8_t* b, std::size_t n) {
+    std::int64_t res = 0;
+    for (std::size_t i = 0u; i < n; i += int8Chunk)
+        res += activeKernels().squaredDistanceInt8(a + i, b + i, std::min(int8Chunk, n - i));
+    return res;
+}
+
+double kernels::parallelDot(const double* a, const double* b, std::size_t n) {
+    if (n < EVEC_PARALLEL_THRESHOLD)
+        return dot(a, b, n);
+
+    // Each thread reduces a slice, and the slices are combined in order so the result is repeatable
+    ThreadPool& pool = ThreadPool::instance();
+    std::vector<double> partial(pool.chunkCount(n, EVEC_PARALLEL_THRESHOLD / 4u), 0.0);
+    pool.parallelFor(n, EVEC_PARALLEL_THRESHOLD / 4u, [&] (std::size_t chunk, std::size_t begin, std::size_t end) {
+        partial[chunk] = dot(a + begin, b + begin, end - begin);
+    });
+    return std::accumulate(partial.begin(), partial.end(), 0.0);
+}
+
+kernels::DotAndNorms kernels::parallelDotAndNorms(const double* a, const double* b, std::size_t n) {
+    if (n < EVEC_PARALLEL_THRESHOLD)
+        return dotAndNorms(a, b, n);
+
+    ThreadPool& pool = ThreadPool::instance();
+    std::vector<DotAndNorms> partial(pool.chunkCount(n, EVEC_PARALLEL_THRESHOLD / 4u), DotAndNorms{0.0, 0.0, 0.0});
+    pool.parallelFor(n, EVEC_PARALLEL_THRESHOLD / 4u, [&] (std::size_t chunk, std::size_t begin, std::size_t end) {
+        partial[chunk] = dotAndNorms(a + begin, b + begin, end - begin);
+    });
+    DotAndNorms res {0.0, 0.0, 0.0};
+    for (const DotAndNorms& p : partial) {
+        res.dot += p.dot;
+        res.squaredNormA += p.squaredNormA;
+        res.squaredNormB += p.squaredNormB;
+    }
+    return res;
+}
+
+double kernels::parallelSumOfSquares(const double* a, std::size_t n) {
+    if (n < EVEC_PARALLEL_THRESHOLD)
+        return sumOfSquares(a, n);
+
+    ThreadPool& pool = ThreadPool::instance();
+    std::vector<double> partial(pool.chunkCount(n, EVEC_PARALLEL_THRESHOLD / 4u), 0.0);
+    pool.parallelFor(n, EVEC_PARALLEL_THRESHOLD / 4u, [&] (std::size_t chunk, std::size_t begin, std::size_t end) {
+        partial[chunk] = sumOfSquares(a + begin, end - begin);
+    });
+    return std::accumulate(partial.begin(), partial.end(), 0.0);
+}
+
+const char* kernels::instructionSet() {
+    return activeKernels().name;
+}
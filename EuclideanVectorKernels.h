@@ -0,0 +1,105 @@
+#ifndef A2_EUCLIDEANVECTORKERNELS_H
+#define A2_EUCLIDEANVECTORKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "EuclideanVectorScalar.h"
+
+// Reductions over at least this many elements are split across the thread pool
+#ifndef EVEC_PARALLEL_THRESHOLD
+#define EVEC_PARALLEL_THRESHOLD (1u << 18)
+#endif
+
+// Loops over magnitude arrays used by EuclideanVector. Each kernel has a scalar version and,
+// on x86, SSE2, AVX2 and AVX-512 versions (plus AVX-512 VNNI for the int8 kernels). The fastest
+// version supported by the CPU is picked once, the first time any kernel is called. Setting the
+// environment variable EVEC_KERNELS to scalar, sse2, avx2, avx512 or avx512vnni caps the
+// selection (useful for comparing the versions).
+namespace evec {
+    namespace kernels {
+        // Dot product of two arrays and the sum of squares of each
+        struct DotAndNorms {
+            double dot;
+            double squaredNormA;
+            double squaredNormB;
+        };
+
+        // dst[i] += src[i]
+        void add(double* dst, const double* src, std::size_t n);
+
+        // dst[i] -= src[i]
+        void subtract(double* dst, const double* src, std::size_t n);
+
+        // dst[i] *= k
+        void scale(double* dst, double k, std::size_t n);
+
+        // Return the sum of a[i] * b[i]
+        double dot(const double* a, const double* b, std::size_t n);
+
+        // Return the sum of a[i] * a[i]
+        double sumOfSquares(const double* a, std::size_t n);
+
+        // Return the dot product and both sums of squares, computed in one pass over the arrays
+        DotAndNorms dotAndNorms(const double* a, const double* b, std::size_t n);
+
+        // out[i * outStride + j] += the dot product of row i of a with row j of b, for i < rows and
+        // j < columns, where every row is n magnitudes long and rows start stride magnitudes apart.
+        // Several rows of each side are multiplied together in registers, so every magnitude loaded
+        // takes part in several products (the micro-kernel of PairwiseDistances.h).
+        void dotBlock(const double* a, std::size_t rows, const double* b, std::size_t columns, std::size_t n,
+                      std::size_t stride, double* out, std::size_t outStride);
+
+        // Return the sum of (a[i] - b[i])^2, without storing the differences
+        double squaredDistance(const double* a, const double* b, std::size_t n);
+
+        // Return the sum of |a[i] - b[i]|
+        double manhattanDistance(const double* a, const double* b, std::size_t n);
+
+        // Return the largest |a[i] - b[i]|, zero for empty arrays
+        double chebyshevDistance(const double* a, const double* b, std::size_t n);
+
+        // dst[i] = src[i], converting to double
+        void widen(const float* src, double* dst, std::size_t n);
+        void widen(const int* src, double* dst, std::size_t n);
+
+        // Single-precision versions of the kernels above, accumulating in float
+        void add(float* dst, const float* src, std::size_t n);
+        void subtract(float* dst, const float* src, std::size_t n);
+        void scale(float* dst, float k, std::size_t n);
+        float dot(const float* a, const float* b, std::size_t n);
+        float sumOfSquares(const float* a, std::size_t n);
+
+        // dst[i] = src[i], converting between 16-bit storage and float (F16C for halves where available)
+        void convert(const Half* src, float* dst, std::size_t n);
+        void convert(const float* src, Half* dst, std::size_t n);
+        void convert(const BFloat16* src, float* dst, std::size_t n);
+        void convert(const float* src, BFloat16* dst, std::size_t n);
+
+        // dot and sumOfSquares of 16-bit arrays, converted to float a block at a time and accumulated in float
+        float dot(const Half* a, const Half* b, std::size_t n);
+        float dot(const BFloat16* a, const BFloat16* b, std::size_t n);
+        float sumOfSquares(const Half* a, std::size_t n);
+        float sumOfSquares(const BFloat16* a, std::size_t n);
+
+        // Return the sum of a[i] * b[i] over int8 codes, which must lie in [-127, 127]
+        // (AVX2 maddubs, AVX-512 VNNI where available)
+        std::int64_t dot(const std::int8_t* a, const std::int8_t* b, std::size_t n);
+
+        // Return the sum of (a[i] - b[i])^2 over int8 codes, which must lie in [-127, 127]
+        std::int64_t squaredDistance(const std::int8_t* a, const std::int8_t* b, std::size_t n);
+
+        // Same as dot, but arrays of at least EVEC_PARALLEL_THRESHOLD elements are reduced on several threads
+        double parallelDot(const double* a, const double* b, std::size_t n);
+
+        // Same as dotAndNorms, but arrays of at least EVEC_PARALLEL_THRESHOLD elements are reduced on several threads
+        DotAndNorms parallelDotAndNorms(const double* a, const double* b, std::size_t n);
+
+        // Same as sumOfSquares, but arrays of at least EVEC_PARALLEL_THRESHOLD elements are reduced on several threads
+        double parallelSumOfSquares(const double* a, std::size_t n);
+
+        // Return the name of the instruction set the kernels were dispatched to
+        const char* instructionSet();
+    }
+}
+#endif
@@ -0,0 +1,121 @@
+#ifndef A2_EUCLIDEANVECTORSCALAR_H
+#define A2_EUCLIDEANVECTORSCALAR_H
+
+#include <cstdint>
+#include <cstring>
+
+// 16-bit floating point storage types. They only store magnitudes: reading one converts it to
+// float, and arithmetic on them happens in float. Bulk conversions of arrays go through the
+// vectorized kernels (see EuclideanVectorKernels.h), these conversions are for single elements.
+namespace evec {
+    namespace detail {
+        inline std::uint32_t floatBits(float f) {
+            std::uint32_t bits;
+            std::memcpy(&bits, &f, sizeof bits);
+            return bits;
+        }
+
+        inline float bitsFloat(std::uint32_t bits) {
+            float f;
+            std::memcpy(&f, &bits, sizeof f);
+            return f;
+        }
+
+        // Round a float to the nearest IEEE half (ties to even), overflowing to infinity
+        inline std::uint16_t floatToHalf(float f) {
+            std::uint32_t x = floatBits(f);
+            std::uint32_t sign = x & 0x80000000u;
+            x ^= sign;
+            std::uint32_t h;
+            if (x >= (127u + 16u) << 23) {
+                // Infinity, NaN or too large for a half
+                h = x > 0x7F800000u ? 0x7E00u : 0x7C00u;
+            } else if (x < (127u - 14u) << 23) {
+                // Subnormal half or zero: let the float adder do the rounding
+                const std::uint32_t magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+                h = floatBits(bitsFloat(x) + bitsFloat(magic)) - magic;
+            } else {
+                // Normal half: rebias the exponent and round the dropped 13 bits to even
+                std::uint32_t odd = (x >> 13) & 1u;
+                x += ((15u - 127u) << 23) + 0xFFFu + odd;
+                h = x >> 13;
+            }
+            return static_cast<std::uint16_t>(h | (sign >> 16));
+        }
+
+        // Return the float equal to an IEEE half
+        inline float halfToFloat(std::uint16_t h) {
+            const std::uint32_t exponentMask = 0x7C00u << 13;
+            std::uint32_t x = (h & 0x7FFFu) << 13;
+            std::uint32_t exponent = x & exponentMask;
+            x += (127u - 15u) << 23;
+            if (exponent == exponentMask) {
+                // Infinity or NaN
+                x += (128u - 16u) << 23;
+            } else if (exponent == 0u) {
+                // Subnormal half or zero: renormalise with the float subtracter
+                x += 1u << 23;
+                x = floatBits(bitsFloat(x) - bitsFloat(113u << 23));
+            }
+            return bitsFloat(x | (static_cast<std::uint32_t>(h & 0x8000u) << 16));
+        }
+
+        // Round a float to the nearest bfloat16 (ties to even), keeping NaNs quiet NaNs
+        inline std::uint16_t floatToBFloat16(float f) {
+            std::uint32_t x = floatBits(f);
+            if ((x & 0x7FFFFFFFu) > 0x7F800000u)
+                return static_cast<std::uint16_t>((x >> 16) | 0x40u);
+            return static_cast<std::uint16_t>((x + 0x7FFFu + ((x >> 16) & 1u)) >> 16);
+        }
+
+        // Return the float equal to a bfloat16
+        inline float bfloat16ToFloat(std::uint16_t b) {
+            return bitsFloat(static_cast<std::uint32_t>(b) << 16);
+        }
+    }
+
+    // IEEE 754 binary16: 11 significant bits, range about 6e-8 to 65504
+    class Half {
+    public:
+        Half() = default;
+
+        // Constructor that rounds a float to the nearest half
+        explicit Half(float f): bits{detail::floatToHalf(f)} {}
+
+        // Type Conversion Operator (float, exact)
+        operator float() const { return detail::halfToFloat(bits); }
+
+        // Return the half with the given bit pattern
+        static Half fromBits(std::uint16_t b) { Half h; h.bits = b; return h; }
+
+        // Return the bit pattern
+        std::uint16_t getBits() const { return bits; }
+
+    private:
+        std::uint16_t bits;
+    };
+
+    // bfloat16: the upper half of a float, 8 significant bits with the full float range
+    class BFloat16 {
+    public:
+        BFloat16() = default;
+
+        // Constructor that rounds a float to the nearest bfloat16
+        explicit BFloat16(float f): bits{detail::floatToBFloat16(f)} {}
+
+        // Type Conversion Operator (float, exact)
+        operator float() const { return detail::bfloat16ToFloat(bits); }
+
+        // Return the bfloat16 with the given bit pattern
+        static BFloat16 fromBits(std::uint16_t b) { BFloat16 h; h.bits = b; return h; }
+
+        // Return the bit pattern
+        std::uint16_t getBits() const { return bits; }
+
+    private:
+        std::uint16_t bits;
+    };
+
+    static_assert(sizeof(Half) == 2u && sizeof(BFloat16) == 2u, "16-bit scalars must be stored in 2 bytes");
+}
+#endif
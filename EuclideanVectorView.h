@@ -0,0 +1,125 @@
+#ifndef A2_EUCLIDEANVECTORVIEW_H
+#define A2_EUCLIDEANVECTORVIEW_H
+
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+#include "EuclideanVector.h"
+#include "EuclideanVectorExpression.h"
+#include "EuclideanVectorKernels.h"
+
+namespace evec {
+    // Non-owning view of contiguous magnitudes held elsewhere (an mmap'd file, a network buffer,
+    // a std::vector). T is double for a mutable view and const double for a read-only view.
+    // Views are vector expressions, so the dot product, getEuclideanNorm, equality, printing and
+    // the arithmetic operators work on them without copying. Assigning a view rebinds it, use
+    // assign() or the compound assignment operators to write through a mutable view.
+    template <typename T>
+    class BasicEuclideanVectorView : public VectorExpression<BasicEuclideanVectorView<T>> {
+    public:
+        // Constructor that takes the first magnitude and the number of dimensions
+        BasicEuclideanVectorView(T* first, unsigned n): head{first}, numberOfDimension{n} {}
+
+        // Constructor that views the elements of a std::vector
+        template <typename V, typename = typename std::enable_if<std::is_same<V, std::vector<double>>::value ||
+                                                                   std::is_same<V, const std::vector<double>>::value>::type>
+        BasicEuclideanVectorView(V& v): head{v.data()}, numberOfDimension{static_cast<unsigned>(v.size())} {}
+
+        // Constructor that views the magnitudes of an EuclideanVector (read-only views only, so the
+        // vector's cached norm and copy-on-write sharing stay correct)
+        template <typename U = T, typename = typename std::enable_if<std::is_const<U>::value>::type>
+        BasicEuclideanVectorView(const EuclideanVector& v): head{v.cbegin()}, numberOfDimension{v.getNumDimensions()} {}
+
+        // Conversion from a mutable view to a read-only view
+        template <typename U, typename = typename std::enable_if<std::is_same<const U, T>::value>::type>
+        BasicEuclideanVectorView(const BasicEuclideanVectorView<U>& other): head{other.data()}, numberOfDimension{other.getNumDimensions()} {}
+
+        // Subscript Operator
+        T& operator[](unsigned i) const { return head[i]; }
+
+        // Write the value of an expression through the view
+        template <typename E>
+        const BasicEuclideanVectorView& assign(const VectorExpression<E>& expr) const {
+            static_assert(!std::is_const<T>::value, "cannot write through a read-only view");
+            for (unsigned i = 0u; i < numberOfDimension; ++i)
+                head[i] = expr.self()[i];
+            return *this;
+        }
+
+        // Compound Assignment Operator (+=)
+        template <typename E>
+        const BasicEuclideanVectorView& operator+=(const VectorExpression<E>& expr) const {
+            static_assert(!std::is_const<T>::value, "cannot write through a read-only view");
+            accumulate(expr.self(), false, IsContiguousExpression<E>{});
+            return *this;
+        }
+
+        // Compound Assignment Operator (-=)
+        template <typename E>
+        const BasicEuclideanVectorView& operator-=(const VectorExpression<E>& expr) const {
+            static_assert(!std::is_const<T>::value, "cannot write through a read-only view");
+            accumulate(expr.self(), true, IsContiguousExpression<E>{});
+            return *this;
+        }
+
+        // Compound Assignment Operator (*=)
+        const BasicEuclideanVectorView& operator*=(double k) const {
+            static_assert(!std::is_const<T>::value, "cannot write through a read-only view");
+            kernels::scale(head, k, numberOfDimension);
+            return *this;
+        }
+
+        // Compound Assignment Operator (/=)
+        const BasicEuclideanVectorView& operator/=(double k) const {
+            return *this *= (1 / k);
+        }
+
+        // Return the number of dimensions
+        unsigned getNumDimensions() const { return numberOfDimension; }
+
+        // Return the value of magnitude in the dimension given as the function parameter
+        double get(unsigned i) const { return head[i]; }
+
+        // Return the euclidean norm
+        double getEuclideanNorm() const {
+            return std::sqrt(kernels::parallelSumOfSquares(head, numberOfDimension));
+        }
+
+        // Return a pointer to the first magnitude
+        T* data() const { return head; }
+
+        // return a const pointer to the head of the magnitudes array
+        const double* cbegin() const { return head; }
+
+        // return a const pointer to the tail of the magnitudes array
+        const double* cend() const { return head + numberOfDimension; }
+
+    private:
+        T* head; // First magnitude
+        unsigned numberOfDimension; // Number of dimensions
+
+        // add or subtract a contiguous operand with the SIMD kernels
+        template <typename E>
+        void accumulate(const E& e, bool subtracting, std::true_type) const {
+            if (subtracting)
+                kernels::subtract(head, e.cbegin(), numberOfDimension);
+            else
+                kernels::add(head, e.cbegin(), numberOfDimension);
+        }
+
+        // add or subtract an operand evaluated element by element
+        template <typename E>
+        void accumulate(const E& e, bool subtracting, std::false_type) const {
+            for (unsigned i = 0u; i < numberOfDimension; ++i)
+                head[i] += subtracting ? -e[i] : e[i];
+        }
+    };
+
+    using EuclideanVectorView = BasicEuclideanVectorView<double>;
+    using ConstEuclideanVectorView = BasicEuclideanVectorView<const double>;
+
+    template <typename T>
+    struct IsContiguousExpression<BasicEuclideanVectorView<T>> : std::true_type {};
+}
+#endif
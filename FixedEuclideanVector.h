@@ -0,0 +1,174 @@
+#ifndef A2_FIXEDEUCLIDEANVECTOR_H
+#define A2_FIXEDEUCLIDEANVECTOR_H
+
+#include <cstddef>
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include "EuclideanVector.h"
+
+namespace evec {
+    // Euclidean vector whose number of dimensions is fixed at compile time.
+    // The magnitudes live inside the object and every loop has a constant trip count,
+    // so the compiler can unroll and vectorize it.
+    template <std::size_t N>
+    class FixedEuclideanVector {
+        static_assert(N > 0, "FixedEuclideanVector needs at least one dimension");
+
+    public:
+        // Default constructor (all magnitudes are zero)
+        FixedEuclideanVector() { std::fill(begin(), end(), 0.0); }
+
+        // Constructor that initialises the magnitude in each dimension as the argument
+        explicit FixedEuclideanVector(double m) { std::fill(begin(), end(), m); }
+
+        // Constructor that takes a initialiser list of doubles, missing dimensions are zero.
+        // Throws std::invalid_argument if there are more than N of them.
+        FixedEuclideanVector(std::initializer_list<double> list) {
+            if (list.size() > N)
+                throw std::invalid_argument{"too many magnitudes for a FixedEuclideanVector"};
+            std::fill(std::copy(list.begin(), list.end(), begin()), end(), 0.0);
+        }
+
+        // Type Conversion Constructor (EuclideanVector). Throws std::invalid_argument unless it has N dimensions.
+        explicit FixedEuclideanVector(const EuclideanVector& other) {
+            if (other.getNumDimensions() != N)
+                throw std::invalid_argument{"a FixedEuclideanVector needs a vector of the same number of dimensions"};
+            for (std::size_t i = 0u; i < N; ++i)
+                magnitudes[i] = other[static_cast<int>(i)];
+        }
+
+        // Subscript Operator (set)
+        double& operator[](std::size_t i) { return magnitudes[i]; }
+
+        // Subscript Operator (get)
+        double operator[](std::size_t i) const { return magnitudes[i]; }
+
+        // Compound Assignment Operator (+=)
+        FixedEuclideanVector& operator+=(const FixedEuclideanVector& other) {
+            for (std::size_t i = 0u; i < N; ++i)
+                magnitudes[i] += other.magnitudes[i];
+            return *this;
+        }
+
+        // Compound Assignment Operator (-=)
+        FixedEuclideanVector& operator-=(const FixedEuclideanVector& other) {
+            for (std::size_t i = 0u; i < N; ++i)
+                magnitudes[i] -= other.magnitudes[i];
+            return *this;
+        }
+
+        // Compound Assignment Operator (*=)
+        FixedEuclideanVector& operator*=(double k) {
+            for (std::size_t i = 0u; i < N; ++i)
+                magnitudes[i] *= k;
+            return *this;
+        }
+
+        // Compound Assignment Operator (/=)
+        FixedEuclideanVector& operator/=(double k) {
+            return *this *= (1 / k);
+        }
+
+        // Type Conversion Operator (EuclideanVector)
+        operator EuclideanVector() const {
+            EuclideanVector v(static_cast<unsigned>(N));
+            for (std::size_t i = 0u; i < N; ++i)
+                v[static_cast<int>(i)] = magnitudes[i];
+            return v;
+        }
+
+        // Return the number of dimensions
+        static constexpr std::size_t getNumDimensions() { return N; }
+
+        // Return the value of magnitude in the dimension given as the function parameter
+        double get(std::size_t i) const { return magnitudes[i]; }
+
+        // Return the euclidean norm
+        double getEuclideanNorm() const {
+            double sum = 0.0;
+            for (std::size_t i = 0u; i < N; ++i)
+                sum += magnitudes[i] * magnitudes[i];
+            return std::sqrt(sum);
+        }
+
+        // Create a unit vector
+        FixedEuclideanVector createUnitVector() const {
+            FixedEuclideanVector unitVector {*this};
+            unitVector /= getEuclideanNorm();
+            return unitVector;
+        }
+
+        // return a const pointer to the head of the magnitudes array
+        double const * cbegin() const { return magnitudes; }
+
+        // return a const pointer to the tail of the magnitudes array
+        double const * cend() const { return magnitudes + N; }
+
+        // return a pointer to the head of the magnitudes array
+        double * begin() { return magnitudes; }
+
+        // return a pointer to the tail of the magnitudes array
+        double * end() { return magnitudes + N; }
+
+    private:
+        double magnitudes[N]; // Array of magnitudes of each dimension
+    };
+
+    // Equality Operator
+    template <std::size_t N>
+    bool operator==(const FixedEuclideanVector<N>& v1, const FixedEuclideanVector<N>& v2) {
+        return std::equal(v1.cbegin(), v1.cend(), v2.cbegin());
+    }
+
+    template <std::size_t N>
+    bool operator!=(const FixedEuclideanVector<N>& v1, const FixedEuclideanVector<N>& v2) {
+        return !(v1 == v2);
+    }
+
+    // Addition Operator
+    template <std::size_t N>
+    FixedEuclideanVector<N> operator+(FixedEuclideanVector<N> v1, const FixedEuclideanVector<N>& v2) {
+        return v1 += v2;
+    }
+
+    // Subtraction Operator
+    template <std::size_t N>
+    FixedEuclideanVector<N> operator-(FixedEuclideanVector<N> v1, const FixedEuclideanVector<N>& v2) {
+        return v1 -= v2;
+    }
+
+    // Multiplication Operator
+    template <std::size_t N>
+    double operator*(const FixedEuclideanVector<N>& v1, const FixedEuclideanVector<N>& v2) {
+        double res = 0.0;
+        for (std::size_t i = 0u; i < N; ++i)
+            res += v1[i] * v2[i];
+        return res;
+    }
+
+    template <std::size_t N>
+    FixedEuclideanVector<N> operator*(FixedEuclideanVector<N> v, double n) {
+        return v *= n;
+    }
+
+    template <std::size_t N>
+    FixedEuclideanVector<N> operator*(double n, FixedEuclideanVector<N> v) {
+        return v *= n;
+    }
+
+    // Division Operator
+    template <std::size_t N>
+    FixedEuclideanVector<N> operator/(FixedEuclideanVector<N> v, double n) {
+        return v /= n;
+    }
+
+    // Ostream Operator
+    template <std::size_t N>
+    std::ostream& operator<<(std::ostream& os, const FixedEuclideanVector<N>& v) {
+        return os << static_cast<EuclideanVector>(v);
+    }
+}
+#endif
@@ -0,0 +1,342 @@
+#include "HnswIndex.h"
+#include "EuclideanVectorKernels.h"
+#include "ThreadPool.h"
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+using namespace evec;
+
+namespace {
+    // Number of locks guarding the link lists
+    const std::size_t lockStripes = 4096u;
+
+    // Return a number in (0, 1] that depends only on the seed and the id (splitmix64), so the layer
+    // of a node does not depend on the order concurrent inserts run in
+    double uniform(std::uint64_t seed, std::uint64_t id) {
+        std::uint64_t z = seed + (id + 1u) * 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        return (static_cast<double>(z >> 11) + 1.0) / 9007199254740992.0;
+    }
+
+    // Orders candidates so the nearest is at the front of a heap
+    bool fartherThan(const Neighbor& a, const Neighbor& b) {
+        return b < a;
+    }
+}
+
+/***************************************  Constructors and destructors  ***********************************************/
+
+// Constructor that takes the number of dimensions, the most vectors the index will hold and the parameters
+HnswIndex::HnswIndex(unsigned d, std::size_t n, Parameters p):
+        dimension{d}, capacity{n}, parameters{p}, maxLinks0{2u * p.m}, magnitudes(n * d),
+        links0(n * (2u * p.m + 1u)), upperLinks(n), locks(lockStripes) {
+    assert(p.m >= 2u);
+    assert(n <= std::numeric_limits<std::uint32_t>::max());
+}
+
+// Destructor
+HnswIndex::~HnswIndex() noexcept = default;
+
+/***********************************************  Member Functions  ***************************************************/
+
+// Insert a vector and return its id
+std::size_t HnswIndex::add(ConstEuclideanVectorView v) {
+    assert(v.getNumDimensions() == dimension);
+    std::size_t id = count.fetch_add(1u, std::memory_order_acq_rel);
+    if (id >= capacity) {
+        count.fetch_sub(1u, std::memory_order_acq_rel);
+        throw std::length_error{"HnswIndex is full"};
+    }
+    std::copy(v.cbegin(), v.cend(), magnitudes.begin() + id * dimension);
+    insert(static_cast<std::uint32_t>(id));
+    return id;
+}
+
+// Insert every vector of a batch, spreading the inserts over the thread pool
+void HnswIndex::add(const EuclideanVectorBatch& batch) {
+    assert(batch.getNumDimensions() == dimension);
+    std::size_t first = count.fetch_add(batch.size(), std::memory_order_acq_rel);
+    if (first + batch.size() > capacity) {
+        count.fetch_sub(batch.size(), std::memory_order_acq_rel);
+        throw std::length_error{"HnswIndex is full"};
+    }
+    for (std::size_t i = 0u; i < batch.size(); ++i) {
+        EuclideanVectorBatch::ConstRow row = batch[i];
+        for (unsigned j = 0u; j < dimension; ++j)
+            magnitudes[(first + i) * dimension + j] = row[j];
+    }
+    ThreadPool::instance().parallelFor(batch.size(), 1u, [&] (std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i)
+            insert(static_cast<std::uint32_t>(first + i));
+    });
+}
+
+// Return about the k nearest vectors to the query
+std::vector<Neighbor> HnswIndex::search(ConstEuclideanVectorView query, std::size_t k) const {
+    assert(query.getNumDimensions() == dimension);
+    return searchOne(query.data(), k);
+}
+
+// Return about the k nearest vectors to every query
+std::vector<std::vector<Neighbor>> HnswIndex::search(const EuclideanVectorBatch& queries, std::size_t k) const {
+    assert(queries.getNumDimensions() == dimension);
+    if (queries.getLayout() != EuclideanVectorBatch::Layout::RowMajor)
+        return search(queries.toLayout(EuclideanVectorBatch::Layout::RowMajor), k);
+
+    std::vector<std::vector<Neighbor>> results(queries.size());
+    ThreadPool::instance().parallelFor(queries.size(), 1u, [&] (std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t q = begin; q < end; ++q)
+            results[q] = searchOne(queries.data() + q * dimension, k);
+    });
+    return results;
+}
+
+// Return the search over layer 0 for a query
+std::vector<Neighbor> HnswIndex::searchOne(const double* query, std::size_t k) const {
+    if (maxLevel < 0 || k == 0u)
+        return {};
+    Neighbor entry {entryPoint, squaredDistance(query, entryPoint)};
+    for (int level = maxLevel; level > 0; --level)
+        entry = greedyClosest(query, entry, level, false);
+
+    std::vector<Neighbor> found = searchLayer(query, {entry}, std::max<std::size_t>(parameters.efSearch, k), 0, false);
+    if (found.size() > k)
+        found.resize(k);
+    for (Neighbor& n : found)
+        n.distance = std::sqrt(n.distance);
+    return found;
+}
+
+// Link the node with the given id into the graph
+void HnswIndex::insert(std::uint32_t node) {
+    const double* query = magnitudes.data() + std::size_t{node} * dimension;
+    int level = static_cast<int>(-std::log(uniform(parameters.seed, node)) / std::log(static_cast<double>(parameters.m)));
+    if (level > 0) {
+        std::size_t size = static_cast<std::size_t>(level) * (parameters.m + 1u);
+        upperLinks[node].reset(new std::uint32_t[size]());
+    }
+
+    // A node that raises the top of the graph keeps the entry lock until it is linked, the others
+    // only read the entry point
+    std::unique_lock<std::mutex> entryLock {entryMutex};
+    if (maxLevel < 0) {
+        entryPoint = node;
+        maxLevel = level;
+        return;
+    }
+    std::uint32_t entryNode = entryPoint;
+    int top = maxLevel;
+    if (level <= top)
+        entryLock.unlock();
+
+    Neighbor entry {entryNode, squaredDistance(query, entryNode)};
+    for (int l = top; l > level; --l)
+        entry = greedyClosest(query, entry, l, true);
+
+    std::vector<Neighbor> entries {entry};
+    std::size_t ef = std::max<std::size_t>(parameters.efConstruction, parameters.m);
+    for (int l = std::min(level, top); l >= 0; --l) {
+        entries = searchLayer(query, entries, ef, l, true);
+        connect(node, selectNeighbors(entries, parameters.m), l);
+    }
+
+    if (level > top) {
+        entryPoint = node;
+        maxLevel = level;
+    }
+}
+
+// Return the link list (count, then links) of a node on a layer
+std::uint32_t* HnswIndex::linksOf(std::uint32_t node, int level) {
+    if (level == 0)
+        return links0.data() + std::size_t{node} * (maxLinks0 + 1u);
+    return upperLinks[node].get() + static_cast<std::size_t>(level - 1) * (parameters.m + 1u);
+}
+
+const std::uint32_t* HnswIndex::linksOf(std::uint32_t node, int level) const {
+    return const_cast<HnswIndex*>(this)->linksOf(node, level);
+}
+
+// Return the squared distance between a query and a node
+double HnswIndex::squaredDistance(const double* query, std::uint32_t node) const {
+    const double* v = magnitudes.data() + std::size_t{node} * dimension;
+    return kernels::squaredDistance(query, v, dimension);
+}
+
+// Follow links to the node nearest the query on one layer, starting from entry
+Neighbor HnswIndex::greedyClosest(const double* query, Neighbor entry, int level, bool locking) const {
+    std::vector<std::uint32_t> links;
+    for (bool moved = true; moved; ) {
+        moved = false;
+        const std::uint32_t* list = linksOf(static_cast<std::uint32_t>(entry.id), level);
+        if (locking) {
+            std::lock_guard<std::mutex> lock {locks[entry.id % lockStripes]};
+            links.assign(list + 1, list + 1 + list[0]);
+        } else {
+            links.assign(list + 1, list + 1 + list[0]);
+        }
+        for (std::uint32_t n : links) {
+            double d = squaredDistance(query, n);
+            if (d < entry.distance) {
+                entry = Neighbor{n, d};
+                moved = true;
+            }
+        }
+    }
+    return entry;
+}
+
+// Return the ef nearest nodes to the query found on one layer from the entry nodes
+std::vector<Neighbor> HnswIndex::searchLayer(const double* query, const std::vector<Neighbor>& entries,
+                                             std::size_t ef, int level, bool locking) const {
+    std::unique_ptr<VisitedList> visited = acquireVisited();
+    std::uint32_t epoch = visited->epoch;
+
+    TopK nearest {ef};
+    std::vector<Neighbor> candidates; // Min-heap of the nodes whose links have not been followed yet
+    for (const Neighbor& e : entries) {
+        visited->marks[e.id] = epoch;
+        nearest.push(e.id, e.distance);
+        candidates.push_back(e);
+        std::push_heap(candidates.begin(), candidates.end(), fartherThan);
+    }
+
+    std::vector<std::uint32_t> links;
+    while (!candidates.empty()) {
+        std::pop_heap(candidates.begin(), candidates.end(), fartherThan);
+        Neighbor current = candidates.back();
+        candidates.pop_back();
+        if (current.distance > nearest.worst())
+            break;
+
+        const std::uint32_t* list = linksOf(static_cast<std::uint32_t>(current.id), level);
+        if (locking) {
+            std::lock_guard<std::mutex> lock {locks[current.id % lockStripes]};
+            links.assign(list + 1, list + 1 + list[0]);
+        } else {
+            links.assign(list + 1, list + 1 + list[0]);
+        }
+        for (std::uint32_t n : links) {
+            if (visited->marks[n] == epoch)
+                continue;
+            visited->marks[n] = epoch;
+            double d = squaredDistance(query, n);
+            if (d < nearest.worst()) {
+                nearest.push(n, d);
+                candidates.push_back(Neighbor{n, d});
+                std::push_heap(candidates.begin(), candidates.end(), fartherThan);
+            }
+        }
+    }
+
+    releaseVisited(std::move(visited));
+    return nearest.sorted();
+}
+
+// Keep at most n of the candidates, preferring ones in diverse directions
+std::vector<Neighbor> HnswIndex::selectNeighbors(const std::vector<Neighbor>& candidates, std::size_t n) const {
+    std::vector<Neighbor> selected;
+    for (const Neighbor& c : candidates) {
+        if (selected.size() == n)
+            break;
+        const double* v = magnitudes.data() + c.id * dimension;
+        bool diverse = std::none_of(selected.begin(), selected.end(), [&] (const Neighbor& s) {
+            return squaredDistance(v, static_cast<std::uint32_t>(s.id)) < c.distance;
+        });
+        if (diverse)
+            selected.push_back(c);
+    }
+    return selected;
+}
+
+// Link node to the selected nodes on a layer and the selected nodes back to node
+void HnswIndex::connect(std::uint32_t node, const std::vector<Neighbor>& selected, int level) {
+    const std::size_t most = maxLinks(level);
+    const double* query = magnitudes.data() + std::size_t{node} * dimension;
+    std::vector<Neighbor> candidates;
+    {
+        // Concurrent inserts that reached node on a layer above may already have linked back to it,
+        // so the selected nodes join its links instead of replacing them
+        std::lock_guard<std::mutex> lock {locks[node % lockStripes]};
+        std::uint32_t* list = linksOf(node, level);
+        candidates = selected;
+        for (std::uint32_t i = 1u; i <= list[0]; ++i) {
+            bool known = std::any_of(selected.begin(), selected.end(), [&] (const Neighbor& s) { return s.id == list[i]; });
+            if (!known)
+                candidates.push_back(Neighbor{list[i], squaredDistance(query, list[i])});
+        }
+        setLinks(list, candidates, most);
+    }
+
+    for (const Neighbor& s : selected) {
+        std::uint32_t other = static_cast<std::uint32_t>(s.id);
+        std::lock_guard<std::mutex> lock {locks[other % lockStripes]};
+        std::uint32_t* list = linksOf(other, level);
+        if (std::find(list + 1, list + 1 + list[0], node) != list + 1 + list[0])
+            continue;
+        if (list[0] < most) {
+            list[++list[0]] = node;
+            continue;
+        }
+
+        // The list is full: keep the best of its links and the new one
+        const double* v = magnitudes.data() + std::size_t{other} * dimension;
+        candidates.assign(1u, Neighbor{node, s.distance});
+        for (std::uint32_t i = 1u; i <= list[0]; ++i)
+            candidates.push_back(Neighbor{list[i], squaredDistance(v, list[i])});
+        setLinks(list, candidates, most);
+    }
+}
+
+// Replace a link list with the candidates, keeping at most the given number of them
+void HnswIndex::setLinks(std::uint32_t* list, std::vector<Neighbor>& candidates, std::size_t most) const {
+    if (candidates.size() > most) {
+        std::sort(candidates.begin(), candidates.end());
+        candidates = selectNeighbors(candidates, most);
+    }
+    list[0] = static_cast<std::uint32_t>(candidates.size());
+    for (std::size_t i = 0u; i < candidates.size(); ++i)
+        list[i + 1u] = static_cast<std::uint32_t>(candidates[i].id);
+}
+
+// Return the ids linked to a vector on layer 0
+std::vector<std::size_t> HnswIndex::getLinks(std::size_t id) const {
+    assert(id < size());
+    std::lock_guard<std::mutex> lock {locks[id % lockStripes]};
+    const std::uint32_t* list = linksOf(static_cast<std::uint32_t>(id), 0);
+    return std::vector<std::size_t>(list + 1, list + 1 + list[0]);
+}
+
+// Take a visited list out of the pool, or create one
+std::unique_ptr<HnswIndex::VisitedList> HnswIndex::acquireVisited() const {
+    std::unique_ptr<VisitedList> visited;
+    {
+        std::lock_guard<std::mutex> lock {visitedMutex};
+        if (!visitedPool.empty()) {
+            visited = std::move(visitedPool.back());
+            visitedPool.pop_back();
+        }
+    }
+    if (visited == nullptr) {
+        visited.reset(new VisitedList);
+        visited->marks.assign(capacity, 0u);
+    }
+
+    // A new epoch unmarks every node, the marks are only cleared when the epoch wraps around
+    if (++visited->epoch == 0u) {
+        std::fill(visited->marks.begin(), visited->marks.end(), 0u);
+        visited->epoch = 1u;
+    }
+    return visited;
+}
+
+// Return a visited list to the pool
+void HnswIndex::releaseVisited(std::unique_ptr<VisitedList> visited) const {
+    std::lock_guard<std::mutex> lock {visitedMutex};
+    visitedPool.push_back(std::move(visited));
+}
@@ -0,0 +1,147 @@
+#ifndef A2_HNSWINDEX_H
+#define A2_HNSWINDEX_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "EuclideanVectorBatch.h"
+#include "EuclideanVectorView.h"
+#include "Neighbor.h"
+
+namespace evec {
+    // Tuning knobs of an HnswIndex
+    struct HnswParameters {
+        unsigned m = 16u; // Links per node on the upper layers, twice as many on layer 0
+        unsigned efConstruction = 200u; // Candidates considered when linking a new node
+        unsigned efSearch = 64u; // Candidates considered by a search (at least k are)
+        std::uint64_t seed = 42u; // Seed of the random layer assignment
+    };
+
+    // Approximate nearest-neighbour index based on a hierarchical navigable small-world graph
+    // (Malkov and Yashunin). Every vector is a node linked to its near neighbours on layer 0 and,
+    // with exponentially decreasing probability, on the layers above. A search descends greedily
+    // from the single node of the top layer and then explores the nearest efSearch nodes of layer 0.
+    //
+    // Storage for every vector and its links is reserved up front for a fixed capacity, so add can
+    // be called from several threads at once. Searches must not run while vectors are being added.
+    class HnswIndex {
+    public:
+        using Parameters = HnswParameters;
+
+        // Constructor that takes the number of dimensions, the most vectors the index will hold and the parameters
+        HnswIndex(unsigned dimension, std::size_t capacity, Parameters = Parameters{});
+
+        HnswIndex(const HnswIndex&) = delete;
+        HnswIndex& operator=(const HnswIndex&) = delete;
+
+        // Destructor
+        ~HnswIndex() noexcept;
+
+        // Insert a vector and return its id (ids are given out in insertion order starting at 0).
+        // Safe to call from several threads at once. Throws std::length_error if the index is full.
+        std::size_t add(ConstEuclideanVectorView v);
+
+        // Insert every vector of a batch, spreading the inserts over the thread pool. The vectors get
+        // consecutive ids in batch order.
+        void add(const EuclideanVectorBatch&);
+
+        // Return about the k nearest vectors to the query, nearest first, with their euclidean distances
+        std::vector<Neighbor> search(ConstEuclideanVectorView query, std::size_t k) const;
+
+        // Return about the k nearest vectors to every query, spreading the queries over the thread pool
+        std::vector<std::vector<Neighbor>> search(const EuclideanVectorBatch& queries, std::size_t k) const;
+
+        // Change the number of candidates considered by a search
+        void setEfSearch(unsigned ef) { parameters.efSearch = ef; }
+
+        // Return the parameters of the index
+        const Parameters& getParameters() const { return parameters; }
+
+        // Return the number of vectors inserted
+        std::size_t size() const { return std::min(count.load(std::memory_order_acquire), capacity); }
+
+        // Return the most vectors the index can hold
+        std::size_t getCapacity() const { return capacity; }
+
+        // Return the number of dimensions of the vectors
+        unsigned getNumDimensions() const { return dimension; }
+
+        // Return the vector with the given id
+        ConstEuclideanVectorView operator[](std::size_t id) const {
+            return ConstEuclideanVectorView{magnitudes.data() + id * dimension, dimension};
+        }
+
+        // Return the ids linked to a vector on layer 0, for checking the graph
+        std::vector<std::size_t> getLinks(std::size_t id) const;
+
+    private:
+        // Marks of the nodes a search has visited, reused between searches
+        struct VisitedList {
+            std::vector<std::uint32_t> marks; // marks[node] == epoch if node was visited by the current search
+            std::uint32_t epoch = 0u;
+        };
+
+        unsigned dimension;
+        std::size_t capacity;
+        Parameters parameters;
+        std::size_t maxLinks0; // Most links of a node on layer 0
+
+        std::vector<double> magnitudes; // capacity * dimension magnitudes, row-major
+        std::vector<std::uint32_t> links0; // Link count followed by maxLinks0 links, for every node
+        std::vector<std::unique_ptr<std::uint32_t[]>> upperLinks; // Link count followed by m links, for every layer above 0
+
+        std::atomic<std::size_t> count {0u}; // Ids given out so far
+        std::mutex entryMutex; // Guards entryPoint and maxLevel
+        std::uint32_t entryPoint = 0u; // Node of the top layer searches start from
+        int maxLevel = -1; // Top layer of the graph, -1 while it is empty
+        mutable std::vector<std::mutex> locks; // Lock stripes guarding the link lists, node i uses locks[i % size]
+
+        mutable std::mutex visitedMutex; // Guards visitedPool
+        mutable std::vector<std::unique_ptr<VisitedList>> visitedPool; // Visited lists not in use
+
+        // Link the node with the given id into the graph
+        void insert(std::uint32_t node);
+
+        // Return the link list (count, then links) of a node on a layer
+        std::uint32_t* linksOf(std::uint32_t node, int level);
+        const std::uint32_t* linksOf(std::uint32_t node, int level) const;
+
+        // Return the most links of a node on a layer
+        std::size_t maxLinks(int level) const { return level == 0 ? maxLinks0 : parameters.m; }
+
+        // Return the squared distance between a query and a node
+        double squaredDistance(const double* query, std::uint32_t node) const;
+
+        // Follow links to the node nearest the query on one layer, starting from entry
+        Neighbor greedyClosest(const double* query, Neighbor entry, int level, bool locking) const;
+
+        // Return the ef nearest nodes to the query found on one layer from the entry nodes, nearest first
+        std::vector<Neighbor> searchLayer(const double* query, const std::vector<Neighbor>& entries,
+                                          std::size_t ef, int level, bool locking) const;
+
+        // Keep at most n of the candidates (sorted nearest first), preferring ones that are nearer to
+        // the base than to any candidate kept already, so links point in diverse directions
+        std::vector<Neighbor> selectNeighbors(const std::vector<Neighbor>& candidates, std::size_t n) const;
+
+        // Link node to the selected nodes on a layer and the selected nodes back to node
+        void connect(std::uint32_t node, const std::vector<Neighbor>& selected, int level);
+
+        // Replace a link list with the candidates, pruned with selectNeighbors to the given number
+        void setLinks(std::uint32_t* list, std::vector<Neighbor>& candidates, std::size_t most) const;
+
+        // Return the search over layer 0 for a query (used by both overloads of search)
+        std::vector<Neighbor> searchOne(const double* query, std::size_t k) const;
+
+        // Take a visited list out of the pool, or create one
+        std::unique_ptr<VisitedList> acquireVisited() const;
+
+        // Return a visited list to the pool
+        void releaseVisited(std::unique_ptr<VisitedList>) const;
+    };
+}
+#endif
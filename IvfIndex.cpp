@@ -0,0 +1,101 @@
+#include "IvfIndex.h"
+#include "EuclideanVectorKernels.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace evec;
+
+/***************************************  Constructors and destructors  ***********************************************/
+
+// Constructor that takes the number of dimensions and the parameters
+IvfIndex::IvfIndex(unsigned d, Parameters p): dimension{d}, parameters{p}, quantizer{p.lists, p.training}, lists(p.lists) {}
+
+/***********************************************  Member Functions  ***************************************************/
+
+// Train the coarse quantizer on a sample of the vectors that will be indexed
+void IvfIndex::train(const EuclideanVectorBatch& sample) {
+    assert(sample.getNumDimensions() == dimension);
+    quantizer.train(sample);
+}
+
+// Insert a vector and return its id
+std::size_t IvfIndex::add(ConstEuclideanVectorView v) {
+    assert(isTrained() && v.getNumDimensions() == dimension);
+    InvertedList& list = lists[quantizer.nearest(v)];
+    list.magnitudes.insert(list.magnitudes.end(), v.cbegin(), v.cend());
+    list.squaredNorms.push_back(kernels::sumOfSquares(v.data(), dimension));
+    list.ids.push_back(count);
+    return count++;
+}
+
+// Insert every vector of a batch
+void IvfIndex::add(const EuclideanVectorBatch& batch) {
+    assert(isTrained() && batch.getNumDimensions() == dimension);
+    if (batch.getLayout() != EuclideanVectorBatch::Layout::RowMajor) {
+        add(batch.toLayout(EuclideanVectorBatch::Layout::RowMajor));
+        return;
+    }
+
+    // Finding the cells is the expensive part and runs on the thread pool, the lists are then filled in order
+    std::vector<std::size_t> cells = quantizer.nearest(batch);
+    for (std::size_t i = 0u; i < batch.size(); ++i) {
+        const double* v = batch.data() + i * dimension;
+        InvertedList& list = lists[cells[i]];
+        list.magnitudes.insert(list.magnitudes.end(), v, v + dimension);
+        list.squaredNorms.push_back(kernels::sumOfSquares(v, dimension));
+        list.ids.push_back(count++);
+    }
+}
+
+// Return about the k nearest vectors to the query
+std::vector<Neighbor> IvfIndex::search(ConstEuclideanVectorView query, std::size_t k) const {
+    assert(query.getNumDimensions() == dimension);
+    return searchOne(query.data(), k);
+}
+
+// Return about the k nearest vectors to every query
+std::vector<std::vector<Neighbor>> IvfIndex::search(const EuclideanVectorBatch& queries, std::size_t k) const {
+    assert(queries.getNumDimensions() == dimension);
+    if (queries.getLayout() != EuclideanVectorBatch::Layout::RowMajor)
+        return search(queries.toLayout(EuclideanVectorBatch::Layout::RowMajor), k);
+
+    std::vector<std::vector<Neighbor>> results(queries.size());
+    ThreadPool::instance().parallelFor(queries.size(), 1u, [&] (std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t q = begin; q < end; ++q)
+            results[q] = searchOne(queries.data() + q * dimension, k);
+    });
+    return results;
+}
+
+// Return the nprobe lists nearest to the query
+std::vector<Neighbor> IvfIndex::probe(const double* query, double queryNorm) const {
+    const EuclideanVectorBatch& centroids = quantizer.getCentroids();
+    const std::vector<double>& centroidNorms = quantizer.getCentroidSquaredNorms();
+    TopK nearest {std::min<std::size_t>(parameters.nprobe, lists.size())};
+    for (std::size_t c = 0u; c < lists.size(); ++c)
+        nearest.push(c, queryNorm + centroidNorms[c] - 2.0 * kernels::dot(query, centroids.data() + c * dimension, dimension));
+    return nearest.sorted();
+}
+
+// Return the search for one row-major query
+std::vector<Neighbor> IvfIndex::searchOne(const double* query, std::size_t k) const {
+    if (!isTrained() || k == 0u)
+        return {};
+    double queryNorm = kernels::sumOfSquares(query, dimension);
+    TopK nearest {k};
+    for (const Neighbor& cell : probe(query, queryNorm)) {
+        const InvertedList& list = lists[cell.id];
+        for (std::size_t i = 0u; i < list.ids.size(); ++i) {
+            double d = queryNorm + list.squaredNorms[i] - 2.0 * kernels::dot(query, list.magnitudes.data() + i * dimension, dimension);
+            nearest.push(list.ids[i], std::max(d, 0.0));
+        }
+    }
+
+    std::vector<Neighbor> found = nearest.sorted();
+    for (Neighbor& n : found)
+        n.distance = std::sqrt(n.distance);
+    return found;
+}
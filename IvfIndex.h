@@ -0,0 +1,89 @@
+#ifndef A2_IVFINDEX_H
+#define A2_IVFINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "EuclideanVectorBatch.h"
+#include "EuclideanVectorView.h"
+#include "KMeans.h"
+#include "Neighbor.h"
+
+namespace evec {
+    // Tuning knobs of an IvfIndex
+    struct IvfParameters {
+        unsigned lists = 1024u; // Number of inverted lists (k-means clusters)
+        unsigned nprobe = 8u; // Lists scanned by a search
+        KMeansParameters training; // Parameters of the coarse quantizer
+    };
+
+    // Approximate nearest-neighbour index based on an inverted file. A k-means coarse quantizer,
+    // trained on a sample, splits the space into cells. Every vector is stored in the list of its
+    // cell, and a search scans only the nprobe lists whose centroids are nearest to the query.
+    // Each list keeps its vectors one after another in a single block, so a scan streams through
+    // memory. Apart from the vector itself, an entry costs its squared norm and its id.
+    class IvfIndex {
+    public:
+        using Parameters = IvfParameters;
+
+        // Constructor that takes the number of dimensions and the parameters
+        explicit IvfIndex(unsigned dimension, Parameters = Parameters{});
+
+        // Train the coarse quantizer on a sample of the vectors that will be indexed. Throws
+        // std::invalid_argument if the sample has fewer vectors than lists.
+        void train(const EuclideanVectorBatch& sample);
+
+        // Return true once the coarse quantizer is trained
+        bool isTrained() const { return quantizer.isTrained(); }
+
+        // Insert a vector and return its id (ids are given out in insertion order starting at 0).
+        // The index must be trained.
+        std::size_t add(ConstEuclideanVectorView v);
+
+        // Insert every vector of a batch, they get consecutive ids in batch order
+        void add(const EuclideanVectorBatch&);
+
+        // Return about the k nearest vectors to the query, nearest first, with their euclidean distances
+        std::vector<Neighbor> search(ConstEuclideanVectorView query, std::size_t k) const;
+
+        // Return about the k nearest vectors to every query, spreading the queries over the thread pool
+        std::vector<std::vector<Neighbor>> search(const EuclideanVectorBatch& queries, std::size_t k) const;
+
+        // Change the number of lists scanned by a search
+        void setNprobe(unsigned n) { parameters.nprobe = n; }
+
+        // Return the parameters of the index
+        const Parameters& getParameters() const { return parameters; }
+
+        // Return the number of vectors inserted
+        std::size_t size() const { return count; }
+
+        // Return the number of dimensions of the vectors
+        unsigned getNumDimensions() const { return dimension; }
+
+        // Return the number of vectors in a list
+        std::size_t listSize(std::size_t list) const { return lists[list].ids.size(); }
+
+    private:
+        // Vectors of one cell, stored contiguously
+        struct InvertedList {
+            std::vector<double> magnitudes; // Row-major vectors
+            std::vector<double> squaredNorms; // Squared norm of every vector
+            std::vector<std::size_t> ids; // Id of every vector
+        };
+
+        unsigned dimension;
+        Parameters parameters;
+        KMeans quantizer;
+        std::vector<InvertedList> lists;
+        std::size_t count = 0u; // Vectors inserted
+
+        // Return the nprobe lists nearest to the query, nearest first
+        std::vector<Neighbor> probe(const double* query, double queryNorm) const;
+
+        // Return the search for one row-major query
+        std::vector<Neighbor> searchOne(const double* query, std::size_t k) const;
+    };
+}
+#endif
@@ -0,0 +1,406 @@
+#include "KMeans.h"
+#include "DatasetReader.h"
+#include "EuclideanVectorKernels.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+using namespace evec;
+
+namespace {
+    // Vectors and centroids compared together, and magnitudes multiplied in one pass (see PairwiseDistances.cpp)
+    const std::size_t tileSize = 64u;
+    const std::size_t depthBlock = 256u;
+
+    // Fewest vectors a thread assigns
+    const std::size_t assignGrain = 4u * tileSize;
+
+    // Fewest vectors a thread measures against a new k-means++ centroid
+    const std::size_t seedingGrain = 4096u;
+
+    // Sum and number of the vectors one thread assigned to every cluster
+    struct ClusterSums {
+        std::vector<double> sums; // One row of magnitudes per cluster
+        std::vector<std::size_t> sizes;
+        std::size_t changed = 0u; // Vectors that moved to another cluster
+    };
+
+    // Find the nearest centroid of the vectors [begin, end) of a row-major array, comparing tiles of
+    // vectors with tiles of centroids through dotBlock, and call visit(i, nearest centroid, squared
+    // distance - ||v_i||^2) for each. dots is scratch space of tileSize * tileSize doubles.
+    template <typename Visit>
+    void assignRange(const double* vectors, std::size_t begin, std::size_t end, const EuclideanVectorBatch& centroids,
+                     const std::vector<double>& centroidNorms, std::vector<double>& dots, Visit visit) {
+        const std::size_t dimension = centroids.getNumDimensions(), count = centroids.size();
+        double best[tileSize];
+        std::size_t bestCentroid[tileSize];
+        for (std::size_t first = begin; first < end; first += tileSize) {
+            const std::size_t rows = std::min(tileSize, end - first);
+            std::fill(best, best + rows, std::numeric_limits<double>::infinity());
+            std::fill(bestCentroid, bestCentroid + rows, std::size_t{0u});
+            for (std::size_t c = 0u; c < count; c += tileSize) {
+                const std::size_t columns = std::min(tileSize, count - c);
+                std::fill(dots.begin(), dots.begin() + rows * columns, 0.0);
+                for (std::size_t k = 0u; k < dimension; k += depthBlock)
+                    kernels::dotBlock(vectors + first * dimension + k, rows, centroids.data() + c * dimension + k, columns,
+                                      std::min(depthBlock, dimension - k), dimension, dots.data(), columns);
+                for (std::size_t i = 0u; i < rows; ++i) {
+                    for (std::size_t j = 0u; j < columns; ++j) {
+                        // ||v||^2 is the same for every centroid, so it is left out of the comparison
+                        double d = centroidNorms[c + j] - 2.0 * dots[i * columns + j];
+                        if (d < best[i]) {
+                            best[i] = d;
+                            bestCentroid[i] = c + j;
+                        }
+                    }
+                }
+            }
+            for (std::size_t i = 0u; i < rows; ++i)
+                visit(first + i, bestCentroid[i], best[i]);
+        }
+    }
+
+    // Assign every vector of a row-major batch to its nearest centroid on the thread pool, each thread
+    // adding its vectors to its own sums, and call visit(i, nearest centroid) for every vector. Return
+    // the sums of every thread.
+    template <typename Visit>
+    std::vector<ClusterSums> accumulateClusters(const EuclideanVectorBatch& vectors, const EuclideanVectorBatch& centroids,
+                                                const std::vector<double>& centroidNorms, Visit visit) {
+        const std::size_t dimension = vectors.getNumDimensions(), k = centroids.size();
+        ThreadPool& pool = ThreadPool::instance();
+        std::vector<ClusterSums> partial(pool.chunkCount(vectors.size(), assignGrain));
+        pool.parallelFor(vectors.size(), assignGrain, [&] (std::size_t chunk, std::size_t begin, std::size_t end) {
+            ClusterSums& local = partial[chunk];
+            local.sums.assign(k * dimension, 0.0);
+            local.sizes.assign(k, 0u);
+            std::vector<double> dots(tileSize * tileSize);
+            assignRange(vectors.data(), begin, end, centroids, centroidNorms, dots, [&] (std::size_t i, std::size_t c, double) {
+                kernels::add(local.sums.data() + c * dimension, vectors.data() + i * dimension, dimension);
+                ++local.sizes[c];
+                local.changed += visit(i, c) ? 1u : 0u;
+            });
+        });
+        return partial;
+    }
+
+    // Return a uniform number in [0, 1) that depends only on the seed, the stream and the index, so
+    // vectors sampled on several threads are the same however the work is split
+    double uniformAt(std::uint64_t seed, std::uint64_t stream, std::uint64_t index) {
+        auto mix = [] (std::uint64_t z) {
+            z += 0x9E3779B97F4A7C15u;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+            return z ^ (z >> 31);
+        };
+        return static_cast<double>(mix(seed ^ mix(stream ^ mix(index))) >> 11) / 9007199254740992.0;
+    }
+
+    // Return the indices of k of the count points picked by k-means++, every point weighted by
+    // weights[i] if weights is not null. Distances to every new centroid are measured on the thread pool.
+    std::vector<std::size_t> plusPlus(const double* points, std::size_t count, unsigned dimension, const double* weights,
+                                      unsigned k, std::mt19937_64& random) {
+        std::uniform_real_distribution<double> uniform {0.0, 1.0};
+        auto weight = [weights] (std::size_t i) { return weights == nullptr ? 1.0 : weights[i]; };
+
+        // The first centroid is picked by weight alone
+        std::size_t next = random() % count;
+        if (weights != nullptr) {
+            double target = uniform(random) * std::accumulate(weights, weights + count, 0.0);
+            for (next = 0u; next + 1u < count && (target -= weights[next]) >= 0.0; ++next) {}
+        }
+
+        ThreadPool& pool = ThreadPool::instance();
+        const std::size_t chunks = pool.chunkCount(count, seedingGrain);
+        std::vector<double> chunkTotals(chunks);
+        std::vector<std::size_t> chunkBegins(chunks);
+        std::vector<double> nearest(count, std::numeric_limits<double>::infinity());
+        std::vector<std::size_t> chosen {next};
+        while (chosen.size() < k) {
+            const double* centroid = points + next * dimension;
+            pool.parallelFor(count, seedingGrain, [&] (std::size_t chunk, std::size_t begin, std::size_t end) {
+                double total = 0.0;
+                for (std::size_t i = begin; i < end; ++i) {
+                    nearest[i] = std::min(nearest[i], kernels::squaredDistance(points + i * dimension, centroid, dimension));
+                    total += weight(i) * nearest[i];
+                }
+                chunkTotals[chunk] = total;
+                chunkBegins[chunk] = begin;
+            });
+
+            // Pick the chunk, then the point within it, so only one chunk is scanned
+            double total = std::accumulate(chunkTotals.begin(), chunkTotals.end(), 0.0);
+            if (total > 0.0) {
+                double target = uniform(random) * total;
+                std::size_t chunk = 0u;
+                while (chunk + 1u < chunks && target >= chunkTotals[chunk])
+                    target -= chunkTotals[chunk++];
+                const std::size_t end = chunk + 1u < chunks ? chunkBegins[chunk + 1u] : count;
+                next = chunkBegins[chunk];
+                // If rounding leaves target past the end of the chunk, the last point that could be picked is
+                for (std::size_t i = next; i < end; ++i) {
+                    if (weight(i) * nearest[i] > 0.0)
+                        next = i;
+                    if ((target -= weight(i) * nearest[i]) < 0.0)
+                        break;
+                }
+            } else {
+                // Every point lies on a centroid already, Lloyd's algorithm restarts the duplicates
+                next = random() % count;
+            }
+            chosen.push_back(next);
+        }
+        return chosen;
+    }
+
+    // Return the indices of k of the count points picked by k-means||
+    std::vector<std::size_t> parallelSeeding(const double* points, std::size_t count, unsigned dimension, unsigned k,
+                                             unsigned rounds, std::uint64_t seed, std::mt19937_64& random) {
+        const double oversampling = 2.0 * k;
+        ThreadPool& pool = ThreadPool::instance();
+        const std::size_t chunks = pool.chunkCount(count, assignGrain);
+        std::vector<std::size_t> candidates {static_cast<std::size_t>(random() % count)};
+        std::vector<double> nearest(count, std::numeric_limits<double>::infinity()); // Squared distance to the nearest candidate
+        std::vector<std::size_t> owner(count, 0u); // Nearest candidate
+
+        // Measure every point against the candidates from first on, return the sum of the squared
+        // distances to the nearest candidates
+        std::vector<double> chunkTotals(chunks);
+        auto update = [&] (std::size_t first) {
+            EuclideanVectorBatch batch {candidates.size() - first, dimension};
+            std::vector<double> norms(batch.size());
+            for (std::size_t c = 0u; c < batch.size(); ++c) {
+                std::copy_n(points + candidates[first + c] * dimension, dimension, batch.data() + c * dimension);
+                norms[c] = kernels::sumOfSquares(batch.data() + c * dimension, dimension);
+            }
+            pool.parallelFor(count, assignGrain, [&] (std::size_t chunk, std::size_t begin, std::size_t end) {
+                std::vector<double> dots(tileSize * tileSize);
+                double total = 0.0;
+                assignRange(points, begin, end, batch, norms, dots, [&] (std::size_t i, std::size_t c, double d) {
+                    d = std::max(0.0, d + kernels::sumOfSquares(points + i * dimension, dimension));
+                    if (d < nearest[i]) {
+                        nearest[i] = d;
+                        owner[i] = first + c;
+                    }
+                    total += nearest[i];
+                });
+                chunkTotals[chunk] = total;
+            });
+            return std::accumulate(chunkTotals.begin(), chunkTotals.end(), 0.0);
+        };
+
+        double cost = update(0u);
+        std::vector<std::vector<std::size_t>> sampled(chunks);
+        for (unsigned round = 0u; round < rounds && cost > 0.0; ++round) {
+            // Every point is sampled on its own with probability oversampling * d^2 / cost
+            pool.parallelFor(count, assignGrain, [&] (std::size_t chunk, std::size_t begin, std::size_t end) {
+                sampled[chunk].clear();
+                for (std::size_t i = begin; i < end; ++i)
+                    if (uniformAt(seed, round, i) * cost < oversampling * nearest[i])
+                        sampled[chunk].push_back(i);
+            });
+            const std::size_t first = candidates.size();
+            for (const std::vector<std::size_t>& s : sampled)
+                candidates.insert(candidates.end(), s.begin(), s.end());
+            if (candidates.size() > first)
+                cost = update(first);
+        }
+
+        // Too few distinct candidates, which only happens with many duplicate points
+        if (candidates.size() < k)
+            return plusPlus(points, count, dimension, nullptr, k, random);
+
+        // Recluster the candidates, each weighted by the points nearest to it
+        std::vector<double> weights(candidates.size(), 0.0);
+        for (std::size_t i = 0u; i < count; ++i)
+            weights[owner[i]] += 1.0;
+        EuclideanVectorBatch batch {candidates.size(), dimension};
+        for (std::size_t c = 0u; c < candidates.size(); ++c)
+            std::copy_n(points + candidates[c] * dimension, dimension, batch.data() + c * dimension);
+        std::vector<std::size_t> chosen = plusPlus(batch.data(), batch.size(), dimension, weights.data(), k, random);
+        for (std::size_t& c : chosen)
+            c = candidates[c];
+        return chosen;
+    }
+}
+
+/***************************************  Constructors and destructors  ***********************************************/
+
+// Constructor that takes the number of clusters and the parameters
+KMeans::KMeans(unsigned n, Parameters p): k{n}, parameters{p} {
+    assert(n > 0u);
+}
+
+/***********************************************  Member Functions  ***************************************************/
+
+// Compute the centroids of the vectors
+void KMeans::train(const EuclideanVectorBatch& vectors) {
+    if (vectors.size() < k)
+        throw std::invalid_argument{"k-means needs at least as many vectors as clusters"};
+    if (vectors.getLayout() != EuclideanVectorBatch::Layout::RowMajor) {
+        train(vectors.toLayout(EuclideanVectorBatch::Layout::RowMajor));
+        return;
+    }
+    const unsigned dimension = vectors.getNumDimensions();
+    const std::size_t count = vectors.size();
+    seed(vectors);
+
+    std::mt19937_64 random {parameters.seed + 1u};
+    std::vector<std::size_t> assignment(count, k);
+    clusterSizes.assign(k, 0u);
+    for (unsigned iteration = 0u; iteration < parameters.iterations; ++iteration) {
+        // Assign every vector to its nearest centroid, summing the clusters on the way
+        std::vector<ClusterSums> partial = accumulateClusters(vectors, centroids, centroidNorms, [&] (std::size_t i, std::size_t c) {
+            bool changed = c != assignment[i];
+            assignment[i] = c;
+            return changed;
+        });
+        std::size_t changed = 0u;
+        for (const ClusterSums& p : partial)
+            changed += p.changed;
+        if (changed == 0u)
+            break;
+
+        // Move every centroid to the mean of its vectors, combining the threads in order so the result is repeatable
+        std::fill(centroids.data(), centroids.data() + k * dimension, 0.0);
+        std::fill(clusterSizes.begin(), clusterSizes.end(), 0u);
+        for (const ClusterSums& p : partial) {
+            kernels::add(centroids.data(), p.sums.data(), k * dimension);
+            for (unsigned c = 0u; c < k; ++c)
+                clusterSizes[c] += p.sizes[c];
+        }
+        for (unsigned c = 0u; c < k; ++c) {
+            double* centroid = centroids.data() + c * dimension;
+            if (clusterSizes[c] != 0u) {
+                kernels::scale(centroid, 1.0 / clusterSizes[c], dimension);
+            } else {
+                // An empty cluster restarts from a random vector
+                const double* v = vectors.data() + (random() % count) * dimension;
+                std::copy(v, v + dimension, centroid);
+            }
+        }
+        updateNorms();
+    }
+}
+
+// Update the centroids with one mini-batch of vectors
+void KMeans::partialFit(const EuclideanVectorBatch& batch) {
+    if (batch.getLayout() != EuclideanVectorBatch::Layout::RowMajor) {
+        partialFit(batch.toLayout(EuclideanVectorBatch::Layout::RowMajor));
+        return;
+    }
+    if (!isTrained()) {
+        if (batch.size() < k)
+            throw std::invalid_argument{"k-means needs at least as many vectors as clusters"};
+        seed(batch);
+        clusterSizes.assign(k, 0u);
+    }
+    assert(batch.getNumDimensions() == centroids.getNumDimensions());
+    const unsigned dimension = centroids.getNumDimensions();
+
+    // Every centroid becomes the mean of all the vectors assigned to it so far, its own weight
+    // being the number of vectors it already stands for
+    std::vector<ClusterSums> partial = accumulateClusters(batch, centroids, centroidNorms, [] (std::size_t, std::size_t) { return false; });
+    std::vector<double> sum(dimension);
+    for (unsigned c = 0u; c < k; ++c) {
+        std::size_t added = 0u;
+        std::fill(sum.begin(), sum.end(), 0.0);
+        for (const ClusterSums& p : partial) {
+            kernels::add(sum.data(), p.sums.data() + c * dimension, dimension);
+            added += p.sizes[c];
+        }
+        if (added == 0u)
+            continue;
+        clusterSizes[c] += added;
+        double* centroid = centroids.data() + c * dimension;
+        kernels::scale(centroid, static_cast<double>(clusterSizes[c] - added) / clusterSizes[c], dimension);
+        kernels::scale(sum.data(), 1.0 / clusterSizes[c], dimension);
+        kernels::add(centroid, sum.data(), dimension);
+    }
+    updateNorms();
+}
+
+// Compute the centroids with one pass of mini-batch k-means over the blocks of a reader
+void KMeans::trainMiniBatch(DatasetReader& reader) {
+    centroids = EuclideanVectorBatch{0u, 0u};
+    EuclideanVectorBatch block {0u, 0u};
+    while (reader.next(block))
+        partialFit(block);
+    if (!isTrained())
+        throw std::invalid_argument{"k-means needs at least as many vectors as clusters"};
+}
+
+// Return the cluster whose centroid is nearest to the vector
+std::size_t KMeans::nearest(const double* v) const {
+    assert(isTrained());
+    const unsigned dimension = centroids.getNumDimensions();
+    std::size_t best = 0u;
+    double bestDistance = std::numeric_limits<double>::infinity();
+    for (unsigned c = 0u; c < k; ++c) {
+        // ||v||^2 is the same for every centroid, so it is left out of the comparison
+        double d = centroidNorms[c] - 2.0 * kernels::dot(v, centroids.data() + c * dimension, dimension);
+        if (d < bestDistance) {
+            bestDistance = d;
+            best = c;
+        }
+    }
+    return best;
+}
+
+// Return the cluster nearest to every vector of a batch
+std::vector<std::size_t> KMeans::nearest(const EuclideanVectorBatch& batch) const {
+    assert(isTrained() && batch.getNumDimensions() == centroids.getNumDimensions());
+    if (batch.getLayout() != EuclideanVectorBatch::Layout::RowMajor)
+        return nearest(batch.toLayout(EuclideanVectorBatch::Layout::RowMajor));
+
+    std::vector<std::size_t> clusters(batch.size());
+    ThreadPool::instance().parallelFor(batch.size(), assignGrain, [&] (std::size_t, std::size_t begin, std::size_t end) {
+        std::vector<double> dots(tileSize * tileSize);
+        assignRange(batch.data(), begin, end, centroids, centroidNorms, dots, [&] (std::size_t i, std::size_t c, double) {
+            clusters[i] = c;
+        });
+    });
+    return clusters;
+}
+
+// Pick the initial centroids among the vectors of a row-major batch
+void KMeans::seed(const EuclideanVectorBatch& vectors) {
+    const unsigned dimension = vectors.getNumDimensions();
+    const std::size_t count = vectors.size();
+    std::mt19937_64 random {parameters.seed};
+    std::vector<std::size_t> chosen;
+    switch (parameters.seeding) {
+        case KMeansSeeding::Random: {
+            // k distinct vectors picked at random
+            std::vector<std::size_t> order(count);
+            std::iota(order.begin(), order.end(), std::size_t{0u});
+            for (unsigned c = 0u; c < k; ++c)
+                std::swap(order[c], order[c + random() % (count - c)]);
+            chosen.assign(order.begin(), order.begin() + k);
+            break;
+        }
+        case KMeansSeeding::PlusPlus:
+            chosen = plusPlus(vectors.data(), count, dimension, nullptr, k, random);
+            break;
+        case KMeansSeeding::Parallel:
+            chosen = parallelSeeding(vectors.data(), count, dimension, k, parameters.seedingRounds, parameters.seed, random);
+            break;
+    }
+
+    centroids = EuclideanVectorBatch{k, dimension};
+    for (unsigned c = 0u; c < k; ++c)
+        std::copy(vectors.data() + chosen[c] * dimension, vectors.data() + (chosen[c] + 1u) * dimension, centroids.data() + c * dimension);
+    updateNorms();
+}
+
+// Recompute centroidNorms after the centroids changed
+void KMeans::updateNorms() {
+    const unsigned dimension = centroids.getNumDimensions();
+    centroidNorms.resize(k);
+    for (unsigned c = 0u; c < k; ++c)
+        centroidNorms[c] = kernels::sumOfSquares(centroids.data() + c * dimension, dimension);
+}
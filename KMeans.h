@@ -0,0 +1,93 @@
+#ifndef A2_KMEANS_H
+#define A2_KMEANS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "EuclideanVectorBatch.h"
+#include "EuclideanVectorView.h"
+
+namespace evec {
+    class DatasetReader;
+
+    // How KMeans picks its initial centroids
+    enum class KMeansSeeding {
+        Random,   // k distinct training vectors picked at random
+        PlusPlus, // k-means++: every next centroid is a vector picked with probability proportional
+                  // to its squared distance from the nearest centroid so far
+        Parallel  // k-means||: a few rounds each sample about 2k vectors at once with the same
+                  // weights, then k-means++ picks k of these candidates, each weighted by the number
+                  // of vectors nearest to it. Fewer passes over the data than k-means++ for large k.
+    };
+
+    // Tuning knobs of KMeans
+    struct KMeansParameters {
+        unsigned iterations = 20u; // Most Lloyd iterations, training stops earlier once no vector changes cluster
+        std::uint64_t seed = 42u; // Seed of the initial centroid choice
+        KMeansSeeding seeding = KMeansSeeding::PlusPlus; // How the initial centroids are picked
+        unsigned seedingRounds = 5u; // Sampling rounds of k-means||
+    };
+
+    // k-means clustering of vectors. train() runs Lloyd's algorithm on vectors held in memory:
+    // every iteration assigns the vectors to their nearest centroid on the thread pool, comparing a
+    // tile of vectors with a tile of centroids at a time through the register-blocked dotBlock
+    // kernel, and every thread sums the vectors of each cluster into its own buffers, which are
+    // combined once per iteration. Data that does not fit in memory goes through mini-batch
+    // k-means instead (partialFit, trainMiniBatch), which moves every centroid towards the mean of
+    // the vectors assigned to it so far, one batch at a time.
+    class KMeans {
+    public:
+        using Parameters = KMeansParameters;
+
+        // Constructor that takes the number of clusters and the parameters
+        explicit KMeans(unsigned k, Parameters = Parameters{});
+
+        // Compute the centroids of the vectors. Throws std::invalid_argument if there are fewer
+        // vectors than clusters.
+        void train(const EuclideanVectorBatch&);
+
+        // Update the centroids with one mini-batch of vectors. Before the centroids exist, the batch
+        // is also used to seed them, and throws std::invalid_argument if it has fewer vectors than clusters.
+        void partialFit(const EuclideanVectorBatch&);
+
+        // Compute the centroids with one pass of mini-batch k-means over the blocks of a reader,
+        // whose block size must be at least the number of clusters. More passes can be made by
+        // calling partialFit with the blocks of another reader. Throws std::invalid_argument if
+        // the first block has fewer vectors than clusters, and whatever the reader throws.
+        void trainMiniBatch(DatasetReader&);
+
+        // Return true once the centroids exist (after train, partialFit or trainMiniBatch)
+        bool isTrained() const { return centroids.size() != 0u; }
+
+        // Return the number of clusters
+        unsigned getNumClusters() const { return k; }
+
+        // Return the centroids, one row per cluster
+        const EuclideanVectorBatch& getCentroids() const { return centroids; }
+
+        // Return the squared norm of every centroid
+        const std::vector<double>& getCentroidSquaredNorms() const { return centroidNorms; }
+
+        // Return the cluster whose centroid is nearest to the vector
+        std::size_t nearest(ConstEuclideanVectorView v) const { return nearest(v.data()); }
+        std::size_t nearest(const double* v) const;
+
+        // Return the cluster nearest to every vector of a batch, found a tile at a time on the thread pool
+        std::vector<std::size_t> nearest(const EuclideanVectorBatch&) const;
+
+    private:
+        unsigned k; // Number of clusters
+        Parameters parameters;
+        EuclideanVectorBatch centroids {0u, 0u}; // Row-major centroids
+        std::vector<double> centroidNorms; // Squared norm of every centroid
+        std::vector<std::size_t> clusterSizes; // Vectors assigned to every cluster so far, the weights of mini-batch updates
+
+        // Pick the initial centroids among the vectors of a row-major batch
+        void seed(const EuclideanVectorBatch&);
+
+        // Recompute centroidNorms after the centroids changed
+        void updateNorms();
+    };
+}
+#endif
@@ -0,0 +1,114 @@
+#include "LinearTransform.h"
+#include "EuclideanVectorKernels.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+using namespace evec;
+
+namespace {
+    // Vectors and output dimensions in a tile, and input dimensions multiplied in one pass. The
+    // depth block of a tile of vectors (64 x 256 doubles) stays in the L2 cache while the rows of
+    // the matrix go past four at a time from the L1 cache.
+    const std::size_t tileSize = 64u;
+    const std::size_t depthBlock = 256u;
+
+    // Expression for the product of a row-major matrix with a vector, one dot product per magnitude,
+    // so the result is built without a temporary
+    class RowProducts : public VectorExpression<RowProducts> {
+    public:
+        RowProducts(const double* m, unsigned r, ConstEuclideanVectorView v): matrix{m}, rows{r}, vector{v} {}
+
+        unsigned getNumDimensions() const { return rows; }
+
+        double operator[](unsigned i) const {
+            return kernels::dot(matrix + static_cast<std::size_t>(i) * vector.getNumDimensions(), vector.data(), vector.getNumDimensions());
+        }
+
+    private:
+        const double* matrix;
+        unsigned rows;
+        ConstEuclideanVectorView vector;
+    };
+}
+
+/***************************************  Constructors and destructors  ***********************************************/
+
+// Constructor that takes the number of output and input dimensions, every coefficient zero
+LinearTransform::LinearTransform(unsigned out, unsigned in):
+        outputDimension{out}, inputDimension{in}, coefficients(static_cast<std::size_t>(out) * in, 0.0) {}
+
+// Constructor that takes the coefficients row by row
+LinearTransform::LinearTransform(unsigned out, unsigned in, std::vector<double> c):
+        outputDimension{out}, inputDimension{in}, coefficients(std::move(c)) {
+    if (coefficients.size() != static_cast<std::size_t>(out) * in)
+        throw std::invalid_argument{"a linear transform needs output dimension * input dimension coefficients"};
+}
+
+// Return the identity on the given number of dimensions
+LinearTransform LinearTransform::identity(unsigned dimension) {
+    LinearTransform t {dimension, dimension};
+    for (unsigned i = 0u; i < dimension; ++i)
+        t(i, i) = 1.0;
+    return t;
+}
+
+/***********************************************  Member Functions  ***************************************************/
+
+// Return the transpose
+LinearTransform LinearTransform::transposed() const {
+    LinearTransform t {inputDimension, outputDimension};
+    for (unsigned i = 0u; i < outputDimension; ++i)
+        for (unsigned j = 0u; j < inputDimension; ++j)
+            t(j, i) = (*this)(i, j);
+    return t;
+}
+
+// Return the transformed vector
+EuclideanVector LinearTransform::apply(const EuclideanVector& v) const {
+    assert(v.getNumDimensions() == inputDimension);
+    return EuclideanVector{RowProducts{coefficients.data(), outputDimension, v}};
+}
+
+// Write the transformed vector to out
+void LinearTransform::apply(ConstEuclideanVectorView v, EuclideanVectorView out) const {
+    assert(v.getNumDimensions() == inputDimension && out.getNumDimensions() == outputDimension);
+    RowProducts products {coefficients.data(), outputDimension, v};
+    for (unsigned i = 0u; i < outputDimension; ++i)
+        out[i] = products[i];
+}
+
+// Write every transformed vector of in to the same row of out
+void LinearTransform::apply(const EuclideanVectorBatch& in, EuclideanVectorBatch& out) const {
+    assert(in.getNumDimensions() == inputDimension && out.getNumDimensions() == outputDimension);
+    assert(in.size() == out.size() && out.getLayout() == EuclideanVectorBatch::Layout::RowMajor && &in != &out);
+    if (in.getLayout() != EuclideanVectorBatch::Layout::RowMajor)
+        return apply(in.toLayout(EuclideanVectorBatch::Layout::RowMajor), out);
+
+    // out[v][r] is the dot product of vector v with row r, the same product of rows as a pairwise
+    // dot matrix, computed tile by tile straight into out
+    const std::size_t vectorTiles = (in.size() + tileSize - 1u) / tileSize;
+    const std::size_t rowTiles = (outputDimension + tileSize - 1u) / tileSize;
+    ThreadPool::instance().parallelFor(vectorTiles * rowTiles, 1u, [&] (std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t t = begin; t < end; ++t) {
+            const std::size_t vectorBegin = t / rowTiles * tileSize, rowBegin = t % rowTiles * tileSize;
+            const std::size_t vectors = std::min<std::size_t>(tileSize, in.size() - vectorBegin);
+            const std::size_t rows = std::min<std::size_t>(tileSize, outputDimension - rowBegin);
+            double* tile = out.data() + vectorBegin * outputDimension + rowBegin;
+            for (std::size_t v = 0u; v < vectors; ++v)
+                std::fill_n(tile + v * outputDimension, rows, 0.0);
+            for (std::size_t k = 0u; k < inputDimension; k += depthBlock)
+                kernels::dotBlock(in.data() + vectorBegin * inputDimension + k, vectors, coefficients.data() + rowBegin * inputDimension + k,
+                                  rows, std::min<std::size_t>(depthBlock, inputDimension - k), inputDimension, tile, outputDimension);
+        }
+    });
+}
+
+// Return the transformed vectors of a batch
+EuclideanVectorBatch LinearTransform::apply(const EuclideanVectorBatch& in) const {
+    EuclideanVectorBatch out {in.size(), outputDimension};
+    apply(in, out);
+    return out;
+}
@@ -0,0 +1,64 @@
+#ifndef A2_LINEARTRANSFORM_H
+#define A2_LINEARTRANSFORM_H
+
+#include <vector>
+
+#include "EuclideanVector.h"
+#include "EuclideanVectorBatch.h"
+#include "EuclideanVectorView.h"
+
+namespace evec {
+    // Dense linear map from getInputDimension() to getOutputDimension() dimensions (projections,
+    // rotations), stored as a row-major matrix with one row per output dimension. Applying it to a
+    // batch multiplies tiles of vectors by tiles of rows with the register-blocked dotBlock kernel
+    // (see EuclideanVectorKernels.h), spreads the tiles over the thread pool and writes straight
+    // into the output batch, so nothing is allocated per vector.
+    class LinearTransform {
+    public:
+        // Constructor that takes the number of output and input dimensions, every coefficient zero
+        LinearTransform(unsigned outputDimension, unsigned inputDimension);
+
+        // Constructor that takes the coefficients row by row. Throws std::invalid_argument unless
+        // there are outputDimension * inputDimension of them.
+        LinearTransform(unsigned outputDimension, unsigned inputDimension, std::vector<double> coefficients);
+
+        // Return the identity on the given number of dimensions
+        static LinearTransform identity(unsigned dimension);
+
+        // Return the number of dimensions of the vectors it applies to
+        unsigned getInputDimension() const { return inputDimension; }
+
+        // Return the number of dimensions of the vectors it produces
+        unsigned getOutputDimension() const { return outputDimension; }
+
+        // Return the coefficient of input dimension column in output dimension row
+        double& operator()(unsigned row, unsigned column) { return coefficients[row * inputDimension + column]; }
+        double operator()(unsigned row, unsigned column) const { return coefficients[row * inputDimension + column]; }
+
+        // Return the coefficients, row by row
+        double* data() { return coefficients.data(); }
+        const double* data() const { return coefficients.data(); }
+
+        // Return the transpose, which is the inverse of a rotation
+        LinearTransform transposed() const;
+
+        // Return the transformed vector
+        EuclideanVector apply(const EuclideanVector&) const;
+
+        // Write the transformed vector to out, which must not overlap v
+        void apply(ConstEuclideanVectorView v, EuclideanVectorView out) const;
+
+        // Write every transformed vector of in to the same row of out, which must be a row-major
+        // batch of in.size() vectors of getOutputDimension() dimensions, distinct from in
+        void apply(const EuclideanVectorBatch& in, EuclideanVectorBatch& out) const;
+
+        // Return the transformed vectors of a batch, row-major
+        EuclideanVectorBatch apply(const EuclideanVectorBatch&) const;
+
+    private:
+        unsigned outputDimension; // Number of rows
+        unsigned inputDimension; // Number of columns
+        std::vector<double> coefficients; // outputDimension * inputDimension coefficients, row by row
+    };
+}
+#endif
@@ -0,0 +1,118 @@
+#include "MemoryResource.h"
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+
+using namespace evec;
+
+namespace {
+    // Resource that forwards to the global operator new and operator delete
+    class NewDeleteResource : public MemoryResource {
+    public:
+        void* allocate(std::size_t bytes, std::size_t alignment) override {
+            if (alignment <= alignof(std::max_align_t))
+                return ::operator new(bytes);
+
+            // Over-allocate and keep the original pointer just before the aligned storage
+            void* raw = ::operator new(bytes + alignment + sizeof(void*));
+            std::uintptr_t first = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*);
+            void* aligned = reinterpret_cast<void*>((first + alignment - 1) & ~(alignment - 1));
+            static_cast<void**>(aligned)[-1] = raw;
+            return aligned;
+        }
+
+        void deallocate(void* p, std::size_t, std::size_t alignment) override {
+            if (alignment <= alignof(std::max_align_t))
+                ::operator delete(p);
+            else
+                ::operator delete(static_cast<void**>(p)[-1]);
+        }
+    };
+
+    NewDeleteResource newDelete;
+    std::atomic<MemoryResource*> defaultResource {&newDelete};
+
+    // Round p up to the next multiple of alignment
+    char* alignUp(char* p, std::size_t alignment) {
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(p);
+        return p + ((alignment - address % alignment) % alignment);
+    }
+}
+
+MemoryResource* evec::newDeleteResource() {
+    return &newDelete;
+}
+
+MemoryResource* evec::getDefaultResource() {
+    return defaultResource.load(std::memory_order_acquire);
+}
+
+MemoryResource* evec::setDefaultResource(MemoryResource* r) {
+    return defaultResource.exchange(r != nullptr ? r : &newDelete, std::memory_order_acq_rel);
+}
+
+/*************************************************  MonotonicArena  ***************************************************/
+
+// Constructor that takes the size of the first block and the resource blocks are obtained from
+MonotonicArena::MonotonicArena(std::size_t initialSize, MemoryResource* up):
+        upstream{up}, nextSize{initialSize < sizeof(Block) * 2 ? sizeof(Block) * 2 : initialSize} {}
+
+// Destructor
+MonotonicArena::~MonotonicArena() noexcept {
+    while (head != nullptr) {
+        Block* previous = head->previous;
+        release(head);
+        head = previous;
+    }
+}
+
+void* MonotonicArena::allocate(std::size_t bytes, std::size_t alignment) {
+    char* p = current != nullptr ? alignUp(current, alignment) : nullptr;
+    if (p == nullptr || p > limit || static_cast<std::size_t>(limit - p) < bytes) {
+        grow(bytes, alignment);
+        p = alignUp(current, alignment);
+    }
+    current = p + bytes;
+    allocated += bytes;
+    return p;
+}
+
+// Make all storage available again, keeping the largest block for the next request
+void MonotonicArena::reset() {
+    if (head == nullptr)
+        return;
+
+    // Blocks grow geometrically, so the head block is the largest one
+    Block* keep = head;
+    Block* b = head->previous;
+    while (b != nullptr) {
+        Block* previous = b->previous;
+        release(b);
+        b = previous;
+    }
+    keep->previous = nullptr;
+    current = reinterpret_cast<char*>(keep) + sizeof(Block);
+    limit = reinterpret_cast<char*>(keep) + keep->size;
+    allocated = 0u;
+}
+
+// Obtain a new head block big enough for the given request
+void MonotonicArena::grow(std::size_t bytes, std::size_t alignment) {
+    std::size_t needed = sizeof(Block) + bytes + alignment;
+    while (nextSize < needed)
+        nextSize *= 2;
+
+    Block* b = static_cast<Block*>(upstream->allocate(nextSize, alignof(std::max_align_t)));
+    b->previous = head;
+    b->size = nextSize;
+    head = b;
+    current = reinterpret_cast<char*>(b) + sizeof(Block);
+    limit = reinterpret_cast<char*>(b) + b->size;
+    nextSize *= 2;
+}
+
+// Return a block to the upstream resource
+void MonotonicArena::release(Block* b) {
+    upstream->deallocate(b, b->size, alignof(std::max_align_t));
+}
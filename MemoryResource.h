@@ -0,0 +1,73 @@
+#ifndef A2_MEMORYRESOURCE_H
+#define A2_MEMORYRESOURCE_H
+
+#include <cstddef>
+
+namespace evec {
+    // Source of the heap storage used by EuclideanVector (modelled on std::pmr::memory_resource)
+    class MemoryResource {
+    public:
+        virtual ~MemoryResource() = default;
+
+        // Return storage for the given number of bytes with the given alignment (a power of two)
+        virtual void* allocate(std::size_t bytes, std::size_t alignment) = 0;
+
+        // Release storage obtained from allocate with the same size and alignment
+        virtual void deallocate(void* p, std::size_t bytes, std::size_t alignment) = 0;
+    };
+
+    // Return the resource that forwards to the global operator new and operator delete
+    MemoryResource* newDeleteResource();
+
+    // Return the resource used by vectors that are not given one explicitly
+    MemoryResource* getDefaultResource();
+
+    // Replace the default resource (nullptr restores newDeleteResource) and return the previous one
+    MemoryResource* setDefaultResource(MemoryResource*);
+
+    // Resource that hands out storage by bumping a pointer through blocks obtained from an upstream
+    // resource. deallocate does nothing, all storage is reclaimed at once by reset or the destructor.
+    // Not thread safe, use one arena per request or per thread.
+    class MonotonicArena : public MemoryResource {
+    public:
+        // Constructor that takes the size of the first block and the resource blocks are obtained from
+        explicit MonotonicArena(std::size_t initialSize = 64u * 1024u, MemoryResource* upstream = newDeleteResource());
+
+        MonotonicArena(const MonotonicArena&) = delete;
+        MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+        // Destructor
+        ~MonotonicArena() noexcept override;
+
+        void* allocate(std::size_t bytes, std::size_t alignment) override;
+
+        void deallocate(void*, std::size_t, std::size_t) override {}
+
+        // Make all storage available again, keeping the largest block for the next request
+        void reset();
+
+        // Return the number of bytes handed out since the last reset
+        std::size_t bytesAllocated() const { return allocated; }
+
+    private:
+        // Header at the start of every block, blocks form a list from the newest to the oldest
+        struct Block {
+            Block* previous;
+            std::size_t size; // Size of the block including this header
+        };
+
+        MemoryResource* upstream;
+        Block* head = nullptr; // Block currently being bumped through
+        char* current = nullptr; // Next free byte in the head block
+        char* limit = nullptr; // One past the last byte of the head block
+        std::size_t nextSize; // Size of the next block obtained from upstream
+        std::size_t allocated = 0u; // Bytes handed out since the last reset
+
+        // Obtain a new head block big enough for the given request
+        void grow(std::size_t bytes, std::size_t alignment);
+
+        // Return a block to the upstream resource
+        void release(Block*);
+    };
+}
+#endif
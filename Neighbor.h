@@ -0,0 +1,67 @@
+#ifndef A2_NEIGHBOR_H
+#define A2_NEIGHBOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace evec {
+    // One result of a nearest neighbour search
+    struct Neighbor {
+        std::size_t id; // Position of the vector in the index
+        double distance; // Distance from the query
+    };
+
+    // Orders neighbours by distance, then by id so results do not depend on the order they were found in
+    inline bool operator<(const Neighbor& a, const Neighbor& b) {
+        return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+    }
+
+    // Keeps the k nearest of the neighbours pushed into it in a max-heap, so the farthest one
+    // can be replaced in O(log k)
+    class TopK {
+    public:
+        // Constructor that takes the number of neighbours to keep
+        explicit TopK(std::size_t k): capacity{k} { heap.reserve(k); }
+
+        // Keep the neighbour if it is nearer than the farthest one kept
+        void push(std::size_t id, double distance) {
+            Neighbor n {id, distance};
+            if (heap.size() < capacity) {
+                heap.push_back(n);
+                std::push_heap(heap.begin(), heap.end());
+            } else if (capacity != 0u && n < heap.front()) {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.back() = n;
+                std::push_heap(heap.begin(), heap.end());
+            }
+        }
+
+        // Keep the nearest of the neighbours kept by both
+        void merge(const TopK& other) {
+            for (const Neighbor& n : other.heap)
+                push(n.id, n.distance);
+        }
+
+        // Return the distance a neighbour must beat to be kept, infinity until k are kept
+        double worst() const {
+            return heap.size() < capacity ? std::numeric_limits<double>::infinity() : heap.front().distance;
+        }
+
+        // Return the number of neighbours kept
+        std::size_t size() const { return heap.size(); }
+
+        // Return the neighbours kept, nearest first
+        std::vector<Neighbor> sorted() const {
+            std::vector<Neighbor> result {heap};
+            std::sort_heap(result.begin(), result.end());
+            return result;
+        }
+
+    private:
+        std::size_t capacity; // Number of neighbours to keep
+        std::vector<Neighbor> heap; // Max-heap of the neighbours kept
+    };
+}
+#endif
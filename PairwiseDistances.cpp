@@ -0,0 +1,140 @@
+#include "PairwiseDistances.h"
+#include "EuclideanVectorKernels.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace evec;
+
+namespace {
+    // Vectors of each set in a tile. The depth block of a tile's rows (64 x 256 doubles, 128 KiB)
+    // stays in the L2 cache, and the 32 KiB of values is what the sink receives at a time.
+    const std::size_t tileSize = 64u;
+
+    // Magnitudes of every vector multiplied in one pass. The four rows of the second set the kernel
+    // works on (8 KiB) stay in the L1 cache while the rows of the first set go past.
+    const std::size_t depthBlock = 256u;
+
+    // Return the squared norm of every vector of a row-major batch
+    std::vector<double> squaredNorms(const EuclideanVectorBatch& batch) {
+        const unsigned dimension = batch.getNumDimensions();
+        std::vector<double> res(batch.size());
+        ThreadPool::instance().parallelFor(batch.size(), 1024u, [&] (std::size_t, std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i)
+                res[i] = kernels::sumOfSquares(batch.data() + i * dimension, dimension);
+        });
+        return res;
+    }
+
+    // Compute the tiles of a against b, only those on and above the diagonal if upperTriangle
+    // (a and b are then the same set), and hand them to sink
+    void computeTiles(const EuclideanVectorBatch& a, const EuclideanVectorBatch& b, bool upperTriangle,
+                      PairwiseMetric metric, const PairwiseTileSink& sink) {
+        assert(a.getNumDimensions() == b.getNumDimensions());
+        assert(a.getLayout() == EuclideanVectorBatch::Layout::RowMajor && b.getLayout() == EuclideanVectorBatch::Layout::RowMajor);
+        const std::size_t dimension = a.getNumDimensions();
+        const std::size_t rowTiles = (a.size() + tileSize - 1u) / tileSize;
+        const std::size_t columnTiles = (b.size() + tileSize - 1u) / tileSize;
+        const std::size_t tileCount = upperTriangle ? rowTiles * (rowTiles + 1u) / 2u : rowTiles * columnTiles;
+
+        std::vector<double> normsA, normsB;
+        if (metric != PairwiseMetric::Dot) {
+            normsA = squaredNorms(a);
+            normsB = upperTriangle ? normsA : squaredNorms(b);
+        }
+
+        // Each thread takes a run of consecutive tiles, row of tiles by row of tiles, so the rows of
+        // a stay in cache from one tile to the next
+        auto tilesInRow = [&] (std::size_t r) { return upperTriangle ? rowTiles - r : columnTiles; };
+        ThreadPool::instance().parallelFor(tileCount, 1u, [&] (std::size_t, std::size_t begin, std::size_t end) {
+            std::size_t r = 0u, c = begin;
+            while (c >= tilesInRow(r))
+                c -= tilesInRow(r++);
+            if (upperTriangle)
+                c += r;
+
+            std::vector<double> values(tileSize * tileSize);
+            for (std::size_t t = begin; t < end; ++t) {
+                PairwiseTile tile {r * tileSize, std::min(a.size(), (r + 1u) * tileSize),
+                                   c * tileSize, std::min(b.size(), (c + 1u) * tileSize), values.data()};
+                const std::size_t rows = tile.rows(), columns = tile.columns();
+                std::fill(values.begin(), values.begin() + rows * columns, 0.0);
+                for (std::size_t k = 0u; k < dimension; k += depthBlock)
+                    kernels::dotBlock(a.data() + tile.rowBegin * dimension + k, rows, b.data() + tile.columnBegin * dimension + k,
+                                      columns, std::min(depthBlock, dimension - k), dimension, values.data(), columns);
+
+                if (metric != PairwiseMetric::Dot) {
+                    for (std::size_t i = 0u; i < rows; ++i) {
+                        double* row = values.data() + i * columns;
+                        const double normA = normsA[tile.rowBegin + i];
+                        for (std::size_t j = 0u; j < columns; ++j) {
+                            // Rounding can push the expansion slightly below zero for nearly equal vectors
+                            double d = std::max(0.0, normA + normsB[tile.columnBegin + j] - 2.0 * row[j]);
+                            row[j] = metric == PairwiseMetric::Distance ? std::sqrt(d) : d;
+                        }
+                    }
+                    if (upperTriangle && r == c)
+                        for (std::size_t i = 0u; i < rows; ++i)
+                            values[i * columns + i] = 0.0;
+                }
+                sink(tile);
+
+                if (++c == columnTiles) {
+                    ++r;
+                    c = upperTriangle ? r : 0u;
+                }
+            }
+        });
+    }
+
+    // Return the batch itself if it is row-major, otherwise a row-major copy stored in holder
+    const EuclideanVectorBatch& rowMajor(const EuclideanVectorBatch& batch, EuclideanVectorBatch& holder) {
+        if (batch.getLayout() == EuclideanVectorBatch::Layout::RowMajor)
+            return batch;
+        holder = batch.toLayout(EuclideanVectorBatch::Layout::RowMajor);
+        return holder;
+    }
+}
+
+/***********************************************  Pairwise tiles  *****************************************************/
+
+// Compute the metric between every vector of a and every vector of b, one tile at a time
+void evec::computePairwise(const EuclideanVectorBatch& a, const EuclideanVectorBatch& b, PairwiseMetric metric,
+                           const PairwiseTileSink& sink) {
+    assert(a.getNumDimensions() == b.getNumDimensions());
+    EuclideanVectorBatch rowsA {0u, a.getNumDimensions()}, rowsB {0u, b.getNumDimensions()};
+    computeTiles(rowMajor(a, rowsA), rowMajor(b, rowsB), false, metric, sink);
+}
+
+// Compute the metric between the vectors of one set, only the tiles on and above the diagonal
+void evec::computePairwise(const EuclideanVectorBatch& set, PairwiseMetric metric, const PairwiseTileSink& sink) {
+    EuclideanVectorBatch rows {0u, set.getNumDimensions()};
+    const EuclideanVectorBatch& vectors = rowMajor(set, rows);
+    computeTiles(vectors, vectors, true, metric, sink);
+}
+
+/***********************************************  Whole matrices  *****************************************************/
+
+// Return the whole a.size() x b.size() matrix
+std::vector<double> evec::pairwiseMatrix(const EuclideanVectorBatch& a, const EuclideanVectorBatch& b, PairwiseMetric metric) {
+    std::vector<double> matrix(a.size() * b.size());
+    computePairwise(a, b, metric, [&] (const PairwiseTile& tile) {
+        for (std::size_t i = tile.rowBegin; i < tile.rowEnd; ++i)
+            std::copy_n(tile.values + (i - tile.rowBegin) * tile.columns(), tile.columns(), matrix.data() + i * b.size() + tile.columnBegin);
+    });
+    return matrix;
+}
+
+// Return the whole symmetric matrix of one set, mirroring the tiles above the diagonal
+std::vector<double> evec::pairwiseMatrix(const EuclideanVectorBatch& set, PairwiseMetric metric) {
+    const std::size_t n = set.size();
+    std::vector<double> matrix(n * n);
+    computePairwise(set, metric, [&] (const PairwiseTile& tile) {
+        for (std::size_t i = tile.rowBegin; i < tile.rowEnd; ++i)
+            for (std::size_t j = std::max(i, tile.columnBegin); j < tile.columnEnd; ++j)
+                matrix[i * n + j] = matrix[j * n + i] = tile(i, j);
+    });
+    return matrix;
+}
@@ -0,0 +1,64 @@
+#ifndef A2_PAIRWISEDISTANCES_H
+#define A2_PAIRWISEDISTANCES_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "EuclideanVectorBatch.h"
+
+namespace evec {
+    // Value computed for every pair of vectors
+    enum class PairwiseMetric {
+        Dot,             // a.b
+        SquaredDistance, // ||a - b||^2
+        Distance         // ||a - b||
+    };
+
+    // Block of a pairwise matrix: the values for the vectors [rowBegin, rowEnd) of the first set
+    // against the vectors [columnBegin, columnEnd) of the second, stored one row after another
+    struct PairwiseTile {
+        std::size_t rowBegin, rowEnd;
+        std::size_t columnBegin, columnEnd;
+        const double* values;
+
+        // Return the number of rows
+        std::size_t rows() const { return rowEnd - rowBegin; }
+
+        // Return the number of columns
+        std::size_t columns() const { return columnEnd - columnBegin; }
+
+        // Return the value for vector row of the first set and vector column of the second
+        // (indices into the sets, not into the tile)
+        double operator()(std::size_t row, std::size_t column) const {
+            return values[(row - rowBegin) * columns() + (column - columnBegin)];
+        }
+    };
+
+    // Receives the tiles of a pairwise computation. It is called from several threads at once with
+    // different tiles, and the values of a tile are only valid during the call that receives it.
+    using PairwiseTileSink = std::function<void(const PairwiseTile&)>;
+
+    // Compute the metric between every vector of a and every vector of b, handing the matrix to sink
+    // one tile at a time, so the whole matrix is never held in memory. The computation is blocked
+    // like a matrix product: a tile of vectors of a stays in the L2 cache while the vectors of b go
+    // past a few at a time through the register-blocked dotBlock kernel, and the tiles are spread
+    // over the thread pool. Distances come from ||a||^2 + ||b||^2 - 2 a.b with the squared norms
+    // computed once per vector, which loses precision for vectors much closer together than their
+    // norms. Sets of EuclideanVectors convert to a batch with EuclideanVectorBatch{vectors}.
+    // An exception thrown by sink stops the computation and is rethrown.
+    void computePairwise(const EuclideanVectorBatch& a, const EuclideanVectorBatch& b, PairwiseMetric,
+                         const PairwiseTileSink& sink);
+
+    // Same as above for the pairs of vectors of one set, computing only the tiles on and above the
+    // diagonal. Tiles on the diagonal are square and also hold the values below it, so a caller that
+    // wants every pair once keeps the values with column > row. Distances on the diagonal are exactly zero.
+    void computePairwise(const EuclideanVectorBatch& set, PairwiseMetric, const PairwiseTileSink& sink);
+
+    // Return the whole a.size() x b.size() matrix, row-major
+    std::vector<double> pairwiseMatrix(const EuclideanVectorBatch& a, const EuclideanVectorBatch& b, PairwiseMetric);
+
+    // Return the whole symmetric set.size() x set.size() matrix of one set, row-major
+    std::vector<double> pairwiseMatrix(const EuclideanVectorBatch& set, PairwiseMetric);
+}
+#endif
@@ -0,0 +1,94 @@
+#include "PqIndex.h"
+#include "ThreadPool.h"
+
+#include <cassert>
+#include <cmath>
+
+using namespace evec;
+
+constexpr std::size_t PqIndex::blockSize;
+
+/***************************************  Constructors and destructors  ***********************************************/
+
+// Constructor that takes the number of dimensions, the number of subspaces and the parameters of the codebook training
+PqIndex::PqIndex(unsigned d, unsigned m, KMeansParameters p): quantizer{d, m, p} {}
+
+/***********************************************  Member Functions  ***************************************************/
+
+// Insert a vector and return its id
+std::size_t PqIndex::add(ConstEuclideanVectorView v) {
+    assert(v.getNumDimensions() == getNumDimensions());
+    std::vector<std::uint8_t> code(quantizer.getCodeSize());
+    quantizer.encode(v, code.data());
+    store(count, code.data());
+    return count++;
+}
+
+// Insert every vector of a batch
+void PqIndex::add(const EuclideanVectorBatch& batch) {
+    std::vector<std::uint8_t> batchCodes(batch.size() * quantizer.getCodeSize());
+    quantizer.encode(batch, batchCodes.data());
+    for (std::size_t i = 0u; i < batch.size(); ++i)
+        store(count + i, batchCodes.data() + i * quantizer.getCodeSize());
+    count += batch.size();
+}
+
+// Return about the k nearest vectors to the query by their approximate distances
+std::vector<Neighbor> PqIndex::search(ConstEuclideanVectorView query, std::size_t k) const {
+    const unsigned m = quantizer.getCodeSize();
+    std::vector<float> table(m * ProductQuantizer::codebookSize);
+    quantizer.computeDistanceTable(query, table.data());
+
+    TopK nearest {k};
+    float sums[blockSize];
+    for (std::size_t first = 0u; first < count; first += blockSize) {
+        const std::uint8_t* block = codes.data() + first * m;
+        std::fill(sums, sums + blockSize, 0.0f);
+        for (unsigned s = 0u; s < m; ++s) {
+            const float* entries = table.data() + s * ProductQuantizer::codebookSize;
+            const std::uint8_t* subcodes = block + s * blockSize;
+            for (std::size_t j = 0u; j < blockSize; ++j)
+                sums[j] += entries[subcodes[j]];
+        }
+        std::size_t n = std::min(blockSize, count - first);
+        for (std::size_t j = 0u; j < n; ++j)
+            nearest.push(first + j, sums[j]);
+    }
+
+    std::vector<Neighbor> found = nearest.sorted();
+    for (Neighbor& n : found)
+        n.distance = std::sqrt(n.distance);
+    return found;
+}
+
+// Return about the k nearest vectors to every query
+std::vector<std::vector<Neighbor>> PqIndex::search(const EuclideanVectorBatch& queries, std::size_t k) const {
+    assert(queries.getNumDimensions() == getNumDimensions());
+    if (queries.getLayout() != EuclideanVectorBatch::Layout::RowMajor)
+        return search(queries.toLayout(EuclideanVectorBatch::Layout::RowMajor), k);
+
+    std::vector<std::vector<Neighbor>> results(queries.size());
+    ThreadPool::instance().parallelFor(queries.size(), 1u, [&] (std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t q = begin; q < end; ++q)
+            results[q] = search(ConstEuclideanVectorView{queries.data() + q * getNumDimensions(), getNumDimensions()}, k);
+    });
+    return results;
+}
+
+// Write the code of the vector with the given id to code
+void PqIndex::getCode(std::size_t id, std::uint8_t* code) const {
+    const unsigned m = quantizer.getCodeSize();
+    const std::uint8_t* block = codes.data() + (id - id % blockSize) * m;
+    for (unsigned s = 0u; s < m; ++s)
+        code[s] = block[s * blockSize + id % blockSize];
+}
+
+// Store the code of the vector with the given id
+void PqIndex::store(std::size_t id, const std::uint8_t* code) {
+    const unsigned m = quantizer.getCodeSize();
+    if (id % blockSize == 0u)
+        codes.resize(codes.size() + blockSize * m, 0u);
+    std::uint8_t* block = codes.data() + (id - id % blockSize) * m;
+    for (unsigned s = 0u; s < m; ++s)
+        block[s * blockSize + id % blockSize] = code[s];
+}
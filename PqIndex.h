@@ -0,0 +1,87 @@
+#ifndef A2_PQINDEX_H
+#define A2_PQINDEX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "EuclideanVectorBatch.h"
+#include "EuclideanVectorView.h"
+#include "Neighbor.h"
+#include "ProductQuantizer.h"
+
+namespace evec {
+    // Compressed nearest-neighbour index that keeps only the product quantization codes of its
+    // vectors, m bytes per vector instead of 8 per dimension. A search computes the distance table
+    // of the query once and scans every code with table lookups.
+    //
+    // Codes are stored in blocks of blockSize vectors, subspace by subspace: the codes of the
+    // block's vectors for subspace 0, then for subspace 1, and so on. The scan then adds the
+    // table entry of one subspace to blockSize running sums at a time, a loop the compiler can
+    // vectorize.
+    class PqIndex {
+    public:
+        // Number of vectors whose codes are interleaved
+        static constexpr std::size_t blockSize = 32u;
+
+        // Constructor that takes the number of dimensions, the number of subspaces (bytes per vector)
+        // and the parameters of the codebook training. Throws std::invalid_argument unless the
+        // number of subspaces divides the dimension.
+        PqIndex(unsigned dimension, unsigned subspaces, KMeansParameters = KMeansParameters{});
+
+        // Train the codebooks on a sample of the vectors that will be indexed
+        void train(const EuclideanVectorBatch& sample) { quantizer.train(sample); }
+
+        // Return true once the codebooks are trained
+        bool isTrained() const { return quantizer.isTrained(); }
+
+        // Insert a vector and return its id (ids are given out in insertion order starting at 0)
+        std::size_t add(ConstEuclideanVectorView v);
+
+        // Insert every vector of a batch, they get consecutive ids in batch order
+        void add(const EuclideanVectorBatch&);
+
+        // Return about the k nearest vectors to the query by their approximate distances, nearest first
+        std::vector<Neighbor> search(ConstEuclideanVectorView query, std::size_t k) const;
+
+        // Return about the k nearest vectors to every query, spreading the queries over the thread pool
+        std::vector<std::vector<Neighbor>> search(const EuclideanVectorBatch& queries, std::size_t k) const;
+
+        // Return the k nearest of the candidates nearest to the query by approximate distance, re-ranked
+        // by their exact distances to the original vectors. originals[id] must return a vector
+        // expression (a row of an EuclideanVectorBatch, a view of a MappedVectorFile, an EuclideanVector...)
+        template <typename Originals>
+        std::vector<Neighbor> search(ConstEuclideanVectorView query, std::size_t k, std::size_t candidates,
+                                     const Originals& originals) const {
+            std::vector<Neighbor> found = search(query, std::max(k, candidates));
+            for (Neighbor& n : found)
+                n.distance = distance(query, originals[n.id]);
+            std::sort(found.begin(), found.end());
+            if (found.size() > k)
+                found.resize(k);
+            return found;
+        }
+
+        // Return the codec
+        const ProductQuantizer& getQuantizer() const { return quantizer; }
+
+        // Return the number of vectors inserted
+        std::size_t size() const { return count; }
+
+        // Return the number of dimensions of the vectors
+        unsigned getNumDimensions() const { return quantizer.getNumDimensions(); }
+
+        // Write the code of the vector with the given id to code (getCodeSize() bytes)
+        void getCode(std::size_t id, std::uint8_t* code) const;
+
+    private:
+        ProductQuantizer quantizer;
+        std::vector<std::uint8_t> codes; // Blocks of blockSize codes stored subspace by subspace
+        std::size_t count = 0u; // Vectors inserted
+
+        // Store the code of the vector with the given id
+        void store(std::size_t id, const std::uint8_t* code);
+    };
+}
+#endif
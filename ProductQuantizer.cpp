@@ -0,0 +1,95 @@
+#include "ProductQuantizer.h"
+#include "ThreadPool.h"
+
+#include <cassert>
+#include <stdexcept>
+
+using namespace evec;
+
+constexpr unsigned ProductQuantizer::codebookSize;
+
+namespace {
+    // Return the number of dimensions of every subspace, checked before anything divides by m
+    unsigned subspaceWidth(unsigned d, unsigned m) {
+        if (m == 0u || d == 0u || d % m != 0u)
+            throw std::invalid_argument{"product quantization needs a number of subspaces that divides the dimension"};
+        return d / m;
+    }
+}
+
+/***************************************  Constructors and destructors  ***********************************************/
+
+// Constructor that takes the number of dimensions, the number of subspaces and the parameters of the codebook training
+ProductQuantizer::ProductQuantizer(unsigned d, unsigned m, KMeansParameters p):
+        dimension{d}, subspaces{m}, width{subspaceWidth(d, m)}, codebooks(m, KMeans{codebookSize, p}) {}
+
+/***********************************************  Member Functions  ***************************************************/
+
+// Train the codebooks on a sample of the vectors that will be encoded
+void ProductQuantizer::train(const EuclideanVectorBatch& sample) {
+    assert(sample.getNumDimensions() == dimension);
+    if (sample.size() < codebookSize)
+        throw std::invalid_argument{"product quantization needs at least 256 training vectors"};
+
+    ThreadPool::instance().parallelFor(subspaces, 1u, [&] (std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t s = begin; s < end; ++s) {
+            // Gather the subvectors of this subspace into a batch of their own
+            EuclideanVectorBatch subvectors {sample.size(), width};
+            for (std::size_t i = 0u; i < sample.size(); ++i) {
+                EuclideanVectorBatch::ConstRow row = sample[i];
+                for (unsigned j = 0u; j < width; ++j)
+                    subvectors.data()[i * width + j] = row[static_cast<unsigned>(s) * width + j];
+            }
+            codebooks[s].train(subvectors);
+        }
+    });
+}
+
+// Write the code of a vector to code
+void ProductQuantizer::encode(const double* v, std::uint8_t* code) const {
+    assert(isTrained());
+    for (unsigned s = 0u; s < subspaces; ++s)
+        code[s] = static_cast<std::uint8_t>(codebooks[s].nearest(v + s * width));
+}
+
+// Write the codes of every vector of a batch to codes
+void ProductQuantizer::encode(const EuclideanVectorBatch& batch, std::uint8_t* codes) const {
+    assert(batch.getNumDimensions() == dimension);
+    if (batch.getLayout() != EuclideanVectorBatch::Layout::RowMajor) {
+        encode(batch.toLayout(EuclideanVectorBatch::Layout::RowMajor), codes);
+        return;
+    }
+    ThreadPool::instance().parallelFor(batch.size(), 256u, [&] (std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i)
+            encode(batch.data() + i * dimension, codes + i * subspaces);
+    });
+}
+
+// Return the vector made of the centroids a code refers to
+EuclideanVector ProductQuantizer::decode(const std::uint8_t* code) const {
+    assert(isTrained());
+    EuclideanVector v (dimension);
+    for (unsigned s = 0u; s < subspaces; ++s) {
+        EuclideanVectorBatch::ConstRow centroid = codebooks[s].getCentroids()[code[s]];
+        for (unsigned j = 0u; j < width; ++j)
+            v[s * width + j] = centroid[j];
+    }
+    return v;
+}
+
+// Write the squared distances from the subvectors of the query to every centroid to table
+void ProductQuantizer::computeDistanceTable(ConstEuclideanVectorView query, float* table) const {
+    assert(isTrained() && query.getNumDimensions() == dimension);
+    for (unsigned s = 0u; s < subspaces; ++s) {
+        const double* subquery = query.data() + s * width;
+        const double* centroids = codebooks[s].getCentroids().data();
+        for (unsigned c = 0u; c < codebookSize; ++c) {
+            double sum = 0.0;
+            for (unsigned j = 0u; j < width; ++j) {
+                double d = subquery[j] - centroids[c * width + j];
+                sum += d * d;
+            }
+            table[s * codebookSize + c] = static_cast<float>(sum);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef A2_PRODUCTQUANTIZER_H
+#define A2_PRODUCTQUANTIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "EuclideanVector.h"
+#include "EuclideanVectorBatch.h"
+#include "EuclideanVectorView.h"
+#include "KMeans.h"
+
+namespace evec {
+    // Product quantization codec (Jegou, Douze and Schmid). The dimensions are split into m
+    // subspaces of equal width, and each subspace gets a codebook of 256 centroids trained with
+    // k-means. A vector is encoded as m bytes, the nearest centroid of each of its subvectors.
+    //
+    // Distances between a query and encoded vectors are computed asymmetrically: the query is
+    // kept exact, the squared distances from each of its subvectors to every centroid of that
+    // subspace are computed once into a table of m * 256 floats, and the distance to an encoded
+    // vector is then the sum of m table lookups.
+    class ProductQuantizer {
+    public:
+        // Number of centroids per subspace, so a subspace code fits one byte
+        static constexpr unsigned codebookSize = 256u;
+
+        // Constructor that takes the number of dimensions, the number of subspaces and the parameters
+        // of the codebook training. Throws std::invalid_argument unless the number of subspaces is
+        // positive and divides the (positive) dimension.
+        ProductQuantizer(unsigned dimension, unsigned subspaces, KMeansParameters = KMeansParameters{});
+
+        // Train the codebooks on a sample of the vectors that will be encoded, one subspace per thread.
+        // Throws std::invalid_argument if the sample has fewer than codebookSize vectors.
+        void train(const EuclideanVectorBatch& sample);
+
+        // Return true once the codebooks are trained
+        bool isTrained() const { return codebooks.front().isTrained(); }
+
+        // Return the number of dimensions of the vectors
+        unsigned getNumDimensions() const { return dimension; }
+
+        // Return the number of bytes of a code, one per subspace
+        unsigned getCodeSize() const { return subspaces; }
+
+        // Write the code of a vector to code (getCodeSize() bytes)
+        void encode(ConstEuclideanVectorView v, std::uint8_t* code) const { encode(v.data(), code); }
+        void encode(const double* v, std::uint8_t* code) const;
+
+        // Write the codes of every vector of a batch to codes (size() * getCodeSize() bytes), on the thread pool
+        void encode(const EuclideanVectorBatch&, std::uint8_t* codes) const;
+
+        // Return the vector made of the centroids a code refers to
+        EuclideanVector decode(const std::uint8_t* code) const;
+
+        // Write the squared distances from the subvectors of the query to every centroid to table
+        // (getCodeSize() * codebookSize floats, the codebookSize entries of a subspace are adjacent)
+        void computeDistanceTable(ConstEuclideanVectorView query, float* table) const;
+
+        // Return the approximate squared distance between the query a table was computed for and an encoded vector
+        float asymmetricSquaredDistance(const float* table, const std::uint8_t* code) const {
+            float sum = 0.0f;
+            for (unsigned s = 0u; s < subspaces; ++s)
+                sum += table[s * codebookSize + code[s]];
+            return sum;
+        }
+
+    private:
+        unsigned dimension;
+        unsigned subspaces; // Number of subspaces, m
+        unsigned width; // Dimensions per subspace
+        std::vector<KMeans> codebooks; // Codebook of every subspace
+    };
+}
+#endif
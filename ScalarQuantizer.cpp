@@ -0,0 +1,137 @@
+#include "ScalarQuantizer.h"
+#include "EuclideanVectorKernels.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+
+using namespace evec;
+
+namespace {
+    // Largest code magnitude. -128 is never used, so the int8 kernels can negate any code.
+    const double maxCode = 127.0;
+
+    // Return the code nearest to x / scale, clamped to [-127, 127]
+    std::int8_t quantize(double x, double inverseScale) {
+        double q = std::round(x * inverseScale);
+        return static_cast<std::int8_t>(std::max(-maxCode, std::min(maxCode, q)));
+    }
+}
+
+/***************************************  Constructors and destructors  ***********************************************/
+
+// Constructor that takes the number of dimensions and the mode
+ScalarQuantizer::ScalarQuantizer(unsigned d, QuantizationMode m):
+        dimension{d}, mode{m}, trained{m == QuantizationMode::PerVector} {}
+
+/***********************************************  Member Functions  ***************************************************/
+
+// Learn the range of every dimension from a sample
+void ScalarQuantizer::train(const EuclideanVectorBatch& sample) {
+    assert(mode == QuantizationMode::PerDimension && sample.getNumDimensions() == dimension);
+    if (sample.size() == 0u)
+        throw std::invalid_argument{"scalar quantization needs at least one training vector"};
+
+    std::vector<double> lowest(dimension, std::numeric_limits<double>::infinity());
+    std::vector<double> highest(dimension, -std::numeric_limits<double>::infinity());
+    for (std::size_t i = 0u; i < sample.size(); ++i) {
+        EuclideanVectorBatch::ConstRow row = sample[i];
+        for (unsigned j = 0u; j < dimension; ++j) {
+            lowest[j] = std::min(lowest[j], row[j]);
+            highest[j] = std::max(highest[j], row[j]);
+        }
+    }
+
+    // Every dimension is centred on its own range, the widest range sets the shared scale
+    centres.assign(dimension, 0.0);
+    centreSquaredNorm = 0.0;
+    double halfRange = 0.0;
+    for (unsigned j = 0u; j < dimension; ++j) {
+        centres[j] = 0.5 * (lowest[j] + highest[j]);
+        centreSquaredNorm += centres[j] * centres[j];
+        halfRange = std::max(halfRange, 0.5 * (highest[j] - lowest[j]));
+    }
+    sharedScale = static_cast<float>(halfRange / maxCode);
+    trained = true;
+}
+
+// Return the quantized form of a vector
+QuantizedVector ScalarQuantizer::encode(ConstEuclideanVectorView v) const {
+    assert(isTrained() && v.getNumDimensions() == dimension);
+    QuantizedVector q;
+    q.codes.resize(dimension);
+
+    if (mode == QuantizationMode::PerVector) {
+        double lowest = dimension == 0u ? 0.0 : *std::min_element(v.cbegin(), v.cend());
+        double highest = dimension == 0u ? 0.0 : *std::max_element(v.cbegin(), v.cend());
+        q.offset = static_cast<float>(0.5 * (lowest + highest));
+        q.scale = static_cast<float>(0.5 * (highest - lowest) / maxCode);
+        double inverseScale = q.scale > 0.0f ? 1.0 / q.scale : 0.0;
+        for (unsigned j = 0u; j < dimension; ++j) {
+            q.codes[j] = quantize(v[j] - q.offset, inverseScale);
+            q.codeSum += q.codes[j];
+            double m = static_cast<double>(q.scale) * q.codes[j] + q.offset;
+            q.squaredNorm += m * m;
+        }
+    } else {
+        q.scale = sharedScale;
+        double inverseScale = sharedScale > 0.0f ? 1.0 / sharedScale : 0.0;
+        for (unsigned j = 0u; j < dimension; ++j) {
+            q.codes[j] = quantize(v[j] - centres[j], inverseScale);
+            q.centreDot += q.codes[j] * centres[j];
+            double m = static_cast<double>(sharedScale) * q.codes[j] + centres[j];
+            q.squaredNorm += m * m;
+        }
+    }
+    return q;
+}
+
+// Return the quantized form of every vector of a batch
+std::vector<QuantizedVector> ScalarQuantizer::encode(const EuclideanVectorBatch& batch) const {
+    assert(batch.getNumDimensions() == dimension);
+    if (batch.getLayout() != EuclideanVectorBatch::Layout::RowMajor)
+        return encode(batch.toLayout(EuclideanVectorBatch::Layout::RowMajor));
+
+    std::vector<QuantizedVector> codes (batch.size());
+    ThreadPool::instance().parallelFor(batch.size(), 256u, [&] (std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i)
+            codes[i] = encode(ConstEuclideanVectorView{batch.data() + i * dimension, dimension});
+    });
+    return codes;
+}
+
+// Return the vector the codes stand for
+EuclideanVector ScalarQuantizer::decode(const QuantizedVector& q) const {
+    assert(q.codes.size() == dimension);
+    EuclideanVector v (dimension);
+    for (unsigned j = 0u; j < dimension; ++j) {
+        double base = mode == QuantizationMode::PerVector ? q.offset : centres[j];
+        v[j] = static_cast<double>(q.scale) * q.codes[j] + base;
+    }
+    return v;
+}
+
+// Return the dot product of two decoded vectors
+double ScalarQuantizer::dot(const QuantizedVector& a, const QuantizedVector& b) const {
+    assert(a.codes.size() == dimension && b.codes.size() == dimension);
+    double codeDot = static_cast<double>(kernels::dot(a.codes.data(), b.codes.data(), dimension));
+    double sa = a.scale, sb = b.scale;
+    if (mode == QuantizationMode::PerDimension)
+        return sa * sb * codeDot + sa * a.centreDot + sb * b.centreDot + centreSquaredNorm;
+
+    double oa = a.offset, ob = b.offset;
+    return sa * sb * codeDot + sa * ob * a.codeSum + oa * sb * b.codeSum + dimension * oa * ob;
+}
+
+// Return the squared euclidean distance between two decoded vectors
+double ScalarQuantizer::squaredDistance(const QuantizedVector& a, const QuantizedVector& b) const {
+    assert(a.codes.size() == dimension && b.codes.size() == dimension);
+    if (mode == QuantizationMode::PerDimension) {
+        double s = sharedScale;
+        return s * s * static_cast<double>(kernels::squaredDistance(a.codes.data(), b.codes.data(), dimension));
+    }
+    // Rounding can push the expansion slightly below zero for nearly equal vectors
+    return std::max(0.0, a.squaredNorm + b.squaredNorm - 2.0 * dot(a, b));
+}
@@ -0,0 +1,83 @@
+#ifndef A2_SCALARQUANTIZER_H
+#define A2_SCALARQUANTIZER_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "EuclideanVector.h"
+#include "EuclideanVectorBatch.h"
+#include "EuclideanVectorView.h"
+
+namespace evec {
+    // How a ScalarQuantizer chooses the affine map from codes back to magnitudes
+    enum class QuantizationMode {
+        PerVector,    // Every vector gets its own scale and offset from its own range, no training needed
+        PerDimension  // train() learns the centre of every dimension and one scale covering the widest one
+    };
+
+    // int8 codes of one vector and the values needed to compute with them. Magnitude j decodes
+    // to scale * codes[j] + offset (per-vector mode) or scale * codes[j] + centre[j] (per-dimension mode).
+    struct QuantizedVector {
+        std::vector<std::int8_t> codes; // One code per dimension, in [-127, 127]
+        float scale = 0.0f; // Step between adjacent codes
+        float offset = 0.0f; // Magnitude of code zero (per-vector mode only)
+        std::int32_t codeSum = 0; // Sum of the codes (per-vector mode)
+        double centreDot = 0.0; // Sum of codes[j] * centre[j] (per-dimension mode)
+        double squaredNorm = 0.0; // Squared norm of the decoded vector
+    };
+
+    // Affine int8 quantization for re-ranking: a vector is stored as one byte per dimension plus a
+    // few scalars, a quarter of the size of floats. Dot products and distances between quantized
+    // vectors run on the int8 kernels (see EuclideanVectorKernels.h) and are exact for the decoded
+    // vectors up to rounding of the final double arithmetic:
+    //  - per-dimension mode shares the scale, so the squared distance is scale^2 times an integer,
+    //    and the dot product adds the precomputed centre terms to the integer one;
+    //  - per-vector mode expands the dot product into the integer one plus sums of codes, and the
+    //    squared distance into ||a||^2 + ||b||^2 - 2 a.b, which loses precision for close vectors.
+    class ScalarQuantizer {
+    public:
+        // Constructor that takes the number of dimensions and the mode
+        explicit ScalarQuantizer(unsigned dimension, QuantizationMode = QuantizationMode::PerVector);
+
+        // Learn the range of every dimension from a sample (per-dimension mode only, magnitudes
+        // outside the range are clamped when encoding). Throws std::invalid_argument if the sample is empty.
+        void train(const EuclideanVectorBatch& sample);
+
+        // Return true once the quantizer can encode, which per-vector mode always can
+        bool isTrained() const { return trained; }
+
+        // Return the number of dimensions of the vectors
+        unsigned getNumDimensions() const { return dimension; }
+
+        // Return the mode
+        QuantizationMode getMode() const { return mode; }
+
+        // Return the quantized form of a vector
+        QuantizedVector encode(ConstEuclideanVectorView) const;
+
+        // Return the quantized form of every vector of a batch, encoded on the thread pool
+        std::vector<QuantizedVector> encode(const EuclideanVectorBatch&) const;
+
+        // Return the vector the codes stand for
+        EuclideanVector decode(const QuantizedVector&) const;
+
+        // Return the dot product of two decoded vectors
+        double dot(const QuantizedVector&, const QuantizedVector&) const;
+
+        // Return the squared euclidean distance between two decoded vectors
+        double squaredDistance(const QuantizedVector&, const QuantizedVector&) const;
+
+        // Return the euclidean distance between two decoded vectors
+        double distance(const QuantizedVector& a, const QuantizedVector& b) const { return std::sqrt(squaredDistance(a, b)); }
+
+    private:
+        unsigned dimension;
+        QuantizationMode mode;
+        bool trained;
+        float sharedScale = 0.0f; // Scale of every vector (per-dimension mode)
+        std::vector<double> centres; // Centre of the range of every dimension (per-dimension mode)
+        double centreSquaredNorm = 0.0; // Sum of centre[j]^2
+    };
+}
+#endif
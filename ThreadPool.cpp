@@ -0,0 +1,118 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+
+using namespace evec;
+
+namespace {
+    // True on the worker threads of any pool
+    thread_local bool insideWorker = false;
+}
+
+// Constructor that takes the total number of threads, including the calling thread
+ThreadPool::ThreadPool(unsigned threads) {
+    for (unsigned i = 1u; i < threads; ++i)
+        workers.emplace_back([this] { work(); });
+}
+
+// Destructor (waits for the workers to finish their current task)
+ThreadPool::~ThreadPool() noexcept {
+    {
+        std::lock_guard<std::mutex> lock {mutex};
+        stopping = true;
+    }
+    available.notify_all();
+    for (auto& w : workers)
+        w.join();
+}
+
+// Return the pool shared by the library, sized to the hardware concurrency or EVEC_THREADS
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool {[] {
+        const char* threads = std::getenv("EVEC_THREADS");
+        int n = threads != nullptr ? std::atoi(threads) : 0;
+        return n > 0 ? static_cast<unsigned>(n) : std::max(std::thread::hardware_concurrency(), 1u);
+    }()};
+    return pool;
+}
+
+// Return the number of chunks parallelFor splits [0, n) into
+std::size_t ThreadPool::chunkCount(std::size_t n, std::size_t grain) const {
+    if (n == 0u)
+        return 0u;
+    if (insideWorker)
+        return 1u;
+    grain = std::max<std::size_t>(grain, 1u);
+    return std::max<std::size_t>(1u, std::min<std::size_t>(size(), n / grain));
+}
+
+void ThreadPool::parallelFor(std::size_t n, std::size_t grain, const std::function<void(std::size_t, std::size_t, std::size_t)>& fn) {
+    std::size_t chunks = chunkCount(n, grain);
+    if (chunks == 0u)
+        return;
+    if (chunks == 1u) {
+        fn(0u, 0u, n);
+        return;
+    }
+
+    // Completion state shared with the queued chunks, which all finish before this function returns
+    std::mutex doneMutex;
+    std::condition_variable doneSignal;
+    std::size_t remaining = chunks - 1u;
+    std::exception_ptr failure;
+
+    auto chunkBegin = [n, chunks] (std::size_t c) { return n / chunks * c + std::min(c, n % chunks); };
+    {
+        std::lock_guard<std::mutex> lock {mutex};
+        for (std::size_t c = 1u; c < chunks; ++c) {
+            std::size_t b = chunkBegin(c), e = chunkBegin(c + 1u);
+            tasks.emplace_back([&, c, b, e] {
+                std::exception_ptr error;
+                try {
+                    fn(c, b, e);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                std::lock_guard<std::mutex> doneLock {doneMutex};
+                if (error)
+                    failure = error;
+                if (--remaining == 0u)
+                    doneSignal.notify_one();
+            });
+        }
+    }
+    available.notify_all();
+
+    // The calling thread runs the first chunk, then waits for the workers
+    std::exception_ptr error;
+    try {
+        fn(0u, 0u, chunkBegin(1u));
+    } catch (...) {
+        error = std::current_exception();
+    }
+    std::unique_lock<std::mutex> doneLock {doneMutex};
+    doneSignal.wait(doneLock, [&remaining] { return remaining == 0u; });
+    if (!error)
+        error = failure;
+    if (error)
+        std::rethrow_exception(error);
+}
+
+// Loop run by every worker thread
+void ThreadPool::work() {
+    insideWorker = true;
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock {mutex};
+            available.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef A2_THREADPOOL_H
+#define A2_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace evec {
+    // Fixed set of worker threads that run the chunks of parallelFor. The calling thread
+    // runs one chunk itself, and a parallelFor issued from a worker runs serially, so
+    // nested parallel code cannot deadlock the pool.
+    class ThreadPool {
+    public:
+        // Constructor that takes the total number of threads, including the calling thread
+        explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency());
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Destructor (waits for the workers to finish their current task)
+        ~ThreadPool() noexcept;
+
+        // Return the pool shared by the library, sized to the hardware concurrency
+        // (the environment variable EVEC_THREADS overrides the size)
+        static ThreadPool& instance();
+
+        // Return the number of threads that run chunks, including the calling thread
+        unsigned size() const { return static_cast<unsigned>(workers.size()) + 1u; }
+
+        // Return the number of chunks parallelFor splits [0, n) into
+        std::size_t chunkCount(std::size_t n, std::size_t grain) const;
+
+        // Call fn(chunk, begin, end) on chunkCount(n, grain) disjoint chunks covering [0, n), each at
+        // least grain long, and return once every chunk has finished. The chunk index lets callers
+        // keep one partial result per chunk.
+        void parallelFor(std::size_t n, std::size_t grain, const std::function<void(std::size_t, std::size_t, std::size_t)>& fn);
+
+    private:
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> tasks; // Chunks waiting for a worker
+        std::mutex mutex; // Guards tasks and stopping
+        std::condition_variable available; // Signalled when a task is queued or the pool stops
+        bool stopping = false;
+
+        // Loop run by every worker thread
+        void work();
+    };
+}
+#endif
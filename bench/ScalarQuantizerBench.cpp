@@ -0,0 +1,114 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "EuclideanVectorKernels.h"
+#include "ScalarQuantizer.h"
+
+using namespace evec;
+
+// Compares int8 scalar quantization with double precision on random vectors: for each mode, the
+// error of the quantized dot products and distances against the exact ones, and the number of
+// dot products and distances per second of both. make bench builds and runs it.
+namespace {
+    const unsigned dimension = 128u;
+    const std::size_t vectorCount = 4000u;
+    const std::size_t queryCount = 100u;
+
+    // Return vectors whose dimensions have different centres and spreads, as embeddings do
+    EuclideanVectorBatch randomBatch(std::size_t count, std::mt19937& random) {
+        std::normal_distribution<double> normal;
+        EuclideanVectorBatch batch {count, dimension};
+        for (std::size_t i = 0u; i < count; ++i)
+            for (unsigned j = 0u; j < dimension; ++j)
+                batch[i][j] = 0.01 * j + (0.5 + 0.01 * (j % 50u)) * normal(random);
+        return batch;
+    }
+
+    // Return the seconds taken by f
+    template <typename F>
+    double seconds(F f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Mean and largest relative error of a series of approximations
+    struct Error {
+        double sum = 0.0, largest = 0.0;
+        std::size_t count = 0u;
+
+        void add(double approximate, double exact, double magnitude) {
+            double e = std::abs(approximate - exact) / magnitude;
+            sum += e;
+            largest = std::max(largest, e);
+            ++count;
+        }
+    };
+
+    void run(QuantizationMode mode, const EuclideanVectorBatch& vectors, const EuclideanVectorBatch& queries) {
+        ScalarQuantizer quantizer {dimension, mode};
+        if (mode == QuantizationMode::PerDimension)
+            quantizer.train(vectors);
+        const std::vector<QuantizedVector> codes = quantizer.encode(vectors);
+        const std::vector<QuantizedVector> queryCodes = quantizer.encode(queries);
+
+        // Dot products are compared to the product of the norms, distances to themselves
+        Error dotError, distanceError;
+        for (std::size_t q = 0u; q < queries.size(); ++q) {
+            const double* query = queries.data() + q * dimension;
+            const double queryNorm = std::sqrt(kernels::sumOfSquares(query, dimension));
+            for (std::size_t i = 0u; i < vectors.size(); ++i) {
+                const double* v = vectors.data() + i * dimension;
+                const double norm = std::sqrt(kernels::sumOfSquares(v, dimension));
+                dotError.add(quantizer.dot(queryCodes[q], codes[i]), kernels::dot(query, v, dimension), queryNorm * norm);
+                const double exact = std::sqrt(kernels::squaredDistance(query, v, dimension));
+                distanceError.add(quantizer.distance(queryCodes[q], codes[i]), exact, exact);
+            }
+        }
+
+        const double pairs = static_cast<double>(queries.size() * vectors.size());
+        double sink = 0.0;
+        const double int8Dot = seconds([&] {
+            for (std::size_t q = 0u; q < queries.size(); ++q)
+                for (std::size_t i = 0u; i < vectors.size(); ++i)
+                    sink += quantizer.dot(queryCodes[q], codes[i]);
+        });
+        const double int8Distance = seconds([&] {
+            for (std::size_t q = 0u; q < queries.size(); ++q)
+                for (std::size_t i = 0u; i < vectors.size(); ++i)
+                    sink += quantizer.squaredDistance(queryCodes[q], codes[i]);
+        });
+        const double doubleDot = seconds([&] {
+            for (std::size_t q = 0u; q < queries.size(); ++q)
+                for (std::size_t i = 0u; i < vectors.size(); ++i)
+                    sink += kernels::dot(queries.data() + q * dimension, vectors.data() + i * dimension, dimension);
+        });
+        const double doubleDistance = seconds([&] {
+            for (std::size_t q = 0u; q < queries.size(); ++q)
+                for (std::size_t i = 0u; i < vectors.size(); ++i)
+                    sink += kernels::squaredDistance(queries.data() + q * dimension, vectors.data() + i * dimension, dimension);
+        });
+
+        std::printf("%-13s %-9s %12.2e %12.2e %14.1f %14.1f\n", mode == QuantizationMode::PerVector ? "per-vector" : "per-dimension",
+                    "dot", dotError.sum / dotError.count, dotError.largest, pairs / int8Dot / 1e6, pairs / doubleDot / 1e6);
+        std::printf("%-13s %-9s %12.2e %12.2e %14.1f %14.1f\n", "", "distance", distanceError.sum / distanceError.count,
+                    distanceError.largest, pairs / int8Distance / 1e6, pairs / doubleDistance / 1e6);
+        if (sink == 0.12345)
+            std::printf("\n");
+    }
+}
+
+int main() {
+    std::mt19937 random {23u};
+    const EuclideanVectorBatch vectors = randomBatch(vectorCount, random);
+    const EuclideanVectorBatch queries = randomBatch(queryCount, random);
+
+    std::printf("%u dimensions, %zu queries x %zu vectors, %s kernels\n\n", dimension, queryCount, vectorCount, kernels::instructionSet());
+    std::printf("%-13s %-9s %12s %12s %14s %14s\n", "mode", "operation", "mean error", "max error", "int8 M/s", "double M/s");
+    run(QuantizationMode::PerVector, vectors, queries);
+    run(QuantizationMode::PerDimension, vectors, queries);
+    return 0;
+}
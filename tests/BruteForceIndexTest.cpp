@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "BruteForceIndex.h"
+#include "Testing.h"
+
+using namespace evec;
+
+namespace {
+    // Return the k nearest vectors by sorting the distances to every one of them
+    std::vector<Neighbor> naiveSearch(const EuclideanVectorBatch& vectors, EuclideanVectorBatch::ConstRow query, std::size_t k) {
+        std::vector<Neighbor> all;
+        for (std::size_t i = 0u; i < vectors.size(); ++i) {
+            double d = 0.0;
+            for (unsigned j = 0u; j < vectors.getNumDimensions(); ++j)
+                d += (vectors[i][j] - query[j]) * (vectors[i][j] - query[j]);
+            all.push_back(Neighbor{i, std::sqrt(d)});
+        }
+        std::sort(all.begin(), all.end());
+        all.resize(std::min(k, all.size()));
+        return all;
+    }
+
+    // Return true if both lists hold the same ids at nearly the same distances
+    bool sameNeighbors(const std::vector<Neighbor>& a, const std::vector<Neighbor>& b) {
+        if (a.size() != b.size())
+            return false;
+        for (std::size_t i = 0u; i < a.size(); ++i)
+            if (a[i].id != b[i].id || !testing::near(a[i].distance, b[i].distance, 1e-9))
+                return false;
+        return true;
+    }
+
+    // Single and batched searches return exactly the neighbours of a sort over every distance
+    void checkExactSearch() {
+        std::mt19937 random {3u};
+        for (unsigned dimension : {1u, 5u, 24u, 130u}) {
+            const EuclideanVectorBatch vectors = testing::randomBatch(1500u, dimension, random);
+            const EuclideanVectorBatch queries = testing::randomBatch(40u, dimension, random);
+            BruteForceIndex index {vectors};
+            EVEC_CHECK(index.size() == vectors.size() && index.getNumDimensions() == dimension);
+
+            const auto batched = index.search(queries, 10u);
+            const auto columnMajor = index.search(queries.toLayout(EuclideanVectorBatch::Layout::ColumnMajor), 10u);
+            bool same = batched.size() == queries.size();
+            for (std::size_t q = 0u; q < queries.size(); ++q) {
+                const std::vector<Neighbor> expected = naiveSearch(vectors, queries[q], 10u);
+                ConstEuclideanVectorView query {queries.data() + q * dimension, dimension};
+                same = same && sameNeighbors(index.search(query, 10u), expected) &&
+                       sameNeighbors(batched[q], expected) && sameNeighbors(columnMajor[q], expected);
+            }
+            EVEC_CHECK(same);
+        }
+
+        // k beyond the size of the index returns every vector, k = 0 none
+        const EuclideanVectorBatch few = testing::randomBatch(3u, 4u, random);
+        BruteForceIndex small {few};
+        ConstEuclideanVectorView query {few.data(), 4u};
+        std::vector<Neighbor> all = small.search(query, 10u);
+        EVEC_CHECK(all.size() == 3u && all[0].id == 0u && all[0].distance == 0.0);
+        EVEC_CHECK(small.search(query, 0u).empty());
+    }
+}
+
+int main() {
+    checkExactSearch();
+    return testing::report("BruteForceIndexTest");
+}
@@ -0,0 +1,153 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "DatasetReader.h"
+#include "EuclideanVectorFile.h"
+#include "Testing.h"
+
+using namespace evec;
+
+namespace {
+    std::string temporaryPath(const std::string& name) {
+        return "/tmp/evec-" + std::to_string(getpid()) + "-" + name;
+    }
+
+    // Write records of the given dimension in a TEXMEX format: a 32-bit dimension, then the magnitudes as E
+    template <typename E>
+    void writeTexmex(const std::string& path, const std::vector<std::vector<E>>& records) {
+        std::ofstream out {path, std::ios::binary};
+        for (const std::vector<E>& r : records) {
+            std::int32_t n = static_cast<std::int32_t>(r.size());
+            out.write(reinterpret_cast<const char*>(&n), sizeof n);
+            out.write(reinterpret_cast<const char*>(r.data()), static_cast<std::streamsize>(r.size() * sizeof(E)));
+        }
+    }
+
+    // Return count records of the given dimension, small whole numbers that every format holds exactly
+    template <typename E>
+    std::vector<std::vector<E>> sample(std::size_t count, unsigned dimension, bool negative) {
+        std::vector<std::vector<E>> records(count, std::vector<E>(dimension));
+        for (std::size_t i = 0u; i < count; ++i)
+            for (unsigned j = 0u; j < dimension; ++j)
+                records[i][j] = static_cast<E>(static_cast<int>((i * 131u + j * 17u) % 251u) - (negative ? 125 : 0));
+        return records;
+    }
+
+    // Read the whole file block by block and return true if it holds exactly the records
+    template <typename E>
+    bool readsBack(const std::string& path, const std::vector<std::vector<E>>& records, std::size_t blockSize) {
+        DatasetReader reader {path, blockSize};
+        EuclideanVectorBatch block {0u, 0u};
+        std::size_t row = 0u;
+        bool same = true;
+        while (reader.next(block)) {
+            same = same && block.size() <= blockSize && block.getNumDimensions() == records[0].size();
+            for (std::size_t i = 0u; i < block.size() && same; ++i, ++row)
+                for (unsigned j = 0u; j < block.getNumDimensions(); ++j)
+                    same = same && row < records.size() && block[i][j] == static_cast<double>(records[row][j]);
+        }
+        return same && row == records.size() && reader.vectorsRead() == records.size();
+    }
+
+    // Return the message of the exception reading the whole file throws, empty if it throws none
+    std::string readError(const std::string& path) {
+        try {
+            DatasetReader reader {path, 100u};
+            EuclideanVectorBatch block {0u, 0u};
+            while (reader.next(block)) {}
+        } catch (const std::runtime_error& e) {
+            return e.what();
+        }
+        return "";
+    }
+
+    // Every format reads back exactly, in blocks of every size and across chunk boundaries
+    void checkFormats() {
+        // About three chunks of .fvecs and .ivecs
+        const auto floats = sample<float>(20000u, 40u, true);
+        const auto bytes = sample<std::uint8_t>(3000u, 128u, false);
+        const auto ints = sample<std::int32_t>(20000u, 40u, true);
+        const std::string fvecs = temporaryPath("data.fvecs"), bvecs = temporaryPath("data.bvecs"), ivecs = temporaryPath("data.ivecs");
+        writeTexmex(fvecs, floats);
+        writeTexmex(bvecs, bytes);
+        writeTexmex(ivecs, ints);
+        for (std::size_t blockSize : {1u, 777u, 100000u}) {
+            EVEC_CHECK(readsBack(fvecs, floats, blockSize));
+            EVEC_CHECK(readsBack(bvecs, bytes, blockSize));
+            EVEC_CHECK(readsBack(ivecs, ints, blockSize));
+        }
+
+        // Delimited text, with a last line that has no newline
+        const std::string csv = temporaryPath("data.csv"), tsv = temporaryPath("data.tsv");
+        EuclideanVectorBatch batch {5000u, 13u};
+        for (std::size_t i = 0u; i < batch.size() * 13u; ++i)
+            batch.data()[i] = static_cast<double>(i % 97u) / 7.0 - 5.0;
+        {
+            std::ofstream out {csv};
+            writeDelimited(out, batch, ',');
+            out << "1,2,3,4,5,6,7,8,9,10,11,12,13";
+        }
+        {
+            std::ofstream out {tsv};
+            writeDelimited(out, batch, '\t');
+        }
+        for (const std::string& path : {csv, tsv}) {
+            DatasetReader reader {path, 999u};
+            EuclideanVector v {1u};
+            std::size_t row = 0u;
+            bool same = true;
+            while (reader.next(v)) {
+                if (row < batch.size())
+                    same = same && v == EuclideanVector{batch[row]};
+                else
+                    same = same && v[12] == 13.0;
+                ++row;
+            }
+            EVEC_CHECK(same && row == batch.size() + (path == csv ? 1u : 0u));
+        }
+        for (const std::string& path : {fvecs, bvecs, ivecs, csv, tsv})
+            std::remove(path.c_str());
+    }
+
+    // Malformed files are reported, corrupt dimensions as soon as the vector's header arrives
+    void checkMalformed() {
+        const std::string path = temporaryPath("bad.fvecs");
+        EVEC_CHECK_THROWS(DatasetReader{temporaryPath("missing.fvecs")}, std::runtime_error);
+        EVEC_CHECK_THROWS(DatasetReader{temporaryPath("data.unknown")}, std::runtime_error);
+
+        // A vector of another dimension, and a file that ends inside a vector
+        auto records = sample<float>(10u, 8u, true);
+        records[6].resize(9u);
+        writeTexmex(path, records);
+        EVEC_CHECK(readError(path).find("dimension 9, expected 8") != std::string::npos);
+        writeTexmex(path, sample<float>(10u, 8u, true));
+        std::ofstream {path, std::ios::binary | std::ios::app}.write("\x08\0\0\0\0\0", 6);
+        EVEC_CHECK(readError(path).find("truncated") != std::string::npos);
+
+        // A corrupt header in a large file, in the middle and at the start, is reported as a
+        // dimension error before the reader waits for the rest of the file
+        records = sample<float>(30000u, 32u, true);
+        writeTexmex(path, records);
+        std::int32_t huge = 1 << 30;
+        std::fstream {path, std::ios::in | std::ios::out | std::ios::binary}.seekp(10 * (4 + 32 * 4)).write(reinterpret_cast<const char*>(&huge), sizeof huge);
+        EVEC_CHECK(readError(path).find("dimension 1073741824, expected 32") != std::string::npos);
+        std::fstream {path, std::ios::in | std::ios::out | std::ios::binary}.write(reinterpret_cast<const char*>(&huge), sizeof huge);
+        EVEC_CHECK(readError(path).find("vector 0 has dimension 1073741824") != std::string::npos);
+        std::int32_t negative = -3;
+        std::fstream {path, std::ios::in | std::ios::out | std::ios::binary}.write(reinterpret_cast<const char*>(&negative), sizeof negative);
+        EVEC_CHECK(readError(path).find("dimension -3") != std::string::npos);
+        std::remove(path.c_str());
+    }
+}
+
+int main() {
+    checkFormats();
+    checkMalformed();
+    return testing::report("DatasetReaderTest");
+}
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "EuclideanVectorBatch.h"
+#include "EuclideanVectorView.h"
+#include "Testing.h"
+
+using namespace evec;
+
+namespace {
+    std::vector<double> sample(unsigned n, double offset) {
+        std::vector<double> v(n);
+        for (unsigned i = 0u; i < n; ++i)
+            v[i] = offset + 0.37 * static_cast<double>(i % 11u) - 1.25 * static_cast<double>(i % 3u);
+        return v;
+    }
+
+    // Plain loops over two arrays of magnitudes
+    double naiveDot(const std::vector<double>& a, const std::vector<double>& b) {
+        double res = 0.0;
+        for (std::size_t i = 0u; i < a.size(); ++i)
+            res += a[i] * b[i];
+        return res;
+    }
+
+    double naiveSquaredDistance(const std::vector<double>& a, const std::vector<double>& b) {
+        double res = 0.0;
+        for (std::size_t i = 0u; i < a.size(); ++i)
+            res += (a[i] - b[i]) * (a[i] - b[i]);
+        return res;
+    }
+
+    double naiveManhattan(const std::vector<double>& a, const std::vector<double>& b) {
+        double res = 0.0;
+        for (std::size_t i = 0u; i < a.size(); ++i)
+            res += std::abs(a[i] - b[i]);
+        return res;
+    }
+
+    double naiveChebyshev(const std::vector<double>& a, const std::vector<double>& b) {
+        double res = 0.0;
+        for (std::size_t i = 0u; i < a.size(); ++i)
+            res = std::max(res, std::abs(a[i] - b[i]));
+        return res;
+    }
+
+    // Return true if every distance and the dot product between x and y match the plain loops over a and b
+    template <typename X, typename Y>
+    bool matches(const X& x, const Y& y, const std::vector<double>& a, const std::vector<double>& b) {
+        return testing::near(x * y, naiveDot(a, b), 1e-12) &&
+               testing::near(squaredDistance(x, y), naiveSquaredDistance(a, b), 1e-12) &&
+               testing::near(distance(x, y), std::sqrt(naiveSquaredDistance(a, b)), 1e-12) &&
+               testing::near(manhattanDistance(x, y), naiveManhattan(a, b), 1e-12) &&
+               chebyshevDistance(x, y) == naiveChebyshev(a, b);
+    }
+
+    // Every kind of operand gives the distances of the plain loops: vectors, views, rows of both
+    // layouts and unevaluated expressions, in every combination with a vector
+    void checkOperands() {
+        for (unsigned n : {1u, 3u, 8u, 17u, 100u, 1001u}) {
+            const std::vector<double> a = sample(n, 0.5), b = sample(n, -2.0);
+            const EuclideanVector x {a.begin(), a.end()}, y {b.begin(), b.end()};
+            const ConstEuclideanVectorView viewX {a}, viewY {b};
+            const EuclideanVectorBatch rows {std::vector<EuclideanVector>{x, y}};
+            const EuclideanVectorBatch columns = rows.toLayout(EuclideanVectorBatch::Layout::ColumnMajor);
+
+            EVEC_CHECK(matches(x, y, a, b));
+            EVEC_CHECK(matches(viewX, viewY, a, b) && matches(viewX, y, a, b));
+            EVEC_CHECK(matches(rows[0], rows[1], a, b) && matches(x, rows[1], a, b) && matches(rows[0], viewY, a, b));
+            EVEC_CHECK(matches(columns[0], columns[1], a, b) && matches(x, columns[1], a, b) && matches(rows[0], columns[1], a, b));
+            EVEC_CHECK(matches(x * 1.0, y + 0.0 * y, a, b) && matches(rows[0], y * 1.0, a, b));
+
+            // Row-major rows take the same kernels as vectors, so the results are identical
+            EVEC_CHECK(rows[0] * rows[1] == x * y && squaredDistance(rows[0], y) == squaredDistance(x, y) &&
+                       manhattanDistance(x, rows[1]) == manhattanDistance(x, y));
+        }
+    }
+
+    // Return the cosine of the angle between two arrays, from separate loops for the dot product and the norms
+    double naiveCosine(const std::vector<double>& a, const std::vector<double>& b) {
+        return naiveDot(a, b) / std::sqrt(naiveDot(a, a) * naiveDot(b, b));
+    }
+
+    // Cosine similarity and angular distance match the plain loops for every kind of operand, and
+    // stay in range for parallel, opposite and zero vectors
+    void checkCosine() {
+        const double pi = 3.14159265358979323846;
+        for (unsigned n : {1u, 2u, 9u, 64u, 1001u}) {
+            const std::vector<double> a = sample(n, 0.5), b = sample(n, -2.0);
+            const EuclideanVector x {a.begin(), a.end()}, y {b.begin(), b.end()};
+            const EuclideanVectorBatch rows {std::vector<EuclideanVector>{x, y}};
+            const EuclideanVectorBatch columns = rows.toLayout(EuclideanVectorBatch::Layout::ColumnMajor);
+            const double expected = naiveCosine(a, b);
+
+            EVEC_CHECK(testing::near(cosineSimilarity(x, y), expected, 1e-12));
+            EVEC_CHECK(testing::near(cosineSimilarity(ConstEuclideanVectorView{a}, ConstEuclideanVectorView{b}), expected, 1e-12));
+            EVEC_CHECK(testing::near(cosineSimilarity(rows[0], rows[1]), expected, 1e-12) &&
+                       testing::near(cosineSimilarity(columns[0], y), expected, 1e-12) &&
+                       testing::near(cosineSimilarity(x * 3.0, y + 0.0 * y), expected, 1e-12));
+            EVEC_CHECK(testing::near(angularDistance(x, rows[1]), std::acos(expected) / pi, 1e-9));
+
+            // Scaled copies point the same or the opposite way, even where rounding pushes the
+            // quotient past one
+            EVEC_CHECK(cosineSimilarity(x, x * 3.0) <= 1.0 && testing::near(cosineSimilarity(x, x * 3.0), 1.0, 1e-12));
+            EVEC_CHECK(cosineSimilarity(x, x * -0.5) >= -1.0 && testing::near(angularDistance(x, x * -0.5), 1.0, 1e-6));
+            EVEC_CHECK(angularDistance(rows[0], rows[0]) >= 0.0 && testing::near(angularDistance(rows[0], rows[0]), 0.0, 1e-6));
+
+            // The zero vector has no direction
+            const EuclideanVector zero (n);
+            EVEC_CHECK(cosineSimilarity(zero, y) == 0.0 && cosineSimilarity(x, zero * 1.0) == 0.0);
+            EVEC_CHECK(testing::near(angularDistance(zero, y), 0.5));
+        }
+
+        // In two dimensions the angle is known
+        EVEC_CHECK(testing::near(angularDistance(EuclideanVector{1.0, 0.0}, EuclideanVector{0.0, 2.0}), 0.5));
+        EVEC_CHECK(testing::near(angularDistance(EuclideanVector{1.0, 1.0}, EuclideanVector{0.0, 2.0}), 0.25));
+    }
+
+    // The EuclideanVector overload fills the norm caches of both operands, and the caches it
+    // reads later give the same cosine as a fresh computation
+    void checkCachedCosine() {
+        const std::vector<double> a = sample(300u, 0.5), b = sample(300u, -2.0);
+        EuclideanVector x {a.begin(), a.end()}, y {b.begin(), b.end()};
+        const double expected = naiveCosine(a, b);
+        EVEC_CHECK(testing::near(cosineSimilarity(x, y), expected, 1e-12));
+        EVEC_CHECK(testing::near(x.getEuclideanNorm(), std::sqrt(naiveDot(a, a)), 1e-12) &&
+                   testing::near(y.getEuclideanNorm(), std::sqrt(naiveDot(b, b)), 1e-12));
+        EVEC_CHECK(testing::near(cosineSimilarity(x, y), expected, 1e-12));
+
+        // A write invalidates the cache of the vector written, not the cosine computed from it
+        x[7] = 40.0;
+        std::vector<double> changed = a;
+        changed[7] = 40.0;
+        EVEC_CHECK(testing::near(cosineSimilarity(x, y), naiveCosine(changed, b), 1e-12));
+        EVEC_CHECK(testing::near(cosineSimilarity(y, x), naiveCosine(changed, b), 1e-12));
+
+        // One cached norm and one not
+        EuclideanVector z {b.begin(), b.end()};
+        EVEC_CHECK(testing::near(cosineSimilarity(x, z), naiveCosine(changed, b), 1e-12));
+
+        // Threads share a query whose norm is cached, each with vectors of its own
+        const double queryNorm = y.getEuclideanNorm();
+        std::vector<EuclideanVector> others;
+        for (unsigned i = 0u; i < 8u; ++i) {
+            const std::vector<double> c = sample(300u, 0.25 * i);
+            others.emplace_back(c.begin(), c.end());
+        }
+        std::vector<double> similarities(others.size());
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0u; t < 4u; ++t) {
+            threads.emplace_back([&, t] {
+                for (std::size_t i = t; i < others.size(); i += 4u)
+                    similarities[i] = cosineSimilarity(y, others[i]);
+            });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+        for (std::size_t i = 0u; i < others.size(); ++i)
+            EVEC_CHECK(testing::near(similarities[i], naiveCosine(b, sample(300u, 0.25 * i)), 1e-12));
+        EVEC_CHECK(y.getEuclideanNorm() == queryNorm);
+
+        // Narrow magnitudes accumulate in float
+        BasicEuclideanVector<float> narrowX {a.begin(), a.end()}, narrowY {b.begin(), b.end()};
+        EVEC_CHECK(testing::near(cosineSimilarity(narrowX, narrowY), expected, 1e-5));
+        EVEC_CHECK(testing::near(cosineSimilarity(narrowX, narrowY), expected, 1e-5));
+    }
+}
+
+int main() {
+    checkOperands();
+    checkCosine();
+    checkCachedCosine();
+    return testing::report("DistanceTest");
+}
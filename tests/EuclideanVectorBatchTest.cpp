@@ -0,0 +1,90 @@
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "EuclideanVectorBatch.h"
+#include "Testing.h"
+
+using namespace evec;
+
+namespace {
+    using Layout = EuclideanVectorBatch::Layout;
+
+    // Return count vectors of the given dimension with a mix of signs
+    std::vector<EuclideanVector> sample(std::size_t count, unsigned dimension) {
+        std::vector<EuclideanVector> vectors;
+        for (std::size_t i = 0u; i < count; ++i) {
+            EuclideanVector v(dimension);
+            for (unsigned j = 0u; j < dimension; ++j)
+                v[j] = static_cast<double>((i * 31u + j * 7u) % 11u) - 5.0 + 0.25 * static_cast<double>(j);
+            vectors.push_back(v);
+        }
+        return vectors;
+    }
+
+    // Every row of the batch holds the magnitudes of the vector with the same index
+    bool holds(const EuclideanVectorBatch& batch, const std::vector<EuclideanVector>& vectors) {
+        if (batch.size() != vectors.size())
+            return false;
+        for (std::size_t i = 0u; i < vectors.size(); ++i)
+            if (EuclideanVector{batch[i]} != vectors[i])
+                return false;
+        return true;
+    }
+
+    void checkBatch() {
+        for (Layout layout : {Layout::RowMajor, Layout::ColumnMajor}) {
+            for (unsigned dimension : {1u, 3u, 16u, 37u}) {
+                const std::vector<EuclideanVector> vectors = sample(29u, dimension);
+                EuclideanVectorBatch batch {vectors, layout};
+                EVEC_CHECK(batch.getLayout() == layout && batch.getNumDimensions() == dimension);
+                EVEC_CHECK(reinterpret_cast<std::uintptr_t>(batch.data()) % EuclideanVectorBatch::alignment == 0u);
+                EVEC_CHECK(holds(batch, vectors));
+                EVEC_CHECK(batch[0].isContiguous() == (layout == Layout::RowMajor));
+
+                // Both layouts hold the same vectors
+                const Layout other = layout == Layout::RowMajor ? Layout::ColumnMajor : Layout::RowMajor;
+                EVEC_CHECK(holds(batch.toLayout(other), vectors));
+
+                // Norms and dot products against EuclideanVector
+                const EuclideanVector& query = vectors[5];
+                std::vector<double> norms = batch.norms(), dots = batch.dot(query);
+                bool same = true;
+                for (std::size_t i = 0u; i < vectors.size(); ++i)
+                    same = same && testing::near(norms[i], vectors[i].getEuclideanNorm()) && testing::near(dots[i], vectors[i] * query);
+                EVEC_CHECK(same);
+
+                // Writes through rows and scaling
+                EuclideanVectorBatch copy {batch};
+                copy[3] = vectors[4] + vectors[6];
+                copy[7] += vectors[7];
+                copy.scale(0.5);
+                EVEC_CHECK(testing::near(EuclideanVector{copy[3]}.getEuclideanNorm(), EuclideanVector{(vectors[4] + vectors[6]) * 0.5}.getEuclideanNorm()));
+                EVEC_CHECK(EuclideanVector{copy[7]} == vectors[7]);
+                EVEC_CHECK(holds(batch, vectors));
+
+                // Moves leave the source empty
+                EuclideanVectorBatch moved {std::move(copy)};
+                EVEC_CHECK(moved.size() == vectors.size() && copy.size() == 0u);
+                copy = moved;
+                EVEC_CHECK(EuclideanVector{copy[7]} == vectors[7]);
+            }
+        }
+        EuclideanVectorBatch zeros {4u, 3u};
+        EVEC_CHECK(EuclideanVector{zeros[3]} == EuclideanVector(3u));
+
+        // Vectors of different dimensions are refused before anything is copied, in either order
+        for (Layout layout : {Layout::RowMajor, Layout::ColumnMajor}) {
+            EVEC_CHECK_THROWS(EuclideanVectorBatch(std::vector<EuclideanVector>{EuclideanVector(2u), EuclideanVector(200u)}, layout),
+                              std::invalid_argument);
+            EVEC_CHECK_THROWS(EuclideanVectorBatch(std::vector<EuclideanVector>{EuclideanVector(200u), EuclideanVector(2u)}, layout),
+                              std::invalid_argument);
+        }
+        EVEC_CHECK(EuclideanVectorBatch{std::vector<EuclideanVector>{}}.size() == 0u);
+    }
+}
+
+int main() {
+    checkBatch();
+    return testing::report("EuclideanVectorBatchTest");
+}
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "EuclideanVectorFile.h"
+#include "Testing.h"
+
+using namespace evec;
+
+namespace {
+    // Return a path in the temporary directory that no other run of the test uses
+    std::string temporaryPath(const std::string& name) {
+        return "/tmp/evec-" + std::to_string(getpid()) + "-" + name;
+    }
+
+    // Return a batch of count vectors with a mix of signs and fractions
+    EuclideanVectorBatch sample(std::size_t count, unsigned dimension) {
+        EuclideanVectorBatch batch {count, dimension};
+        for (std::size_t i = 0u; i < count * dimension; ++i)
+            batch.data()[i] = static_cast<double>(i % 19u) / 7.0 - 1.3 * static_cast<double>(i % 3u);
+        return batch;
+    }
+
+    // Overwrite size bytes of the file at the given offset
+    void patch(const std::string& path, std::streamoff offset, const void* bytes, std::size_t size) {
+        std::fstream file {path, std::ios::in | std::ios::out | std::ios::binary};
+        file.seekp(offset);
+        file.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+    }
+
+    // Batches and single vectors read back from a mapping exactly as written
+    void checkBinaryRoundTrip() {
+        const std::string path = temporaryPath("round-trip.evec");
+        for (std::size_t count : {0u, 1u, 100u}) {
+            for (unsigned dimension : {1u, 7u, 64u}) {
+                const EuclideanVectorBatch batch = sample(count, dimension);
+                writeVectorFile(path, batch);
+                MappedVectorFile file {path};
+                EVEC_CHECK(file.size() == count && file.getNumDimensions() == dimension);
+                EVEC_CHECK(std::equal(batch.data(), batch.data() + count * dimension, file.data()));
+                EVEC_CHECK(reinterpret_cast<std::uintptr_t>(file.data()) % 64u == 0u);
+                if (count > 0u)
+                    EVEC_CHECK(EuclideanVector{file[count - 1u]} == EuclideanVector{batch[count - 1u]});
+
+                // Column-major batches are written row by row
+                writeVectorFile(path, batch.toLayout(EuclideanVectorBatch::Layout::ColumnMajor));
+                MappedVectorFile columns {path};
+                EVEC_CHECK(std::equal(batch.data(), batch.data() + count * dimension, columns.data()));
+            }
+        }
+
+        const EuclideanVector v {1.0, -2.5, 1e-300, 3.0, 4.0, 5.0};
+        writeVectorFile(path, v);
+        MappedVectorFile single {path};
+        EVEC_CHECK(single.size() == 1u && EuclideanVector{single[0]} == v);
+        MappedVectorFile moved {std::move(single)};
+        EVEC_CHECK(moved.size() == 1u && EuclideanVector{moved[0]} == v && single.size() == 0u);
+        std::remove(path.c_str());
+    }
+
+    // Files that are not vector files, or are damaged, are refused
+    void checkMalformedFiles() {
+        const std::string path = temporaryPath("malformed.evec");
+        EVEC_CHECK_THROWS(MappedVectorFile{temporaryPath("missing.evec")}, std::runtime_error);
+
+        { std::ofstream{path} << "not a vector file at all, but long enough to hold a header........................"; }
+        EVEC_CHECK_THROWS(MappedVectorFile{path}, std::runtime_error);
+
+        writeVectorFile(path, sample(10u, 8u));
+        const std::uint32_t version = 99u;
+        patch(path, offsetof(VectorFileHeader, version), &version, sizeof version);
+        EVEC_CHECK_THROWS(MappedVectorFile{path}, std::runtime_error);
+
+        writeVectorFile(path, sample(10u, 8u));
+        const std::uint32_t byteOrder = 0x04030201u;
+        patch(path, offsetof(VectorFileHeader, byteOrder), &byteOrder, sizeof byteOrder);
+        EVEC_CHECK_THROWS(MappedVectorFile{path}, std::runtime_error);
+
+        writeVectorFile(path, sample(10u, 8u));
+        const std::uint64_t count = 11u;
+        patch(path, offsetof(VectorFileHeader, count), &count, sizeof count);
+        EVEC_CHECK_THROWS(MappedVectorFile{path}, std::runtime_error);
+        std::remove(path.c_str());
+    }
+
+    // Delimited text reads back exactly, and malformed lines are refused
+    void checkDelimitedRoundTrip() {
+        for (char delimiter : {',', '\t', ';'}) {
+            EuclideanVectorBatch batch = sample(50u, 9u);
+            batch.data()[3] = 1e-310;
+            batch.data()[4] = -1.7976931348623157e308;
+            batch.data()[5] = 0.1 + 0.2;
+            std::stringstream text;
+            writeDelimited(text, batch, delimiter);
+            EuclideanVectorBatch read = readDelimited(text, delimiter);
+            EVEC_CHECK(read.size() == batch.size() && read.getNumDimensions() == batch.getNumDimensions());
+            EVEC_CHECK(std::equal(batch.data(), batch.data() + batch.size() * 9u, read.data()));
+        }
+
+        std::istringstream spaced {" 1 , 2.5 ,-3e2\n\n  \n4,5,6\n"};
+        EuclideanVectorBatch read = readDelimited(spaced);
+        EVEC_CHECK(read.size() == 2u && read[0][2] == -300.0 && read[1][0] == 4.0);
+
+        std::istringstream notNumber {"1,2,3\n4,five,6\n"}, ragged {"1,2,3\n4,5\n"}, missingField {"1,,3\n"};
+        EVEC_CHECK_THROWS(readDelimited(notNumber), std::runtime_error);
+        EVEC_CHECK_THROWS(readDelimited(ragged), std::runtime_error);
+        EVEC_CHECK_THROWS(readDelimited(missingField), std::runtime_error);
+    }
+
+    // Return the text of %.15g, %.16g or %.17g, whichever is shortest and reads back to m
+    std::string shortestPrintf(double m) {
+        char text[32];
+        for (int precision = 15; precision < 17; ++precision) {
+            std::snprintf(text, sizeof text, "%.*g", precision, m);
+            if (std::strtod(text, nullptr) == m)
+                return text;
+        }
+        std::snprintf(text, sizeof text, "%.17g", m);
+        return text;
+    }
+
+    // Magnitudes are formatted as the shortest printf text that reads back to them, including
+    // roundings that carry into a new digit, ties, subnormals and the ends of the fixed notation
+    void checkShortestMagnitudes() {
+        std::vector<double> magnitudes {0.0, -0.0, 1.0, 0.1, 0.3, 9.5, 1e-4, 1e-5, 9.9999999999999995e-5, 1e15, 1e16,
+                                        1e17, 99999999999999999.0, 999999999999999.9, 1e100, 1e-100,
+                                        std::numeric_limits<double>::max(), std::numeric_limits<double>::min(),
+                                        std::numeric_limits<double>::denorm_min(), 2.2250738585072009e-308};
+        std::mt19937_64 random {3u};
+        std::normal_distribution<double> normal;
+        for (int i = 0; i < 20000; ++i) {
+            const std::uint64_t bits = random();
+            double m;
+            std::memcpy(&m, &bits, sizeof m);
+            if (std::isfinite(m))
+                magnitudes.push_back(m);
+            magnitudes.push_back(normal(random) * std::pow(10.0, static_cast<int>(random() % 40u) - 20));
+            magnitudes.push_back(static_cast<double>(static_cast<int>(random() % 200001u) - 100000) / 1000.0);
+        }
+
+        NumericLocaleScope locale;
+        for (double m : magnitudes) {
+            char text[maxMagnitudeLength];
+            const std::string formatted {text, formatMagnitude(m, text)};
+            EVEC_CHECK(formatted == shortestPrintf(m));
+        }
+        char text[maxMagnitudeLength];
+        EVEC_CHECK(std::string(text, formatMagnitude(-std::numeric_limits<double>::infinity(), text)) == "-inf");
+    }
+
+    // Switch to an installed locale whose decimal point is a comma, returning false if there is none
+    bool useCommaLocale() {
+        for (const char* name : {"de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "fr_FR.utf8", "nl_NL.UTF-8", "ru_RU.UTF-8"})
+            if (std::setlocale(LC_ALL, name) != nullptr && std::string{std::localeconv()->decimal_point} == ",")
+                return true;
+        std::setlocale(LC_ALL, "C");
+        return false;
+    }
+
+    // Text is written and read with a '.' decimal point whatever locale the program set
+    void checkLocaleIndependence() {
+        if (!useCommaLocale()) {
+            std::cout << "EuclideanVectorFileTest: no comma-decimal locale installed, locale checks skipped\n";
+            return;
+        }
+        {
+            NumericLocaleScope locale;
+            char text[maxMagnitudeLength];
+            EVEC_CHECK(std::string(text, formatMagnitude(1.5, text)) == "1.5");
+        }
+        EVEC_CHECK(std::string{std::localeconv()->decimal_point} == ",");
+        double m = 0.0;
+        const std::string half = "0.5";
+        EVEC_CHECK(parseMagnitude(half.data(), half.data() + half.size(), m) == half.data() + half.size() && m == 0.5);
+
+        const EuclideanVectorBatch batch = sample(20u, 4u);
+        std::stringstream delimited;
+        writeDelimited(delimited, batch);
+        EVEC_CHECK(delimited.str().find('.') != std::string::npos);
+        EuclideanVectorBatch read = readDelimited(delimited);
+        EVEC_CHECK(std::equal(batch.data(), batch.data() + batch.size() * 4u, read.data()));
+
+        const EuclideanVector v {1.25, -0.5};
+        std::stringstream printed;
+        printed << v;
+        EVEC_CHECK(printed.str() == "[1.25 -0.5]");
+        EuclideanVector w {1u};
+        printed >> w;
+        EVEC_CHECK(!printed.fail() && w == v);
+        std::setlocale(LC_ALL, "C");
+    }
+}
+
+int main() {
+    checkBinaryRoundTrip();
+    checkMalformedFiles();
+    checkDelimitedRoundTrip();
+    checkShortestMagnitudes();
+    checkLocaleIndependence();
+    return testing::report("EuclideanVectorFileTest");
+}
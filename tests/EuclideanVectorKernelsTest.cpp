@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "EuclideanVectorKernels.h"
+#include "Testing.h"
+
+using namespace evec;
+
+// Every kernel is compared with a plain loop over the same numbers, on lengths around the SIMD
+// widths and on arrays that do not start on a vector boundary. make test runs this program once
+// per value of EVEC_KERNELS, so every instruction set the CPU supports is covered.
+namespace {
+    const std::size_t lengths[] = {0u, 1u, 2u, 3u, 4u, 5u, 7u, 8u, 9u, 15u, 16u, 17u, 31u, 32u, 33u, 63u, 64u, 65u, 100u, 1000u, 4099u};
+
+    // Return n + 1 numbers with a mix of signs and magnitudes; the checks use the last n, which
+    // are misaligned for every vector width
+    std::vector<double> sample(std::size_t n, double seed) {
+        std::vector<double> v(n + 1u);
+        for (std::size_t i = 0u; i < v.size(); ++i)
+            v[i] = seed * static_cast<double>((i * 7u + 3u) % 13u) - 6.0 + 1.0 / static_cast<double>(i + 1u);
+        return v;
+    }
+
+    void checkElementWise() {
+        for (std::size_t n : lengths) {
+            const std::vector<double> a = sample(n, 0.75), b = sample(n, -1.5);
+            std::vector<double> sum = a, difference = a, scaled = a;
+            kernels::add(sum.data() + 1, b.data() + 1, n);
+            kernels::subtract(difference.data() + 1, b.data() + 1, n);
+            kernels::scale(scaled.data() + 1, -2.5, n);
+            bool exact = true;
+            for (std::size_t i = 1u; i <= n; ++i)
+                exact = exact && sum[i] == a[i] + b[i] && difference[i] == a[i] - b[i] && scaled[i] == a[i] * -2.5;
+            EVEC_CHECK(exact);
+            // The element before the range is left alone
+            EVEC_CHECK(sum[0] == a[0] && difference[0] == a[0] && scaled[0] == a[0]);
+        }
+    }
+
+    void checkReductions() {
+        for (std::size_t n : lengths) {
+            const std::vector<double> a = sample(n, 0.75), b = sample(n, -1.5);
+            double dot = 0.0, squares = 0.0, squaredDistance = 0.0, manhattan = 0.0, chebyshev = 0.0;
+            for (std::size_t i = 1u; i <= n; ++i) {
+                dot += a[i] * b[i];
+                squares += a[i] * a[i];
+                squaredDistance += (a[i] - b[i]) * (a[i] - b[i]);
+                manhattan += std::abs(a[i] - b[i]);
+                chebyshev = std::max(chebyshev, std::abs(a[i] - b[i]));
+            }
+            EVEC_CHECK(testing::near(kernels::dot(a.data() + 1, b.data() + 1, n), dot, 1e-12));
+            EVEC_CHECK(testing::near(kernels::sumOfSquares(a.data() + 1, n), squares, 1e-12));
+            EVEC_CHECK(testing::near(kernels::squaredDistance(a.data() + 1, b.data() + 1, n), squaredDistance, 1e-12));
+            EVEC_CHECK(testing::near(kernels::manhattanDistance(a.data() + 1, b.data() + 1, n), manhattan, 1e-12));
+            EVEC_CHECK(kernels::chebyshevDistance(a.data() + 1, b.data() + 1, n) == chebyshev);
+        }
+    }
+    void checkWidening() {
+        for (std::size_t n : lengths) {
+            std::vector<float> floats(n + 1u);
+            std::vector<int> ints(n + 1u);
+            for (std::size_t i = 0u; i <= n; ++i) {
+                ints[i] = static_cast<int>(i * 2654435761u % 2001u) - 1000;
+                floats[i] = static_cast<float>(ints[i]) / 3.0f;
+            }
+            std::vector<double> fromFloats(n + 1u, -1.0), fromInts(n + 1u, -1.0);
+            kernels::widen(floats.data() + 1, fromFloats.data() + 1, n);
+            kernels::widen(ints.data() + 1, fromInts.data() + 1, n);
+            bool exact = fromFloats[0] == -1.0 && fromInts[0] == -1.0;
+            for (std::size_t i = 1u; i <= n; ++i)
+                exact = exact && fromFloats[i] == static_cast<double>(floats[i]) && fromInts[i] == static_cast<double>(ints[i]);
+            EVEC_CHECK(exact);
+        }
+    }
+
+    // dotBlock adds the dot products of every pair of rows to the output, for blocks around the
+    // register tile sizes and rows that start misaligned
+    void checkDotBlock() {
+        for (std::size_t rows : {1u, 3u, 4u, 5u, 9u}) {
+            for (std::size_t columns : {1u, 2u, 4u, 7u, 13u}) {
+                for (std::size_t n : {1u, 3u, 8u, 17u, 100u}) {
+                    const std::size_t stride = n + 3u;
+                    const std::vector<double> a = sample(rows * stride, 0.75), b = sample(columns * stride, -1.5);
+                    const std::size_t outStride = columns + 2u;
+                    std::vector<double> out(rows * outStride, 0.5);
+                    kernels::dotBlock(a.data() + 1, rows, b.data() + 1, columns, n, stride, out.data(), outStride);
+                    bool same = true;
+                    for (std::size_t i = 0u; i < rows; ++i) {
+                        for (std::size_t j = 0u; j < outStride; ++j) {
+                            double expected = 0.5;
+                            for (std::size_t k = 0u; j < columns && k < n; ++k)
+                                expected += a[1u + i * stride + k] * b[1u + j * stride + k];
+                            same = same && testing::near(out[i * outStride + j], expected, 1e-12);
+                        }
+                    }
+                    EVEC_CHECK(same);
+                }
+            }
+        }
+    }
+
+    // int8 reductions are exact, including sums of extreme codes beyond the range of 32 bits
+    void checkInt8() {
+        for (std::size_t n : lengths) {
+            std::vector<std::int8_t> a(n + 1u), b(n + 1u);
+            for (std::size_t i = 0u; i <= n; ++i) {
+                a[i] = static_cast<std::int8_t>(static_cast<int>(i * 2654435761u % 255u) - 127);
+                b[i] = static_cast<std::int8_t>(static_cast<int>(i * 40503u % 255u) - 127);
+            }
+            std::int64_t dot = 0, squares = 0;
+            for (std::size_t i = 1u; i <= n; ++i) {
+                dot += a[i] * b[i];
+                squares += (a[i] - b[i]) * (a[i] - b[i]);
+            }
+            EVEC_CHECK(kernels::dot(a.data() + 1, b.data() + 1, n) == dot);
+            EVEC_CHECK(kernels::squaredDistance(a.data() + 1, b.data() + 1, n) == squares);
+        }
+
+        const std::size_t n = 200000u;
+        const std::vector<std::int8_t> high(n, 127), low(n, -127);
+        EVEC_CHECK(kernels::dot(high.data(), high.data(), n) == std::int64_t{127 * 127} * static_cast<std::int64_t>(n));
+        EVEC_CHECK(kernels::dot(high.data(), low.data(), n) == -std::int64_t{127 * 127} * static_cast<std::int64_t>(n));
+        EVEC_CHECK(kernels::squaredDistance(high.data(), low.data(), n) == std::int64_t{254 * 254} * static_cast<std::int64_t>(n));
+    }
+}
+
+int main() {
+    checkElementWise();
+    checkReductions();
+    checkWidening();
+    checkInt8();
+    checkDotBlock();
+    return testing::report((std::string{"EuclideanVectorKernelsTest ("} + kernels::instructionSet() + ")").c_str());
+}
@@ -0,0 +1,329 @@
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <list>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EuclideanVector.h"
+#include "Testing.h"
+
+using namespace evec;
+
+namespace {
+    // Return n numbers with a mix of signs
+    std::vector<double> sample(unsigned n, double offset = 0.0) {
+        std::vector<double> v(n);
+        for (unsigned i = 0u; i < n; ++i)
+            v[i] = offset + static_cast<double>(i % 5) - 1.5 * static_cast<double>(i % 3);
+        return v;
+    }
+
+    // Copies, moves and assignments on both sides of the inline buffer size keep the magnitudes
+    void checkSmallBuffer() {
+        for (unsigned n = 0u; n <= EuclideanVector::smallBufferSize + 2u; ++n) {
+            for (unsigned m = 0u; m <= EuclideanVector::smallBufferSize + 2u; m += 3u) {
+                std::vector<double> a = sample(n), b = sample(m, 2.0);
+                EuclideanVector x {a.begin(), a.end()};
+                EVEC_CHECK(static_cast<std::vector<double>>(x) == a);
+
+                EuclideanVector copy {x};
+                EVEC_CHECK(static_cast<std::vector<double>>(copy) == a);
+                EuclideanVector moved {std::move(copy)};
+                EVEC_CHECK(static_cast<std::vector<double>>(moved) == a);
+                EVEC_CHECK(copy.getNumDimensions() == 0u);
+
+                EuclideanVector y {b.begin(), b.end()};
+                y = x;
+                EVEC_CHECK(static_cast<std::vector<double>>(y) == a);
+                EuclideanVector z {b.begin(), b.end()};
+                z = std::move(moved);
+                EVEC_CHECK(static_cast<std::vector<double>>(z) == a);
+                z = EuclideanVector{b.begin(), b.end()};
+                EVEC_CHECK(static_cast<std::vector<double>>(z) == b);
+                if (n > 0u) {
+                    x[0] = 42.0;
+                    EVEC_CHECK(y[0] == a[0] && x[0] == 42.0);
+                }
+            }
+        }
+    }
+
+    // Chained arithmetic matches the same arithmetic done one magnitude at a time
+    void checkExpressions() {
+        for (unsigned n : {1u, 3u, 17u, 100u}) {
+            std::vector<double> a = sample(n), b = sample(n, 1.0), c = sample(n, -2.0);
+            const EuclideanVector x {a.begin(), a.end()}, y {b.begin(), b.end()}, z {c.begin(), c.end()};
+            std::vector<double> expected(n);
+            double dot = 0.0;
+            for (unsigned i = 0u; i < n; ++i) {
+                expected[i] = a[i] + b[i] * 2.0 - c[i] / 4.0;
+                dot += (a[i] + b[i]) * (b[i] - c[i]);
+            }
+
+            EuclideanVector r = x + y * 2.0 - z / 4.0;
+            EVEC_CHECK(testing::allNear(static_cast<std::vector<double>>(r), expected));
+            EVEC_CHECK(testing::near((x + y) * (y - z), dot));
+            EVEC_CHECK(testing::near((x + y * 2.0 - z / 4.0).getEuclideanNorm(), r.getEuclideanNorm()));
+            EVEC_CHECK((x + y * 2.0 - z / 4.0) == r);
+
+            // Assigning an expression that reads the target
+            r = r - x - y * 2.0 + z / 4.0;
+            EVEC_CHECK(testing::near(r.getEuclideanNorm(), 0.0));
+
+            // Assigning an expression of another number of dimensions
+            EuclideanVector w {2u, 1.0};
+            w = 3.0 * x;
+            EVEC_CHECK(w.getNumDimensions() == n && testing::near(w[n - 1u], 3.0 * a[n - 1u]));
+        }
+    }
+
+    // Return the norm of a fresh vector with the same magnitudes, which has nothing cached
+    template <typename T>
+    double freshNorm(const BasicEuclideanVector<T>& v) {
+        const std::vector<double> magnitudes = v;
+        return EuclideanVector{magnitudes.begin(), magnitudes.end()}.getEuclideanNorm();
+    }
+
+    // The norm kept up to date by single-magnitude writes and bulk operations matches a fresh computation
+    void checkCachedNorm() {
+        for (unsigned n : {1u, 4u, 9u, 300u}) {
+            std::vector<double> a = sample(n), b = sample(n, 3.0);
+            EuclideanVector v {a.begin(), a.end()};
+            const EuclideanVector w {b.begin(), b.end()};
+            bool same = testing::near(v.getEuclideanNorm(), freshNorm(v));
+            for (unsigned step = 0u; step < 4u * n; ++step) {
+                unsigned i = (step * 13u) % n;
+                switch (step % 4u) {
+                    case 0u: v[i] = static_cast<double>(step % 9u) - 4.0; break;
+                    case 1u: v[i] += 2.5; break;
+                    case 2u: v[i] *= -0.5; break;
+                    default: v[i] = 0.0; break;
+                }
+                same = same && testing::near(v.getEuclideanNorm(), freshNorm(v));
+            }
+            EVEC_CHECK(same);
+
+            v *= -3.0;
+            EVEC_CHECK(testing::near(v.getEuclideanNorm(), freshNorm(v)));
+            v /= 7.0;
+            EVEC_CHECK(testing::near(v.getEuclideanNorm(), freshNorm(v)));
+            v += w;
+            EVEC_CHECK(testing::near(v.getEuclideanNorm(), freshNorm(v)));
+            v -= w;
+            EVEC_CHECK(testing::near(v.getEuclideanNorm(), freshNorm(v)));
+            v = v + w;
+            EVEC_CHECK(testing::near(v.getEuclideanNorm(), freshNorm(v)));
+            EVEC_CHECK(testing::near(v.createUnitVector().getEuclideanNorm(), 1.0));
+        }
+
+        // Cancelling almost the whole sum falls back to a rescan rather than keeping the rounding error
+        EuclideanVector big {1e8, 1.0, 1.0};
+        big.getEuclideanNorm();
+        big[0] = 0.0;
+        EVEC_CHECK(testing::near(big.getEuclideanNorm(), std::sqrt(2.0), 1e-15));
+    }
+
+    // Scaling narrower magnitudes rounds them, so the norm reported afterwards is that of the
+    // magnitudes stored, not the cached norm scaled
+    template <typename T>
+    void checkScaledNorm() {
+        const std::vector<double> a = sample(40u, 0.3);
+        BasicEuclideanVector<T> v {a.begin(), a.end()};
+        bool same = testing::near(v.getEuclideanNorm(), freshNorm(v), 1e-5);
+        for (double k : {3.7, -0.01, 1e-3, 250.0, 0.0}) {
+            v *= k;
+            same = same && testing::near(v.getEuclideanNorm(), freshNorm(v), 1e-5);
+            v = BasicEuclideanVector<T>{a.begin(), a.end()};
+            v.getEuclideanNorm();
+            v /= k == 0.0 ? 9.0 : k;
+            same = same && testing::near(v.getEuclideanNorm(), freshNorm(v), 1e-5);
+        }
+        EVEC_CHECK(same);
+    }
+
+    // Half magnitudes overflow to infinity and flush to zero once scaled far enough
+    void checkScaledHalfNorm() {
+        BasicEuclideanVector<Half> large {100.0, 100.0};
+        EVEC_CHECK(testing::near(large.getEuclideanNorm(), 100.0 * std::sqrt(2.0), 1e-3));
+        large *= 1000.0;
+        EVEC_CHECK(std::isinf(large[0]) && std::isinf(large.getEuclideanNorm()));
+
+        BasicEuclideanVector<Half> small {1.0, 1.0};
+        EVEC_CHECK(testing::near(small.getEuclideanNorm(), std::sqrt(2.0), 1e-3));
+        small *= 1e-8;
+        EVEC_CHECK(small[0] == 0.0 && small.getEuclideanNorm() == 0.0);
+    }
+
+    // Copy-on-write copies share magnitudes until one of them writes, and never see each other's writes
+    void checkCopyOnWrite() {
+        std::vector<double> a = sample(64u);
+        EuclideanVector original {a.begin(), a.end()};
+        original.setCopyOnWrite(true);
+
+        EuclideanVector copy {original};
+        EVEC_CHECK(copy.isCopyOnWrite() && copy.isShared() && original.isShared());
+        EVEC_CHECK(copy.cbegin() == original.cbegin());
+
+        copy[3] = 100.0;
+        EVEC_CHECK(!copy.isShared() && !original.isShared());
+        EVEC_CHECK(original[3] == a[3] && copy[3] == 100.0);
+
+        EuclideanVector assigned {64u, 0.0};
+        assigned.setCopyOnWrite(true);
+        assigned = original;
+        EVEC_CHECK(assigned.cbegin() == original.cbegin());
+        original *= 2.0;
+        EVEC_CHECK(static_cast<std::vector<double>>(assigned) == a);
+        EVEC_CHECK(testing::near(original.getEuclideanNorm(), 2.0 * assigned.getEuclideanNorm()));
+
+        // Turning the mode off takes a private copy of shared magnitudes
+        EuclideanVector third {assigned};
+        third.setCopyOnWrite(false);
+        EVEC_CHECK(!assigned.isShared() && third.cbegin() != assigned.cbegin());
+
+        // Without copy-on-write every copy owns its magnitudes
+        EuclideanVector plain {a.begin(), a.end()};
+        EuclideanVector plainCopy {plain};
+        EVEC_CHECK(!plain.isShared() && plainCopy.cbegin() != plain.cbegin());
+
+        // Copies made and written on several threads at once
+        std::vector<std::thread> threads;
+        std::atomic<bool> intact {true};
+        for (unsigned t = 0u; t < 4u; ++t) {
+            threads.emplace_back([&, t] {
+                for (unsigned i = 0u; i < 500u; ++i) {
+                    EuclideanVector mine {assigned};
+                    if (i % 2u == 0u)
+                        mine[t] = -1.0;
+                    if (mine[t + 4u] != a[t + 4u])
+                        intact = false;
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        EVEC_CHECK(intact && static_cast<std::vector<double>>(assigned) == a && !assigned.isShared());
+    }
+
+    // Return true if v holds exactly the given numbers
+    template <typename Container>
+    bool holds(const EuclideanVector& v, const Container& numbers) {
+        return v.getNumDimensions() == numbers.size() &&
+               std::equal(numbers.begin(), numbers.end(), v.cbegin(), [] (double x, double y) { return x == y; });
+    }
+
+    // Every kind of iterator and range builds a vector holding the same numbers
+    void checkRangeConstructors() {
+        for (unsigned n : {0u, 1u, 5u, 37u}) {
+            std::vector<double> doubles(n);
+            std::vector<float> floats(n);
+            std::vector<int> ints(n);
+            std::vector<short> shorts(n);
+            for (unsigned i = 0u; i < n; ++i) {
+                ints[i] = static_cast<int>(i * 37u % 23u) - 11;
+                shorts[i] = static_cast<short>(ints[i]);
+                floats[i] = static_cast<float>(ints[i]) * 0.25f;
+                doubles[i] = floats[i];
+            }
+            const std::list<double> list {doubles.begin(), doubles.end()};
+            const std::deque<double> deque {doubles.begin(), doubles.end()};
+
+            EVEC_CHECK(holds(EuclideanVector{doubles}, doubles));
+            EVEC_CHECK(holds(EuclideanVector{doubles.begin(), doubles.end()}, doubles));
+            EVEC_CHECK(holds(EuclideanVector{doubles.data(), doubles.data() + n}, doubles));
+            EVEC_CHECK(holds(EuclideanVector{floats}, floats));
+            EVEC_CHECK(holds(EuclideanVector{ints}, ints));
+            EVEC_CHECK(holds(EuclideanVector{shorts.cbegin(), shorts.cend()}, shorts));
+            EVEC_CHECK(holds(EuclideanVector{list}, list));
+            EVEC_CHECK(holds(EuclideanVector{deque.begin(), deque.end()}, deque));
+
+            // Single-pass iterators are buffered first
+            std::ostringstream text;
+            for (int i : ints)
+                text << i << ' ';
+            std::istringstream in {text.str()};
+            EVEC_CHECK(holds(EuclideanVector{std::istream_iterator<int>{in}, std::istream_iterator<int>{}}, ints));
+        }
+        const double array[] {1.5, -2.0, 3.25};
+        const std::array<float, 2> floatArray {{0.5f, -8.0f}};
+        EVEC_CHECK(holds(EuclideanVector{array}, std::vector<double>{1.5, -2.0, 3.25}));
+        EVEC_CHECK(holds(EuclideanVector{floatArray}, floatArray));
+    }
+
+    // Return true if reading text fails and leaves the vector alone
+    bool refuses(const std::string& text) {
+        std::istringstream in {text};
+        EuclideanVector v {7.0, 8.0};
+        in >> v;
+        return in.fail() && v == EuclideanVector{7.0, 8.0};
+    }
+
+    // Printed vectors read back bit for bit, and malformed text is refused
+    void checkTextRoundTrip() {
+        std::vector<double> magnitudes {0.0, -0.0, 1.0, -1.5, 0.1, 1.0 / 3.0, 2.0 / 3.0, 1e-300, 4.9e-324, 1.7976931348623157e308,
+                                        -123456789.125, 6.02214076e23, 9007199254740993.0};
+        // Doubles from every part of the range, built from bit patterns
+        std::uint64_t bits = 0x0123456789abcdefu;
+        for (unsigned i = 0u; i < 2000u; ++i) {
+            bits = bits * 6364136223846793005u + 1442695040888963407u;
+            double m;
+            std::memcpy(&m, &bits, sizeof m);
+            if (std::isfinite(m))
+                magnitudes.push_back(m);
+        }
+        const EuclideanVector v {magnitudes.begin(), magnitudes.end()};
+        std::stringstream text;
+        text << v << ' ' << EuclideanVector{magnitudes.begin(), magnitudes.begin() + 3} << "\n[]";
+        EuclideanVector first {1u}, second {1u}, third {1u};
+        text >> first >> second >> third;
+        EVEC_CHECK(!text.fail());
+        EVEC_CHECK(std::memcmp(first.cbegin(), v.cbegin(), magnitudes.size() * sizeof(double)) == 0);
+        EVEC_CHECK(second == EuclideanVector(magnitudes.begin(), magnitudes.begin() + 3));
+        EVEC_CHECK(third.getNumDimensions() == 0u);
+
+        // Stored floats print as their double value and read back exactly
+        const BasicEuclideanVector<float> f {0.1, -3.4e38, 1e-45, 16777217.0};
+        std::stringstream floatText;
+        floatText << f;
+        BasicEuclideanVector<float> g {1u};
+        floatText >> g;
+        EVEC_CHECK(!floatText.fail() && g == f);
+
+        EVEC_CHECK(refuses(""));
+        EVEC_CHECK(refuses("["));
+        EVEC_CHECK(refuses("[1 2"));
+        EVEC_CHECK(refuses("[1 2 "));
+        EVEC_CHECK(refuses("1 2]"));
+        EVEC_CHECK(refuses("(1 2)"));
+        EVEC_CHECK(refuses("[1 x]"));
+        EVEC_CHECK(refuses("[1,2]"));
+        EVEC_CHECK(refuses("[1 2.5.5]"));
+
+        // Spaces around the magnitudes and before the bracket are fine
+        std::istringstream spaced {"  [  1   -2.5e1  ]"};
+        EuclideanVector w {1u};
+        spaced >> w;
+        EVEC_CHECK(!spaced.fail() && w == EuclideanVector{1.0, -25.0});
+    }
+}
+
+int main() {
+    checkSmallBuffer();
+    checkExpressions();
+    checkCachedNorm();
+    checkScaledNorm<float>();
+    checkScaledNorm<Half>();
+    checkScaledNorm<BFloat16>();
+    checkScaledHalfNorm();
+    checkCopyOnWrite();
+    checkRangeConstructors();
+    checkTextRoundTrip();
+    return testing::report("EuclideanVectorTest");
+}
@@ -0,0 +1,62 @@
+#include <vector>
+
+#include "EuclideanVectorBatch.h"
+#include "EuclideanVectorView.h"
+#include "Testing.h"
+
+using namespace evec;
+
+namespace {
+    std::vector<double> sample(unsigned n, double offset) {
+        std::vector<double> v(n);
+        for (unsigned i = 0u; i < n; ++i)
+            v[i] = offset + static_cast<double>(i % 9u) - 0.5 * static_cast<double>(i % 4u);
+        return v;
+    }
+
+    // Views read and write the buffer they view, and agree with EuclideanVector on the same magnitudes
+    void checkViews() {
+        for (unsigned n : {1u, 5u, 33u, 200u}) {
+            std::vector<double> buffer = sample(n, 1.0);
+            std::vector<double> other = sample(n, -2.0);
+            const EuclideanVector x {buffer.begin(), buffer.end()}, y {other.begin(), other.end()};
+
+            EuclideanVectorView view {buffer};
+            ConstEuclideanVectorView otherView {other}, vectorView {y};
+            EVEC_CHECK(view.data() == buffer.data() && vectorView.data() == y.cbegin());
+            EVEC_CHECK(testing::near(view * otherView, x * y));
+            EVEC_CHECK(testing::near(view.getEuclideanNorm(), x.getEuclideanNorm()));
+            EVEC_CHECK(testing::near(distance(view, vectorView), distance(x, y)));
+            EVEC_CHECK(EuclideanVector{view + otherView} == EuclideanVector{x + y});
+
+            // Writes through the view land in the buffer
+            view += otherView;
+            view -= vectorView;
+            EVEC_CHECK(EuclideanVector{buffer.begin(), buffer.end()} == x);
+            view *= 2.0;
+            view /= 4.0;
+            EVEC_CHECK(testing::allNear(buffer, static_cast<std::vector<double>>(EuclideanVector{x * 0.5})));
+            view.assign(x + y);
+            EVEC_CHECK(EuclideanVector{buffer.begin(), buffer.end()} == EuclideanVector{x + y});
+            view[0] = 7.0;
+            EVEC_CHECK(buffer[0] == 7.0);
+
+            // Operands evaluated one magnitude at a time (a column-major batch row)
+            EuclideanVectorBatch columns {std::vector<EuclideanVector>{x, y}, EuclideanVectorBatch::Layout::ColumnMajor};
+            view.assign(x);
+            view += columns[1];
+            EVEC_CHECK(EuclideanVector{buffer.begin(), buffer.end()} == EuclideanVector{x + y});
+
+            // Assigning a view rebinds it
+            EuclideanVectorView rebound {buffer};
+            std::vector<double> elsewhere(n, 3.0);
+            rebound = EuclideanVectorView{elsewhere};
+            EVEC_CHECK(rebound.data() == elsewhere.data() && buffer[0] == x[0] + y[0]);
+        }
+    }
+}
+
+int main() {
+    checkViews();
+    return testing::report("EuclideanVectorViewTest");
+}
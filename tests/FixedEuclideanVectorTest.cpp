@@ -0,0 +1,68 @@
+#include <sstream>
+#include <stdexcept>
+
+#include "FixedEuclideanVector.h"
+#include "Testing.h"
+
+using namespace evec;
+
+namespace {
+    // Return a FixedEuclideanVector<N> and the same EuclideanVector, filled with a mix of signs
+    template <std::size_t N>
+    FixedEuclideanVector<N> sample(double offset) {
+        FixedEuclideanVector<N> v;
+        for (std::size_t i = 0u; i < N; ++i)
+            v[i] = offset + static_cast<double>(i % 7) - 3.0 * static_cast<double>(i % 2);
+        return v;
+    }
+
+    // Check every operator against the same operation on EuclideanVector
+    template <std::size_t N>
+    void checkAgainstEuclideanVector() {
+        const FixedEuclideanVector<N> a = sample<N>(0.5), b = sample<N>(-1.25);
+        const EuclideanVector x = a, y = b;
+        EVEC_CHECK(x.getNumDimensions() == N);
+        EVEC_CHECK(FixedEuclideanVector<N>{x} == a);
+
+        EVEC_CHECK(static_cast<EuclideanVector>(a + b) == EuclideanVector{x + y});
+        EVEC_CHECK(static_cast<EuclideanVector>(a - b) == EuclideanVector{x - y});
+        EVEC_CHECK(static_cast<EuclideanVector>(a * 2.5) == EuclideanVector{x * 2.5});
+        EVEC_CHECK(static_cast<EuclideanVector>(2.5 * a) == EuclideanVector{2.5 * x});
+        EVEC_CHECK(testing::allNear(static_cast<std::vector<double>>(static_cast<EuclideanVector>(a / 4.0)),
+                                    static_cast<std::vector<double>>(EuclideanVector{x / 4.0})));
+        EVEC_CHECK(testing::near(a * b, x * y));
+        EVEC_CHECK(testing::near(a.getEuclideanNorm(), x.getEuclideanNorm()));
+        EVEC_CHECK(testing::near(a.createUnitVector().getEuclideanNorm(), 1.0));
+
+        FixedEuclideanVector<N> c = a;
+        c += b;
+        c -= a;
+        EVEC_CHECK(c == b);
+        c *= 3.0;
+        c /= 3.0;
+        EVEC_CHECK(testing::near(c.get(N - 1u), b.get(N - 1u)));
+        EVEC_CHECK(c != a);
+
+        std::ostringstream fixed, dynamic;
+        fixed << a;
+        dynamic << x;
+        EVEC_CHECK(fixed.str() == dynamic.str());
+    }
+}
+
+int main() {
+    checkAgainstEuclideanVector<1>();
+    checkAgainstEuclideanVector<3>();
+    checkAgainstEuclideanVector<128>();
+
+    FixedEuclideanVector<3> v {1.0, 2.0};
+    EVEC_CHECK(v[0] == 1.0 && v[1] == 2.0 && v[2] == 0.0);
+    EVEC_CHECK(FixedEuclideanVector<3>(4.0) == (FixedEuclideanVector<3>{4.0, 4.0, 4.0}));
+    EVEC_CHECK(FixedEuclideanVector<3>::getNumDimensions() == 3u);
+
+    // Sources of the wrong size are refused rather than read or written out of bounds
+    EVEC_CHECK_THROWS(FixedEuclideanVector<3>{EuclideanVector(2u)}, std::invalid_argument);
+    EVEC_CHECK_THROWS(FixedEuclideanVector<3>{EuclideanVector(4u)}, std::invalid_argument);
+    EVEC_CHECK_THROWS((FixedEuclideanVector<3>{1.0, 2.0, 3.0, 4.0}), std::invalid_argument);
+    return testing::report("FixedEuclideanVectorTest");
+}
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "BruteForceIndex.h"
+#include "HnswIndex.h"
+#include "Testing.h"
+
+using namespace evec;
+
+namespace {
+    // Return the number of links on layer 0 with no link back. The links of a node are symmetric
+    // until its list fills up and is pruned, so with lists that never fill every such link was lost.
+    std::size_t missingBackLinks(const HnswIndex& index) {
+        std::size_t missing = 0u;
+        for (std::size_t b = 0u; b < index.size(); ++b) {
+            for (std::size_t a : index.getLinks(b)) {
+                std::vector<std::size_t> back = index.getLinks(a);
+                missing += std::find(back.begin(), back.end(), b) == back.end();
+            }
+        }
+        return missing;
+    }
+
+    // Return the most links of a vector on layer 0
+    std::size_t mostLinks(const HnswIndex& index) {
+        std::size_t most = 0u;
+        for (std::size_t i = 0u; i < index.size(); ++i)
+            most = std::max(most, index.getLinks(i).size());
+        return most;
+    }
+
+    // Vectors inserted one at a time are found as well as an exact search finds them
+    void checkRecall() {
+        std::mt19937 random {5u};
+        const EuclideanVectorBatch vectors = testing::randomBatch(3000u, 16u, random);
+        const EuclideanVectorBatch queries = testing::randomBatch(100u, 16u, random);
+        HnswIndex::Parameters parameters;
+        parameters.efConstruction = 100u;
+        HnswIndex index {16u, vectors.size(), parameters};
+        bool ids = true;
+        for (std::size_t i = 0u; i < vectors.size(); ++i)
+            ids = ids && index.add(ConstEuclideanVectorView{vectors.data() + i * 16u, 16u}) == i;
+        EVEC_CHECK(ids && index.size() == vectors.size());
+        EVEC_CHECK_THROWS(index.add(ConstEuclideanVectorView{vectors.data(), 16u}), std::length_error);
+
+        BruteForceIndex exact {vectors};
+        index.setEfSearch(100u);
+        EVEC_CHECK(testing::recall(index.search(queries, 10u), exact.search(queries, 10u), 10u) >= 0.9);
+
+        // A vector of the index is its own nearest neighbour
+        const std::vector<Neighbor> self = index.search(index[1234u], 1u);
+        EVEC_CHECK(self.size() == 1u && self[0].id == 1234u && self[0].distance == 0.0);
+
+        HnswIndex empty {16u, 10u};
+        EVEC_CHECK(empty.search(index[0u], 5u).empty());
+    }
+
+    // Inserts from several threads at once neither lose links nor recall
+    void checkConcurrentInserts() {
+        std::mt19937 random {7u};
+        const unsigned dimension = 2u;
+        const EuclideanVectorBatch vectors = testing::randomBatch(20000u, dimension, random);
+        const EuclideanVectorBatch queries = testing::randomBatch(200u, dimension, random);
+        // Points in the plane have few diverse neighbours, and with m = 40 no list of 80 links fills
+        HnswIndex::Parameters parameters;
+        parameters.m = 40u;
+        parameters.efConstruction = 64u;
+
+        // Through the thread pool
+        HnswIndex pooled {dimension, vectors.size(), parameters};
+        pooled.add(vectors);
+        EVEC_CHECK(mostLinks(pooled) < 2u * parameters.m && missingBackLinks(pooled) == 0u);
+
+        // From threads that each add their own vectors, so the ids are in no particular order
+        HnswIndex threaded {dimension, vectors.size(), parameters};
+        std::vector<std::size_t> ids(vectors.size());
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0u; t < 8u; ++t) {
+            threads.emplace_back([&, t] {
+                for (std::size_t i = t; i < vectors.size(); i += 8u)
+                    ids[i] = threaded.add(ConstEuclideanVectorView{vectors.data() + i * dimension, dimension});
+            });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+        EVEC_CHECK(mostLinks(threaded) < 2u * parameters.m && missingBackLinks(threaded) == 0u);
+        EuclideanVectorBatch byId {vectors.size(), dimension};
+        bool same = threaded.size() == vectors.size();
+        for (std::size_t i = 0u; i < vectors.size(); ++i) {
+            same = same && threaded[ids[i]][0] == vectors[i][0] && threaded[ids[i]][1] == vectors[i][1];
+            byId[ids[i]][0] = vectors[i][0];
+            byId[ids[i]][1] = vectors[i][1];
+        }
+        EVEC_CHECK(same);
+
+        EVEC_CHECK(testing::recall(pooled.search(queries, 10u), BruteForceIndex{vectors}.search(queries, 10u), 10u) >= 0.95);
+        EVEC_CHECK(testing::recall(threaded.search(queries, 10u), BruteForceIndex{byId}.search(queries, 10u), 10u) >= 0.95);
+    }
+}
+
+int main() {
+    setenv("EVEC_THREADS", "8", 0);
+    checkRecall();
+    checkConcurrentInserts();
+    return testing::report("HnswIndexTest");
+}
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "BruteForceIndex.h"
+#include "IvfIndex.h"
+#include "Testing.h"
+
+using namespace evec;
+
+namespace {
+    // Return vectors scattered around a few centres, as indexed data usually is
+    EuclideanVectorBatch clustered(std::size_t count, unsigned dimension, std::mt19937& random) {
+        std::normal_distribution<double> normal;
+        std::vector<double> centres(20u * dimension);
+        for (double& c : centres)
+            c = 4.0 * normal(random);
+        EuclideanVectorBatch batch {count, dimension};
+        for (std::size_t i = 0u; i < count; ++i)
+            for (unsigned j = 0u; j < dimension; ++j)
+                batch[i][j] = centres[(i % 20u) * dimension + j] + normal(random);
+        return batch;
+    }
+
+    // A search that probes a few lists finds most of the exact neighbours, one that probes every
+    // list finds all of them at the same distances
+    void checkRecall() {
+        std::mt19937 random {11u};
+        const unsigned dimension = 12u;
+        const EuclideanVectorBatch vectors = clustered(5000u, dimension, random);
+        const EuclideanVectorBatch queries = clustered(100u, dimension, random);
+        IvfIndex::Parameters parameters;
+        parameters.lists = 64u;
+        parameters.nprobe = 8u;
+        IvfIndex index {dimension, parameters};
+        EVEC_CHECK(!index.isTrained());
+        EVEC_CHECK_THROWS(index.train(EuclideanVectorBatch{63u, dimension}), std::invalid_argument);
+        index.train(vectors);
+        EVEC_CHECK(index.isTrained());
+
+        index.add(EuclideanVectorBatch{0u, dimension});
+        EVEC_CHECK(index.add(ConstEuclideanVectorView{vectors.data(), dimension}) == 0u);
+        EuclideanVectorBatch rest {vectors.size() - 1u, dimension};
+        std::copy_n(vectors.data() + dimension, rest.size() * dimension, rest.data());
+        index.add(rest);
+        std::size_t listed = 0u;
+        for (std::size_t l = 0u; l < parameters.lists; ++l)
+            listed += index.listSize(l);
+        EVEC_CHECK(index.size() == vectors.size() && listed == vectors.size());
+
+        BruteForceIndex exact {vectors};
+        const auto expected = exact.search(queries, 10u);
+        EVEC_CHECK(testing::recall(index.search(queries, 10u), expected, 10u) >= 0.9);
+
+        index.setNprobe(parameters.lists);
+        const auto all = index.search(queries.toLayout(EuclideanVectorBatch::Layout::ColumnMajor), 10u);
+        bool same = testing::recall(all, expected, 10u) == 1.0;
+        for (std::size_t q = 0u; q < queries.size(); ++q) {
+            ConstEuclideanVectorView query {queries.data() + q * dimension, dimension};
+            const std::vector<Neighbor> single = index.search(query, 10u);
+            for (std::size_t i = 0u; i < expected[q].size(); ++i)
+                same = same && testing::near(all[q][i].distance, expected[q][i].distance, 1e-6) &&
+                       single[i].id == all[q][i].id;
+        }
+        EVEC_CHECK(same);
+
+        // Asking for more neighbours than there are vectors returns all of them
+        EVEC_CHECK(index.search(ConstEuclideanVectorView{vectors.data(), dimension}, 6000u).size() == vectors.size());
+    }
+}
+
+int main() {
+    checkRecall();
+    return testing::report("IvfIndexTest");
+}
@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "DatasetReader.h"
+#include "KMeans.h"
+#include "Testing.h"
+
+using namespace evec;
+
+namespace {
+    const unsigned dimension = 5u;
+    const unsigned blobs = 8u;
+
+    // Return vectors scattered tightly around the corners of a cube of side 20, vector i around
+    // corner i % blobs, whose bits give its first three coordinates (repeated in the others)
+    EuclideanVectorBatch blobVectors(std::size_t count, std::mt19937& random) {
+        std::normal_distribution<double> normal {0.0, 0.5};
+        EuclideanVectorBatch batch {count, dimension};
+        for (std::size_t i = 0u; i < count; ++i)
+            for (unsigned j = 0u; j < dimension; ++j)
+                batch[i][j] = 20.0 * static_cast<double>((i % blobs) >> (j % 3u) & 1u) + normal(random);
+        return batch;
+    }
+
+    // Return the cluster nearest to a vector, comparing squared distances one magnitude at a time
+    std::size_t naiveNearest(const KMeans& kmeans, EuclideanVectorBatch::ConstRow v) {
+        std::size_t best = 0u;
+        double bestDistance = std::numeric_limits<double>::infinity();
+        for (std::size_t c = 0u; c < kmeans.getNumClusters(); ++c) {
+            double d = 0.0;
+            for (unsigned j = 0u; j < dimension; ++j)
+                d += (v[j] - kmeans.getCentroids()[c][j]) * (v[j] - kmeans.getCentroids()[c][j]);
+            if (d < bestDistance) {
+                best = c;
+                bestDistance = d;
+            }
+        }
+        return best;
+    }
+
+    // Return true if the clusters split the vectors exactly into their blobs
+    bool recoversBlobs(const KMeans& kmeans, const EuclideanVectorBatch& vectors) {
+        const std::vector<std::size_t> clusters = kmeans.nearest(vectors);
+        std::vector<std::size_t> clusterOfBlob(blobs, kmeans.getNumClusters());
+        std::vector<bool> used(kmeans.getNumClusters(), false);
+        for (std::size_t i = 0u; i < vectors.size(); ++i) {
+            std::size_t& c = clusterOfBlob[i % blobs];
+            if (c == kmeans.getNumClusters()) {
+                if (used[clusters[i]])
+                    return false;
+                c = clusters[i];
+                used[c] = true;
+            }
+            if (clusters[i] != c)
+                return false;
+        }
+        return true;
+    }
+
+    // Every centroid is the mean of the vectors nearest to it, and the nearest cluster of every
+    // vector matches a naive search, one vector at a time and by batch
+    bool converged(const KMeans& kmeans, const EuclideanVectorBatch& vectors) {
+        const std::vector<std::size_t> clusters = kmeans.nearest(vectors.toLayout(EuclideanVectorBatch::Layout::ColumnMajor));
+        std::vector<double> sums(kmeans.getNumClusters() * dimension, 0.0);
+        std::vector<std::size_t> sizes(kmeans.getNumClusters(), 0u);
+        bool same = clusters.size() == vectors.size();
+        for (std::size_t i = 0u; i < vectors.size(); ++i) {
+            same = same && clusters[i] == naiveNearest(kmeans, vectors[i]) &&
+                   kmeans.nearest(ConstEuclideanVectorView{vectors.data() + i * dimension, dimension}) == clusters[i];
+            ++sizes[clusters[i]];
+            for (unsigned j = 0u; j < dimension; ++j)
+                sums[clusters[i] * dimension + j] += vectors[i][j];
+        }
+        for (std::size_t c = 0u; c < kmeans.getNumClusters(); ++c) {
+            double norm = 0.0;
+            for (unsigned j = 0u; j < dimension; ++j) {
+                const double centroid = kmeans.getCentroids()[c][j];
+                norm += centroid * centroid;
+                same = same && (sizes[c] == 0u || testing::near(centroid, sums[c * dimension + j] / static_cast<double>(sizes[c]), 1e-9));
+            }
+            same = same && testing::near(kmeans.getCentroidSquaredNorms()[c], norm, 1e-12);
+        }
+        return same;
+    }
+
+    // Lloyd's algorithm ends on a fixed point with every seeding, and the seedings that spread the
+    // initial centroids find well separated blobs
+    void checkTrain() {
+        std::mt19937 random {47u};
+        const EuclideanVectorBatch vectors = blobVectors(800u, random);
+        for (KMeansSeeding seeding : {KMeansSeeding::Random, KMeansSeeding::PlusPlus, KMeansSeeding::Parallel}) {
+            KMeans::Parameters parameters;
+            parameters.seeding = seeding;
+            parameters.iterations = 100u;
+            KMeans kmeans {blobs, parameters};
+            EVEC_CHECK(!kmeans.isTrained() && kmeans.getNumClusters() == blobs);
+            kmeans.train(vectors);
+            EVEC_CHECK(kmeans.isTrained() && kmeans.getCentroids().size() == blobs && kmeans.getCentroids().getNumDimensions() == dimension);
+            EVEC_CHECK(converged(kmeans, vectors));
+            if (seeding != KMeansSeeding::Random)
+                EVEC_CHECK(recoversBlobs(kmeans, vectors));
+
+            // More clusters than blobs still converge
+            KMeans more {20u, parameters};
+            more.train(vectors);
+            EVEC_CHECK(converged(more, vectors));
+        }
+
+        // The same seed gives the same centroids
+        KMeans first {blobs}, second {blobs};
+        first.train(vectors);
+        second.train(vectors);
+        EVEC_CHECK(std::equal(first.getCentroids().data(), first.getCentroids().data() + blobs * dimension, second.getCentroids().data()));
+
+        KMeans tooMany {blobs};
+        EVEC_CHECK_THROWS(tooMany.train(blobVectors(blobs - 1u, random)), std::invalid_argument);
+        EVEC_CHECK(!tooMany.isTrained());
+    }
+
+    // Mini-batches seed the centroids with the first batch and then move them towards the mean of
+    // every vector assigned so far, from memory or block by block from a file
+    void checkMiniBatch() {
+        std::mt19937 random {53u};
+        const EuclideanVectorBatch vectors = blobVectors(1200u, random);
+
+        KMeans kmeans {blobs};
+        EVEC_CHECK_THROWS(kmeans.partialFit(blobVectors(blobs - 1u, random)), std::invalid_argument);
+        EVEC_CHECK(!kmeans.isTrained());
+        for (std::size_t first = 0u; first < vectors.size(); first += 200u) {
+            EuclideanVectorBatch batch {200u, dimension};
+            std::copy_n(vectors.data() + first * dimension, 200u * dimension, batch.data());
+            kmeans.partialFit(batch);
+        }
+        EVEC_CHECK(recoversBlobs(kmeans, vectors));
+
+        const std::string path = "/tmp/evec-" + std::to_string(getpid()) + "-kmeans.fvecs";
+        {
+            std::ofstream out {path, std::ios::binary};
+            for (std::size_t i = 0u; i < vectors.size(); ++i) {
+                std::int32_t n = dimension;
+                out.write(reinterpret_cast<const char*>(&n), sizeof n);
+                for (unsigned j = 0u; j < dimension; ++j) {
+                    float m = static_cast<float>(vectors[i][j]);
+                    out.write(reinterpret_cast<const char*>(&m), sizeof m);
+                }
+            }
+        }
+        KMeans fromFile {blobs};
+        DatasetReader reader {path, 300u};
+        fromFile.trainMiniBatch(reader);
+        EVEC_CHECK(recoversBlobs(fromFile, vectors));
+
+        DatasetReader smallBlocks {path, blobs - 1u};
+        EVEC_CHECK_THROWS(KMeans{blobs}.trainMiniBatch(smallBlocks), std::invalid_argument);
+        std::remove(path.c_str());
+    }
+}
+
+int main() {
+    checkTrain();
+    checkMiniBatch();
+    return testing::report("KMeansTest");
+}
@@ -0,0 +1,86 @@
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "LinearTransform.h"
+#include "Testing.h"
+
+using namespace evec;
+
+namespace {
+    // Return the row of a transform as a vector
+    EuclideanVector rowOf(const LinearTransform& t, unsigned row) {
+        return EuclideanVector{t.data() + static_cast<std::size_t>(row) * t.getInputDimension(),
+                               t.data() + static_cast<std::size_t>(row + 1u) * t.getInputDimension()};
+    }
+
+    LinearTransform randomTransform(unsigned out, unsigned in, std::mt19937& random) {
+        std::normal_distribution<double> normal;
+        std::vector<double> coefficients(static_cast<std::size_t>(out) * in);
+        for (double& c : coefficients)
+            c = normal(random);
+        return LinearTransform{out, in, coefficients};
+    }
+
+    // Every output magnitude is the dot product of a row of the matrix with the input
+    void checkApply() {
+        std::mt19937 random {41u};
+        for (unsigned out : {1u, 5u, 70u}) {
+            for (unsigned in : {1u, 9u, 300u}) {
+                const LinearTransform t = randomTransform(out, in, random);
+                const EuclideanVectorBatch vectors = testing::randomBatch(130u, in, random);
+
+                const EuclideanVectorBatch transformed = t.apply(vectors);
+                const EuclideanVectorBatch fromColumns = t.apply(vectors.toLayout(EuclideanVectorBatch::Layout::ColumnMajor));
+                EVEC_CHECK(transformed.size() == vectors.size() && transformed.getNumDimensions() == out);
+                bool same = true;
+                EuclideanVector single (in);
+                std::vector<double> intoView(out);
+                for (std::size_t i = 0u; i < vectors.size(); ++i) {
+                    for (unsigned j = 0u; j < in; ++j)
+                        single[j] = vectors[i][j];
+                    const EuclideanVector applied = t.apply(single);
+                    t.apply(ConstEuclideanVectorView{vectors.data() + i * in, in}, EuclideanVectorView{intoView});
+                    for (unsigned r = 0u; r < out; ++r) {
+                        const double expected = rowOf(t, r) * single;
+                        same = same && testing::near(applied[r], expected, 1e-12) && testing::near(intoView[r], expected, 1e-12) &&
+                               testing::near(transformed[i][r], expected, 1e-12) && testing::near(fromColumns[i][r], expected, 1e-12);
+                    }
+                }
+                EVEC_CHECK(same);
+            }
+        }
+    }
+
+    // The identity leaves vectors alone, the transpose swaps rows and columns, and coefficients
+    // that do not fill the matrix are refused
+    void checkConstruction() {
+        std::mt19937 random {43u};
+        const EuclideanVector v {1.5, -2.0, 0.25, 8.0};
+        const LinearTransform identity = LinearTransform::identity(4u);
+        EVEC_CHECK(identity.apply(v) == v);
+
+        const LinearTransform t = randomTransform(3u, 4u, random);
+        const LinearTransform transposed = t.transposed();
+        EVEC_CHECK(transposed.getOutputDimension() == 4u && transposed.getInputDimension() == 3u);
+        bool swapped = true;
+        for (unsigned i = 0u; i < 3u; ++i)
+            for (unsigned j = 0u; j < 4u; ++j)
+                swapped = swapped && transposed(j, i) == t(i, j);
+        EVEC_CHECK(swapped);
+
+        // (Tv).w == v.(T^t w)
+        const EuclideanVector w {2.0, -1.0, 0.5};
+        EVEC_CHECK(testing::near(t.apply(v) * w, v * transposed.apply(w), 1e-12));
+
+        const LinearTransform zero {2u, 3u};
+        EVEC_CHECK(zero.apply(EuclideanVector{1.0, 2.0, 3.0}) == EuclideanVector(2u));
+        EVEC_CHECK_THROWS(LinearTransform(2u, 3u, std::vector<double>(5u)), std::invalid_argument);
+    }
+}
+
+int main() {
+    checkApply();
+    checkConstruction();
+    return testing::report("LinearTransformTest");
+}
@@ -0,0 +1,104 @@
+#include <cstdint>
+#include <vector>
+
+#include "EuclideanVector.h"
+#include "MemoryResource.h"
+#include "Testing.h"
+
+using namespace evec;
+
+namespace {
+    // Resource that counts the storage obtained through it from operator new and operator delete
+    class CountingResource : public MemoryResource {
+    public:
+        void* allocate(std::size_t bytes, std::size_t alignment) override {
+            ++allocations;
+            outstanding += bytes;
+            return newDeleteResource()->allocate(bytes, alignment);
+        }
+
+        void deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+            outstanding -= bytes;
+            newDeleteResource()->deallocate(p, bytes, alignment);
+        }
+
+        std::size_t allocations = 0u;
+        std::size_t outstanding = 0u;
+    };
+
+    bool aligned(const void* p, std::size_t alignment) {
+        return reinterpret_cast<std::uintptr_t>(p) % alignment == 0u;
+    }
+
+    void checkNewDelete() {
+        for (std::size_t alignment : {1u, 8u, 64u, 4096u}) {
+            void* p = newDeleteResource()->allocate(100u, alignment);
+            EVEC_CHECK(aligned(p, alignment));
+            newDeleteResource()->deallocate(p, 100u, alignment);
+        }
+    }
+
+    void checkArena() {
+        CountingResource upstream;
+        {
+            MonotonicArena arena {256u, &upstream};
+            std::size_t requested = 0u;
+            for (std::size_t i = 1u; i < 200u; ++i) {
+                std::size_t alignment = std::size_t{1u} << (i % 7u);
+                void* p = arena.allocate(i, alignment);
+                EVEC_CHECK(aligned(p, alignment));
+                requested += i;
+            }
+            EVEC_CHECK(arena.bytesAllocated() == requested);
+
+            // After a reset the largest block serves the same requests again
+            std::size_t blocks = upstream.allocations;
+            arena.reset();
+            EVEC_CHECK(arena.bytesAllocated() == 0u);
+            for (std::size_t i = 1u; i < 50u; ++i)
+                arena.allocate(i, 8u);
+            EVEC_CHECK(upstream.allocations == blocks);
+        }
+        EVEC_CHECK(upstream.outstanding == 0u);
+    }
+
+    void checkVectors() {
+        CountingResource counting;
+        std::vector<double> magnitudes {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0};
+        {
+            EuclideanVector a {magnitudes.begin(), magnitudes.end(), &counting};
+            EVEC_CHECK(a.getResource() == &counting && counting.allocations == 1u);
+
+            // Copies use the default resource unless given one
+            EuclideanVector b {a};
+            EVEC_CHECK(b.getResource() == getDefaultResource() && b == a);
+            EuclideanVector c {a, &counting};
+            EVEC_CHECK(c.getResource() == &counting && c == a && counting.allocations == 2u);
+
+            // Moving into a vector of another resource copies into that resource
+            b = std::move(c);
+            EVEC_CHECK(b.getResource() == getDefaultResource() && b == a);
+
+            MonotonicArena arena;
+            EuclideanVector d {static_cast<unsigned>(magnitudes.size()), 1.5, &arena};
+            d += a;
+            EVEC_CHECK(d[7] == 9.5 && arena.bytesAllocated() == magnitudes.size() * sizeof(double));
+        }
+        EVEC_CHECK(counting.outstanding == 0u);
+
+        // Vectors built without a resource use the default one
+        MemoryResource* previous = setDefaultResource(&counting);
+        {
+            EuclideanVector e {magnitudes.begin(), magnitudes.end()};
+            EVEC_CHECK(e.getResource() == &counting && counting.allocations == 3u);
+        }
+        EVEC_CHECK(setDefaultResource(previous) == &counting && counting.outstanding == 0u);
+    }
+}
+
+int main() {
+    checkNewDelete();
+    checkArena();
+    checkVectors();
+    return testing::report("MemoryResourceTest");
+}
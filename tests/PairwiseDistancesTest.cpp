@@ -0,0 +1,104 @@
+#include <cmath>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "PairwiseDistances.h"
+#include "Testing.h"
+
+using namespace evec;
+
+namespace {
+    // Return the metric between two rows, one magnitude at a time
+    double naive(EuclideanVectorBatch::ConstRow a, EuclideanVectorBatch::ConstRow b, PairwiseMetric metric) {
+        double dot = 0.0, squared = 0.0;
+        for (unsigned j = 0u; j < a.getNumDimensions(); ++j) {
+            dot += a[j] * b[j];
+            squared += (a[j] - b[j]) * (a[j] - b[j]);
+        }
+        switch (metric) {
+            case PairwiseMetric::Dot: return dot;
+            case PairwiseMetric::SquaredDistance: return squared;
+            default: return std::sqrt(squared);
+        }
+    }
+
+    const PairwiseMetric metrics[] = {PairwiseMetric::Dot, PairwiseMetric::SquaredDistance, PairwiseMetric::Distance};
+
+    // The matrix of two sets matches the naive one for sizes around the tile size and dimensions
+    // beyond the depth block, whatever the layouts of the sets
+    void checkTwoSets() {
+        std::mt19937 random {29u};
+        for (unsigned dimension : {1u, 7u, 300u}) {
+            for (auto layout : {EuclideanVectorBatch::Layout::RowMajor, EuclideanVectorBatch::Layout::ColumnMajor}) {
+                const EuclideanVectorBatch a = testing::randomBatch(150u, dimension, random, 1.0, layout);
+                const EuclideanVectorBatch b = testing::randomBatch(65u, dimension, random, 1.0);
+                for (PairwiseMetric metric : metrics) {
+                    const std::vector<double> matrix = pairwiseMatrix(a, b, metric);
+                    bool same = matrix.size() == a.size() * b.size();
+                    for (std::size_t i = 0u; i < a.size(); ++i)
+                        for (std::size_t j = 0u; j < b.size(); ++j)
+                            same = same && testing::near(matrix[i * b.size() + j], naive(a[i], b[j], metric), 1e-9);
+                    EVEC_CHECK(same);
+                }
+            }
+        }
+
+        EVEC_CHECK(pairwiseMatrix(EuclideanVectorBatch{0u, 3u}, EuclideanVectorBatch{4u, 3u}, PairwiseMetric::Dot).empty());
+    }
+
+    // Every tile of one set lies on or above the diagonal, the tiles cover every pair once, and the
+    // symmetric matrix matches the naive one with zero distances on the diagonal
+    void checkOneSet() {
+        std::mt19937 random {31u};
+        const EuclideanVectorBatch set = testing::randomBatch(200u, 20u, random, 1.0, EuclideanVectorBatch::Layout::ColumnMajor);
+        const std::size_t n = set.size();
+
+        std::mutex mutex;
+        std::vector<int> covered(n * n, 0);
+        bool above = true, values = true;
+        computePairwise(set, PairwiseMetric::SquaredDistance, [&] (const PairwiseTile& tile) {
+            std::lock_guard<std::mutex> lock {mutex};
+            above = above && tile.columnBegin >= tile.rowBegin;
+            for (std::size_t i = tile.rowBegin; i < tile.rowEnd; ++i) {
+                for (std::size_t j = tile.columnBegin; j < tile.columnEnd; ++j) {
+                    if (j > i)
+                        ++covered[i * n + j];
+                    values = values && testing::near(tile(i, j), naive(set[i], set[j], PairwiseMetric::SquaredDistance), 1e-9);
+                }
+            }
+        });
+        bool once = true;
+        for (std::size_t i = 0u; i < n; ++i)
+            for (std::size_t j = i + 1u; j < n; ++j)
+                once = once && covered[i * n + j] == 1;
+        EVEC_CHECK(above && values && once);
+
+        for (PairwiseMetric metric : metrics) {
+            const std::vector<double> matrix = pairwiseMatrix(set, metric);
+            bool same = matrix.size() == n * n;
+            for (std::size_t i = 0u; i < n; ++i) {
+                for (std::size_t j = 0u; j < n; ++j)
+                    same = same && testing::near(matrix[i * n + j], naive(set[i], set[j], metric), 1e-9) && matrix[i * n + j] == matrix[j * n + i];
+                same = same && (metric == PairwiseMetric::Dot || matrix[i * n + i] == 0.0);
+            }
+            EVEC_CHECK(same);
+        }
+    }
+
+    // An exception thrown by the sink stops the computation and reaches the caller
+    void checkSinkException() {
+        std::mt19937 random {37u};
+        const EuclideanVectorBatch set = testing::randomBatch(300u, 4u, random, 1.0);
+        EVEC_CHECK_THROWS(computePairwise(set, set, PairwiseMetric::Dot, [] (const PairwiseTile&) { throw std::runtime_error{"stop"}; }),
+                          std::runtime_error);
+    }
+}
+
+int main() {
+    checkTwoSets();
+    checkOneSet();
+    checkSinkException();
+    return testing::report("PairwiseDistancesTest");
+}
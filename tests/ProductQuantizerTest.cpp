@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "BruteForceIndex.h"
+#include "PqIndex.h"
+#include "Testing.h"
+
+using namespace evec;
+
+namespace {
+    const unsigned dimension = 16u;
+    const unsigned subspaces = 4u;
+
+    // Return the squared distance between a row and a vector, one magnitude at a time
+    double naiveSquaredDistance(EuclideanVectorBatch::ConstRow a, const EuclideanVector& b) {
+        double sum = 0.0;
+        for (unsigned i = 0u; i < dimension; ++i)
+            sum += (a[i] - b[i]) * (a[i] - b[i]);
+        return sum;
+    }
+
+    // Codes refer to the nearest centroid of every subspace, and the distance table gives the
+    // distances to the decoded vectors
+    void checkCodec(const ProductQuantizer& quantizer, const EuclideanVectorBatch& vectors, const EuclideanVectorBatch& queries) {
+        std::vector<std::uint8_t> codes(vectors.size() * subspaces);
+        quantizer.encode(vectors, codes.data());
+        std::vector<std::uint8_t> code(subspaces);
+        bool same = true;
+        for (std::size_t i = 0u; i < vectors.size(); ++i) {
+            quantizer.encode(ConstEuclideanVectorView{vectors.data() + i * dimension, dimension}, code.data());
+            same = same && std::equal(code.begin(), code.end(), codes.begin() + i * subspaces);
+        }
+        EVEC_CHECK(same);
+
+        // The error of a subspace only depends on its own byte, so changing any byte to any other
+        // centroid cannot bring the decoded vector closer
+        bool nearest = true;
+        for (std::size_t i = 0u; i < 20u; ++i) {
+            std::copy_n(codes.begin() + i * subspaces, subspaces, code.begin());
+            const double error = naiveSquaredDistance(vectors[i], quantizer.decode(code.data()));
+            for (unsigned s = 0u; s < subspaces; ++s) {
+                for (unsigned c = 0u; c < ProductQuantizer::codebookSize; ++c) {
+                    code[s] = static_cast<std::uint8_t>(c);
+                    nearest = nearest && naiveSquaredDistance(vectors[i], quantizer.decode(code.data())) >= error * (1.0 - 1e-12);
+                }
+                code[s] = codes[i * subspaces + s];
+            }
+        }
+        EVEC_CHECK(nearest);
+
+        // 256 centroids per 4 dimensions leave a fraction of the variance, 16 per vector
+        double error = 0.0;
+        for (std::size_t i = 0u; i < vectors.size(); ++i)
+            error += naiveSquaredDistance(vectors[i], quantizer.decode(codes.data() + i * subspaces));
+        EVEC_CHECK(error / static_cast<double>(vectors.size()) < 0.5 * dimension);
+
+        std::vector<float> table(subspaces * ProductQuantizer::codebookSize);
+        bool asymmetric = true;
+        for (std::size_t q = 0u; q < queries.size(); ++q) {
+            quantizer.computeDistanceTable(ConstEuclideanVectorView{queries.data() + q * dimension, dimension}, table.data());
+            for (std::size_t i = 0u; i < vectors.size(); i += 7u) {
+                const double expected = naiveSquaredDistance(queries[q], quantizer.decode(codes.data() + i * subspaces));
+                asymmetric = asymmetric && testing::near(quantizer.asymmetricSquaredDistance(table.data(), codes.data() + i * subspaces), expected, 1e-5);
+            }
+        }
+        EVEC_CHECK(asymmetric);
+    }
+
+    // The index ranks its codes by the asymmetric distance, and re-ranking with the original
+    // vectors recovers most of the exact neighbours
+    void checkIndex(const PqIndex& index, const EuclideanVectorBatch& vectors, const EuclideanVectorBatch& queries) {
+        const ProductQuantizer& quantizer = index.getQuantizer();
+        std::vector<std::uint8_t> code(subspaces), stored(subspaces);
+        bool codes = index.size() == vectors.size();
+        for (std::size_t i = 0u; i < vectors.size(); ++i) {
+            quantizer.encode(ConstEuclideanVectorView{vectors.data() + i * dimension, dimension}, code.data());
+            index.getCode(i, stored.data());
+            codes = codes && code == stored;
+        }
+        EVEC_CHECK(codes);
+
+        const auto found = index.search(queries, 10u);
+        const auto exact = BruteForceIndex{vectors}.search(queries, 10u);
+        std::vector<float> table(subspaces * ProductQuantizer::codebookSize);
+        std::vector<float> distances(vectors.size());
+        bool ranked = found.size() == queries.size();
+        std::size_t hits = 0u;
+        for (std::size_t q = 0u; q < queries.size(); ++q) {
+            ConstEuclideanVectorView query {queries.data() + q * dimension, dimension};
+            quantizer.computeDistanceTable(query, table.data());
+            for (std::size_t i = 0u; i < vectors.size(); ++i) {
+                index.getCode(i, code.data());
+                distances[i] = quantizer.asymmetricSquaredDistance(table.data(), code.data());
+            }
+            std::sort(distances.begin(), distances.end());
+            ranked = ranked && found[q].size() == 10u;
+            for (std::size_t i = 0u; i < found[q].size(); ++i)
+                ranked = ranked && testing::near(found[q][i].distance, std::sqrt(distances[i]), 1e-5);
+
+            const std::vector<Neighbor> reranked = index.search(query, 10u, 100u, vectors);
+            ranked = ranked && reranked.size() == 10u && std::is_sorted(reranked.begin(), reranked.end());
+            for (const Neighbor& n : reranked) {
+                ranked = ranked && testing::near(n.distance, distance(query, vectors[n.id]));
+                hits += std::count_if(exact[q].begin(), exact[q].end(), [&] (const Neighbor& e) { return e.id == n.id; });
+            }
+        }
+        EVEC_CHECK(ranked);
+        EVEC_CHECK(hits >= 9u * queries.size());
+    }
+
+    void checkProductQuantization() {
+        std::mt19937 random {13u};
+        const EuclideanVectorBatch vectors = testing::randomBatch(2000u, dimension, random);
+        const EuclideanVectorBatch queries = testing::randomBatch(20u, dimension, random);
+
+        EVEC_CHECK_THROWS(ProductQuantizer(dimension, 0u), std::invalid_argument);
+        EVEC_CHECK_THROWS(ProductQuantizer(dimension, 5u), std::invalid_argument);
+        EVEC_CHECK_THROWS(PqIndex(10u, 4u), std::invalid_argument);
+
+        ProductQuantizer quantizer {dimension, subspaces};
+        EVEC_CHECK(!quantizer.isTrained() && quantizer.getCodeSize() == subspaces);
+        EVEC_CHECK_THROWS(quantizer.train(testing::randomBatch(255u, dimension, random)), std::invalid_argument);
+        quantizer.train(vectors);
+        EVEC_CHECK(quantizer.isTrained());
+        checkCodec(quantizer, vectors, queries);
+
+        // Vectors added one at a time and by batch get consecutive ids across block boundaries
+        PqIndex index {dimension, subspaces};
+        index.train(vectors);
+        for (std::size_t i = 0u; i < 45u; ++i)
+            EVEC_CHECK(index.add(ConstEuclideanVectorView{vectors.data() + i * dimension, dimension}) == i);
+        EuclideanVectorBatch rest {vectors.size() - 45u, dimension};
+        std::copy_n(vectors.data() + 45u * dimension, rest.size() * dimension, rest.data());
+        index.add(rest);
+        checkIndex(index, vectors, queries);
+    }
+}
+
+int main() {
+    checkProductQuantization();
+    return testing::report("ProductQuantizerTest");
+}
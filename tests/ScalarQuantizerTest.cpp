@@ -0,0 +1,104 @@
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "ScalarQuantizer.h"
+#include "Testing.h"
+
+using namespace evec;
+
+namespace {
+    const unsigned dimension = 37u;
+
+    // Return random vectors whose dimensions have different centres and spreads
+    EuclideanVectorBatch spreadBatch(std::size_t count, std::mt19937& random) {
+        EuclideanVectorBatch batch = testing::randomBatch(count, dimension, random);
+        for (std::size_t i = 0u; i < count; ++i)
+            for (unsigned j = 0u; j < dimension; ++j)
+                batch[i][j] = 0.5 * j + (1.0 + j % 3) * batch[i][j];
+        return batch;
+    }
+
+    // Every magnitude decodes to within half a step of the original
+    void checkDecode(const ScalarQuantizer& quantizer, const EuclideanVectorBatch& vectors,
+                     const std::vector<QuantizedVector>& codes) {
+        bool close = codes.size() == vectors.size();
+        for (std::size_t i = 0u; i < vectors.size(); ++i) {
+            const QuantizedVector single = quantizer.encode(ConstEuclideanVectorView{vectors.data() + i * dimension, dimension});
+            close = close && single.codes == codes[i].codes && single.scale == codes[i].scale && single.offset == codes[i].offset;
+
+            const EuclideanVector decoded = quantizer.decode(codes[i]);
+            const double step = codes[i].scale;
+            double squaredNorm = 0.0;
+            for (unsigned j = 0u; j < dimension; ++j) {
+                close = close && std::abs(decoded[j] - vectors[i][j]) <= 0.5 * step * (1.0 + 1e-5) + 1e-6;
+                close = close && codes[i].codes[j] >= -127 && codes[i].codes[j] <= 127;
+                squaredNorm += decoded[j] * decoded[j];
+            }
+            close = close && testing::near(codes[i].squaredNorm, squaredNorm, 1e-12);
+        }
+        EVEC_CHECK(close);
+    }
+
+    // The int8 dot products and distances are those of the decoded vectors, up to the rounding of
+    // the final double arithmetic (relative to the norms, as the expansion of distances loses the rest)
+    void checkOperations(const ScalarQuantizer& quantizer, const std::vector<QuantizedVector>& codes) {
+        bool dots = true, distances = true;
+        for (std::size_t i = 0u; i < codes.size(); ++i) {
+            for (std::size_t k = i; k < codes.size(); k += 3u) {
+                const EuclideanVector a = quantizer.decode(codes[i]), b = quantizer.decode(codes[k]);
+                const double scale = a.getEuclideanNorm() * b.getEuclideanNorm() + 1.0;
+                dots = dots && std::abs(quantizer.dot(codes[i], codes[k]) - a * b) <= 1e-9 * scale;
+                const double expected = squaredDistance(a, b);
+                distances = distances && std::abs(quantizer.squaredDistance(codes[i], codes[k]) - expected) <= 1e-9 * scale &&
+                            std::abs(quantizer.distance(codes[i], codes[k]) - std::sqrt(expected)) <= 1e-4 * std::sqrt(scale);
+            }
+            distances = distances && quantizer.squaredDistance(codes[i], codes[i]) <= 1e-9 * codes[i].squaredNorm;
+        }
+        EVEC_CHECK(dots);
+        EVEC_CHECK(distances);
+    }
+
+    void checkPerVector() {
+        std::mt19937 random {17u};
+        const EuclideanVectorBatch vectors = spreadBatch(120u, random);
+        ScalarQuantizer quantizer {dimension};
+        EVEC_CHECK(quantizer.isTrained() && quantizer.getMode() == QuantizationMode::PerVector);
+        const std::vector<QuantizedVector> codes = quantizer.encode(vectors.toLayout(EuclideanVectorBatch::Layout::ColumnMajor));
+        checkDecode(quantizer, vectors, codes);
+        checkOperations(quantizer, codes);
+
+        // A constant vector has no range and decodes exactly
+        const EuclideanVector constant (dimension, 2.5);
+        const QuantizedVector q = quantizer.encode(constant);
+        EVEC_CHECK(q.scale == 0.0f && quantizer.decode(q) == constant);
+    }
+
+    void checkPerDimension() {
+        std::mt19937 random {19u};
+        const EuclideanVectorBatch vectors = spreadBatch(120u, random);
+        ScalarQuantizer quantizer {dimension, QuantizationMode::PerDimension};
+        EVEC_CHECK(!quantizer.isTrained());
+        EVEC_CHECK_THROWS(quantizer.train(EuclideanVectorBatch{0u, dimension}), std::invalid_argument);
+        quantizer.train(vectors);
+        EVEC_CHECK(quantizer.isTrained());
+        const std::vector<QuantizedVector> codes = quantizer.encode(vectors);
+        checkDecode(quantizer, vectors, codes);
+        checkOperations(quantizer, codes);
+
+        // Magnitudes beyond the trained range are clamped to the extreme codes
+        EuclideanVector far = EuclideanVector(dimension, 1e6);
+        const QuantizedVector q = quantizer.encode(far);
+        bool clamped = true;
+        for (std::int8_t c : q.codes)
+            clamped = clamped && c == 127;
+        EVEC_CHECK(clamped);
+    }
+}
+
+int main() {
+    checkPerVector();
+    checkPerDimension();
+    return testing::report("ScalarQuantizerTest");
+}
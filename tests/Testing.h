@@ -0,0 +1,90 @@
+#ifndef A2_TESTING_H
+#define A2_TESTING_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "EuclideanVectorBatch.h"
+#include "Neighbor.h"
+
+// Minimal checks for the test programs in this directory. A failed check prints where it
+// failed and carries on, and report() turns the count of failures into the exit status.
+// The fixtures the search and quantizer tests share live here too.
+namespace evec {
+    namespace testing {
+        // Return the number of failed checks so far
+        inline int& failures() {
+            static int count = 0;
+            return count;
+        }
+
+        // Record a failed check
+        inline void fail(const char* file, int line, const char* what) {
+            ++failures();
+            std::cerr << file << ':' << line << ": check failed: " << what << '\n';
+        }
+
+        // Return true if a and b differ by at most tolerance, relative to the larger of them
+        // when that is above one
+        inline bool near(double a, double b, double tolerance = 1e-9) {
+            if (std::isinf(a) || std::isinf(b))
+                return a == b;
+            return std::abs(a - b) <= tolerance * std::max({1.0, std::abs(a), std::abs(b)});
+        }
+
+        // Return true if every pair of numbers is near
+        template <typename A, typename B>
+        bool allNear(const A& a, const B& b, double tolerance = 1e-9) {
+            return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [tolerance] (double x, double y) {
+                return near(x, y, tolerance);
+            });
+        }
+
+        // Return count vectors of normally distributed magnitudes around mean, drawn one row at a
+        // time whatever the layout
+        inline EuclideanVectorBatch randomBatch(std::size_t count, unsigned dimension, std::mt19937& random, double mean = 0.0,
+                                                EuclideanVectorBatch::Layout layout = EuclideanVectorBatch::Layout::RowMajor) {
+            std::normal_distribution<double> normal;
+            EuclideanVectorBatch batch {count, dimension, layout};
+            for (std::size_t i = 0u; i < count; ++i)
+                for (unsigned j = 0u; j < dimension; ++j)
+                    batch[i][j] = mean + normal(random);
+            return batch;
+        }
+
+        // Return the fraction of the exact k nearest neighbours of every query that were found
+        inline double recall(const std::vector<std::vector<Neighbor>>& found, const std::vector<std::vector<Neighbor>>& expected,
+                             std::size_t k) {
+            std::size_t hits = 0u;
+            for (std::size_t q = 0u; q < expected.size(); ++q)
+                for (const Neighbor& e : expected[q])
+                    for (const Neighbor& f : found[q])
+                        hits += f.id == e.id;
+            return static_cast<double>(hits) / static_cast<double>(expected.size() * k);
+        }
+
+        // Print the outcome of the test program and return its exit status
+        inline int report(const char* name) {
+            std::cout << name << ": " << (failures() == 0 ? "passed" : "FAILED") << '\n';
+            return failures() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+}
+
+// Check that a condition holds (variadic so conditions can hold braced initialisers)
+#define EVEC_CHECK(...) \
+    do { if (!(__VA_ARGS__)) evec::testing::fail(__FILE__, __LINE__, #__VA_ARGS__); } while (false)
+
+// Check that evaluating an expression throws the given exception type
+#define EVEC_CHECK_THROWS(expression, Exception) \
+    do { \
+        bool thrown = false; \
+        try { expression; } catch (const Exception&) { thrown = true; } \
+        if (!thrown) evec::testing::fail(__FILE__, __LINE__, #expression " throws " #Exception); \
+    } while (false)
+#endif
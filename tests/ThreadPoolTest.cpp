@@ -0,0 +1,88 @@
+#include <atomic>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include "EuclideanVectorKernels.h"
+#include "ThreadPool.h"
+#include "Testing.h"
+
+using namespace evec;
+
+namespace {
+    // Every index is visited exactly once, by a chunk whose index is below chunkCount
+    void checkCoverage() {
+        for (unsigned threads : {1u, 3u, 8u}) {
+            ThreadPool pool {threads};
+            EVEC_CHECK(pool.size() == threads);
+            for (std::size_t n : {0u, 1u, 7u, 100u, 10007u}) {
+                for (std::size_t grain : {1u, 16u, 5000u}) {
+                    std::vector<std::atomic<int>> visits(n);
+                    for (auto& v : visits)
+                        v = 0;
+                    const std::size_t chunks = pool.chunkCount(n, grain);
+                    std::atomic<bool> inRange {true};
+                    pool.parallelFor(n, grain, [&] (std::size_t chunk, std::size_t begin, std::size_t end) {
+                        if (chunk >= chunks || begin > end || end > n)
+                            inRange = false;
+                        for (std::size_t i = begin; i < end; ++i)
+                            ++visits[i];
+                    });
+                    EVEC_CHECK(inRange);
+                    EVEC_CHECK(chunks <= threads && (n == 0u) == (chunks == 0u));
+                    bool once = true;
+                    for (auto& v : visits)
+                        once = once && v == 1;
+                    EVEC_CHECK(once);
+                }
+            }
+        }
+    }
+
+    // An exception thrown by any chunk reaches the caller, and the pool keeps working
+    void checkExceptions() {
+        ThreadPool pool {4u};
+        EVEC_CHECK_THROWS(pool.parallelFor(400u, 1u, [] (std::size_t chunk, std::size_t, std::size_t) {
+            if (chunk == 2u)
+                throw std::runtime_error{"chunk failed"};
+        }), std::runtime_error);
+        std::atomic<std::size_t> total {0u};
+        pool.parallelFor(400u, 1u, [&] (std::size_t, std::size_t begin, std::size_t end) { total += end - begin; });
+        EVEC_CHECK(total == 400u);
+    }
+
+    // A parallelFor issued from a chunk runs serially instead of waiting on the busy pool
+    void checkNesting() {
+        ThreadPool pool {3u};
+        std::atomic<std::size_t> total {0u};
+        pool.parallelFor(30u, 1u, [&] (std::size_t, std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i)
+                pool.parallelFor(100u, 1u, [&] (std::size_t, std::size_t b, std::size_t e) { total += e - b; });
+        });
+        EVEC_CHECK(total == 3000u);
+    }
+
+    // Reductions long enough to be split match the serial kernels
+    void checkParallelReductions() {
+        const std::size_t n = 3u * EVEC_PARALLEL_THRESHOLD + 5u;
+        std::vector<double> a(n), b(n);
+        for (std::size_t i = 0u; i < n; ++i) {
+            a[i] = static_cast<double>(i % 17u) - 8.0;
+            b[i] = static_cast<double>(i % 5u) * 0.5 - 1.0;
+        }
+        EVEC_CHECK(testing::near(kernels::parallelDot(a.data(), b.data(), n), kernels::dot(a.data(), b.data(), n), 1e-12));
+        EVEC_CHECK(testing::near(kernels::parallelSumOfSquares(a.data(), n), kernels::sumOfSquares(a.data(), n), 1e-12));
+        // Combining the slices in order makes the result the same on every call
+        EVEC_CHECK(kernels::parallelDot(a.data(), b.data(), n) == kernels::parallelDot(a.data(), b.data(), n));
+    }
+}
+
+int main() {
+    // The shared pool is sized on first use, give it several threads even on one core
+    setenv("EVEC_THREADS", "4", 0);
+    checkCoverage();
+    checkExceptions();
+    checkNesting();
+    checkParallelReductions();
+    return testing::report("ThreadPoolTest");
+}